@@ -0,0 +1,392 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// BannerGrabber:
+// Reads what open services say about themselves, concurrently with the sweep that finds them.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "BannerGrabber.h"
+#include <algorithm>
+#include <cctype>
+#ifdef _WIN32
+#include <WinSock2.h>
+#pragma comment(lib, "ws2_32")
+#include <ws2tcpip.h>
+#else
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#endif
+
+#ifdef _WIN32
+constexpr int READ_PENDING = WSAEWOULDBLOCK;
+constexpr int CONNECT_PENDING = WSAEWOULDBLOCK;
+constexpr int SEND_FLAGS = 0;
+#else
+constexpr int READ_PENDING = EAGAIN;
+constexpr int CONNECT_PENDING = EINPROGRESS;
+// a service that hangs up before the probe is written must not take the scanner down with SIGPIPE
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#endif
+
+static int lastSocketError()
+{
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+static void closeBannerSocket(SOCKET bannerSocket)
+{
+#ifdef _WIN32
+    closesocket(bannerSocket);
+#else
+    close(bannerSocket);
+#endif
+}
+
+BannerGrabber::~BannerGrabber()
+{
+    this->finish(false);
+}
+
+/// <summary>
+/// Start the pool thread, sockets can be handed over from then until finish.
+/// </summary>
+void BannerGrabber::start()
+{
+    if (this->poolThread.joinable())
+    {
+        return;
+    }
+    this->stopRequested = false;
+    this->dropRequested = false;
+    // compiled on first use, better now than with the first banner
+    getSignatureDatabase();
+    this->poolThread = std::thread(&BannerGrabber::readBanners, this);
+}
+
+/// <summary>
+/// Stop the pool once the sweep is over. Nothing may be handed over after this is called.
+/// </summary>
+/// <param name="waitForReads">let the reads still going run to their deadlines, otherwise they are dropped</param>
+void BannerGrabber::finish(bool waitForReads)
+{
+    if (!this->poolThread.joinable())
+    {
+        return;
+    }
+    this->dropRequested = !waitForReads;
+    this->stopRequested = true;
+    this->poolThread.join();
+}
+
+bool BannerGrabber::isStarted() const
+{
+    return this->poolThread.joinable();
+}
+
+/// <summary>
+/// Take over a socket the sweep has already connected. Safe to call from any worker.
+/// The socket is closed here when the pool is full, the port is then reported without a banner.
+/// </summary>
+void BannerGrabber::addSocket(uint32_t hostIndex, uint16_t portNumber, SOCKET openSocket)
+{
+    if (this->heldSockets.fetch_add(1, std::memory_order_relaxed) >= BANNER_MAX_SOCKETS)
+    {
+        this->heldSockets.fetch_sub(1, std::memory_order_relaxed);
+        closeBannerSocket(openSocket);
+        return;
+    }
+    std::lock_guard<std::mutex> pendingGuard(this->pendingLock);
+    this->pendingReads.push_back({ openSocket, hostIndex, portNumber, ReadState::Waiting, {}, {} });
+}
+
+/// <summary>
+/// Connect to an open port the sweep found without holding a socket for it, as with SYN scans. Safe to call from any thread.
+/// </summary>
+/// <param name="packedAddr">host order IPv4 address</param>
+void BannerGrabber::addTarget(uint32_t hostIndex, uint32_t packedAddr, uint16_t portNumber)
+{
+    if (this->heldSockets.fetch_add(1, std::memory_order_relaxed) >= BANNER_MAX_SOCKETS)
+    {
+        this->heldSockets.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+    SOCKET connectSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (connectSocket == NO_SOCKET)
+    {
+        this->heldSockets.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(connectSocket, FIONBIO, &nonBlocking);
+#else
+    fcntl(connectSocket, F_SETFL, fcntl(connectSocket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    // reset rather than linger, the same as the probes
+    struct linger l;
+    l.l_onoff = 1;
+    l.l_linger = 0;
+    setsockopt(connectSocket, SOL_SOCKET, SO_LINGER, (const char*)&l, sizeof(l));
+
+    sockaddr_in targetAddr{};
+    targetAddr.sin_family = AF_INET;
+    targetAddr.sin_port = htons(portNumber);
+    targetAddr.sin_addr.s_addr = htonl(packedAddr);
+    ReadState readState = ReadState::Connecting;
+    if (connect(connectSocket, (const sockaddr*)&targetAddr, sizeof(targetAddr)) == 0)
+    {
+        readState = ReadState::Waiting;
+    }
+    else if (lastSocketError() != CONNECT_PENDING)
+    {
+        this->heldSockets.fetch_sub(1, std::memory_order_relaxed);
+        closeBannerSocket(connectSocket);
+        return;
+    }
+    std::lock_guard<std::mutex> pendingGuard(this->pendingLock);
+    this->pendingReads.push_back({ connectSocket, hostIndex, portNumber, readState, {}, {} });
+}
+
+/// <summary>
+/// Everything identified so far, only complete once finish has returned.
+/// </summary>
+std::vector<BannerResult> BannerGrabber::takeResults()
+{
+    std::lock_guard<std::mutex> resultGuard(this->resultLock);
+    return std::move(this->bannerResults);
+}
+
+/// <summary>
+/// Set a newly picked up read's deadline, and for services known to wait on the client send the probe straight away.
+/// </summary>
+/// <returns>false when the read is already over</returns>
+bool BannerGrabber::startRead(BannerRead& bannerRead)
+{
+    bool sendFirst = false;
+    if (bannerRead.readState == ReadState::Connecting)
+    {
+        bannerRead.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(BANNER_CONNECT_TIMEOUT);
+    }
+    else if (getSignatureDatabase().findProbe(bannerRead.portNumber, sendFirst) != nullptr && sendFirst)
+    {
+        return this->sendProbe(bannerRead);
+    }
+    else
+    {
+        bannerRead.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(BANNER_WAIT_TIME);
+    }
+    return true;
+}
+
+/// <summary>
+/// The service had nothing to say by itself, so ask it something. Which probe comes from the signature database.
+/// </summary>
+/// <returns>false when there is no probe for the port, so nothing more to wait for</returns>
+bool BannerGrabber::sendProbe(BannerRead& bannerRead)
+{
+    bool sendFirst = false;
+    const ServiceProbe* serviceProbe = getSignatureDatabase().findProbe(bannerRead.portNumber, sendFirst);
+    if (serviceProbe == nullptr)
+    {
+        return false;
+    }
+    // a fresh connection's send buffer always has room for a probe
+    send(bannerRead.readSocket, serviceProbe->probeData.data(), (int)serviceProbe->probeData.size(), SEND_FLAGS);
+    bannerRead.readState = ReadState::Probing;
+    bannerRead.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(BANNER_PROBE_TIMEOUT);
+    return true;
+}
+
+/// <summary>
+/// Read whatever has arrived onto the end of the response.
+/// </summary>
+/// <returns>true once the read is done, the service hung up, the buffer is full or a whole answer is in</returns>
+bool BannerGrabber::receiveResponse(BannerRead& bannerRead)
+{
+    char readBuffer[BANNER_MAX_READ];
+    while (bannerRead.serviceResponse.size() < BANNER_MAX_READ)
+    {
+        int readLength = recv(bannerRead.readSocket, readBuffer, (int)(BANNER_MAX_READ - bannerRead.serviceResponse.size()), 0);
+        if (readLength <= 0)
+        {
+            return readLength == 0 || lastSocketError() != READ_PENDING;
+        }
+        bannerRead.serviceResponse.append(readBuffer, readLength);
+    }
+    if (bannerRead.serviceResponse.size() >= BANNER_MAX_READ)
+    {
+        return true;
+    }
+    // HTTP puts the server name in the headers, everything else says enough on its first line
+    std::string_view serviceResponse = bannerRead.serviceResponse;
+    if (serviceResponse.starts_with("HTTP/"))
+    {
+        return serviceResponse.find("\r\n\r\n") != std::string_view::npos;
+    }
+    return serviceResponse.find('\n') != std::string_view::npos || (!serviceResponse.empty() && !std::isprint((unsigned char)serviceResponse[0]));
+}
+
+/// <summary>
+/// Close a read and keep whatever it identified.
+/// </summary>
+void BannerGrabber::finishRead(BannerRead& bannerRead)
+{
+    closeBannerSocket(bannerRead.readSocket);
+    this->heldSockets.fetch_sub(1, std::memory_order_relaxed);
+    if (bannerRead.serviceResponse.empty())
+    {
+        return;
+    }
+    ServiceMatch serviceMatch = getSignatureDatabase().matchResponse(bannerRead.portNumber, bannerRead.serviceResponse);
+    if (serviceMatch.serviceName.empty() && serviceMatch.serviceVersion.empty())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> resultGuard(this->resultLock);
+    this->bannerResults.push_back({ bannerRead.hostIndex, std::move(serviceMatch) });
+}
+
+/// <summary>
+/// Pool thread. Picks up handed over sockets, waits on all of them at once and moves each one on as it
+/// connects, answers or runs out of time. Runs for the length of the sweep plus one last round of deadlines.
+/// </summary>
+void BannerGrabber::readBanners()
+{
+    std::vector<pollfd> pollSet;
+    std::vector<BannerRead> newReads;
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> pendingGuard(this->pendingLock);
+            newReads.swap(this->pendingReads);
+        }
+        for (BannerRead& bannerRead : newReads)
+        {
+            if (!this->startRead(bannerRead))
+            {
+                this->finishRead(bannerRead);
+                continue;
+            }
+            this->activeReads.push_back(std::move(bannerRead));
+        }
+        newReads.clear();
+
+        bool stopRequested = this->stopRequested.load();
+        if (stopRequested && (this->activeReads.empty() || this->dropRequested.load()))
+        {
+            // the workers have all stopped, so nothing can be added behind this last pick up
+            std::lock_guard<std::mutex> pendingGuard(this->pendingLock);
+            if (this->pendingReads.empty())
+            {
+                break;
+            }
+            continue;
+        }
+
+        pollSet.clear();
+        for (BannerRead& bannerRead : this->activeReads)
+        {
+            pollSet.push_back({ bannerRead.readSocket, (short)(bannerRead.readState == ReadState::Connecting ? POLLWRNORM : POLLRDNORM), 0 });
+        }
+        if (pollSet.empty())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(BANNER_POLL_INTERVAL));
+            continue;
+        }
+#ifdef _WIN32
+        int readyCount = WSAPoll(pollSet.data(), (ULONG)pollSet.size(), BANNER_POLL_INTERVAL);
+#else
+        int readyCount = poll(pollSet.data(), pollSet.size(), BANNER_POLL_INTERVAL);
+#endif
+
+        // walk backwards as finishing a read moves the last one into its place
+        auto timeNow = std::chrono::steady_clock::now();
+        for (size_t i = this->activeReads.size(); i > 0; i--)
+        {
+            BannerRead& bannerRead = this->activeReads[i - 1];
+            short readyEvents = readyCount > 0 ? pollSet[i - 1].revents : 0;
+            bool readDone = false;
+            if (bannerRead.readState == ReadState::Connecting)
+            {
+                if (readyEvents != 0)
+                {
+                    int socketError = 0;
+#ifdef _WIN32
+                    int errorLen = sizeof(socketError);
+#else
+                    socklen_t errorLen = sizeof(socketError);
+#endif
+                    getsockopt(bannerRead.readSocket, SOL_SOCKET, SO_ERROR, (char*)&socketError, &errorLen);
+                    if (socketError != 0 || (readyEvents & (POLLERR | POLLHUP)))
+                    {
+                        readDone = true;
+                    }
+                    else
+                    {
+                        bannerRead.readState = ReadState::Waiting;
+                        readDone = !this->startRead(bannerRead);
+                    }
+                }
+                else
+                {
+                    readDone = timeNow >= bannerRead.deadline;
+                }
+            }
+            else if (readyEvents != 0)
+            {
+                readDone = this->receiveResponse(bannerRead);
+            }
+            else if (timeNow >= bannerRead.deadline)
+            {
+                // a partial answer is better than none, silence gets a probe if it hasn't had one yet
+                if (bannerRead.readState == ReadState::Waiting && bannerRead.serviceResponse.empty())
+                {
+                    readDone = !this->sendProbe(bannerRead);
+                }
+                else
+                {
+                    readDone = true;
+                }
+            }
+            if (readDone || this->dropRequested.load(std::memory_order_relaxed))
+            {
+                this->finishRead(bannerRead);
+                if (i < this->activeReads.size())
+                {
+                    bannerRead = std::move(this->activeReads.back());
+                }
+                this->activeReads.pop_back();
+            }
+        }
+    }
+    // only left behind when the reads were dropped
+    for (BannerRead& bannerRead : this->activeReads)
+    {
+        this->finishRead(bannerRead);
+    }
+    this->activeReads.clear();
+}
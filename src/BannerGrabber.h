@@ -0,0 +1,97 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// BannerGrabber:
+// Reads what open services say about themselves, concurrently with the sweep that finds them. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include "ProbeEngine.h"
+#include "SignatureDatabase.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// ms to wait for a service that speaks first before a probe is sent instead
+constexpr int BANNER_WAIT_TIME = 2000;
+// ms to wait for an answer once a probe has been sent
+constexpr int BANNER_PROBE_TIMEOUT = 2000;
+// ms allowed for the grabber's own connects, made when the sweep couldn't hand over a socket
+constexpr int BANNER_CONNECT_TIMEOUT = 1000;
+// most bytes kept from any one service, enough for a greeting line or a set of HTTP headers
+constexpr size_t BANNER_MAX_READ = 2048;
+// sockets held at once, open ports found past this are left unidentified
+constexpr size_t BANNER_MAX_SOCKETS = 1024;
+// upper bound in ms for a single wait on the pool
+constexpr int BANNER_POLL_INTERVAL = 50;
+
+struct BannerResult
+{
+	uint32_t hostIndex;
+	ServiceMatch serviceMatch;
+};
+
+class BannerGrabber
+{
+public:
+	BannerGrabber() = default;
+	~BannerGrabber();
+	BannerGrabber(const BannerGrabber&) = delete;
+	BannerGrabber& operator=(const BannerGrabber&) = delete;
+public:
+	void start();
+	void finish(bool waitForReads);
+	bool isStarted() const;
+	void addSocket(uint32_t hostIndex, uint16_t portNumber, SOCKET openSocket);
+	void addTarget(uint32_t hostIndex, uint32_t packedAddr, uint16_t portNumber);
+	std::vector<BannerResult> takeResults();
+private:
+	enum class ReadState : uint8_t { Connecting, Waiting, Probing };
+	struct BannerRead
+	{
+		SOCKET readSocket;
+		uint32_t hostIndex;
+		uint16_t portNumber;
+		ReadState readState;
+		std::chrono::steady_clock::time_point deadline;
+		std::string serviceResponse;
+	};
+	void readBanners();
+	bool startRead(BannerRead& bannerRead);
+	bool sendProbe(BannerRead& bannerRead);
+	bool receiveResponse(BannerRead& bannerRead);
+	void finishRead(BannerRead& bannerRead);
+private:
+	// handed over by the workers and picked up by the pool thread on its next pass
+	std::mutex pendingLock;
+	std::vector<BannerRead> pendingReads;
+	// only ever touched by the pool thread
+	std::vector<BannerRead> activeReads;
+	std::mutex resultLock;
+	std::vector<BannerResult> bannerResults;
+	// sockets pending or active, checked before taking on another
+	std::atomic<size_t> heldSockets{ 0 };
+	std::atomic<bool> stopRequested{ false };
+	std::atomic<bool> dropRequested{ false };
+	std::thread poolThread;
+};
@@ -171,6 +171,19 @@ int CLIArg::getValueInt()
 	}
 }
 
+/// <summary>
+/// Get the current arg value as an unsigned 64 bit int, for values that can outgrow an int
+/// </summary>
+/// <returns>uint64_t value</returns>
+uint64_t CLIArg::getValueUint64()
+{
+	if (std::holds_alternative<int>(this->getValue()))
+	{
+		return (uint64_t)std::get<int>(this->getValue());
+	}
+	return std::stoull(this->getValueString());
+}
+
 /// <summary>
 /// get the current arg value as a string.
 /// </summary>
@@ -206,7 +219,8 @@ CLIHandler::CLIHandler(std::vector<CLIArg> desiredArgs)
 bool CLIHandler::getDefinedArg(std::string longFlag, CLIArg* argBuffer)
 {
 
-	if (!longFlag.empty() && longFlag[0] == '-')
+	// a lone '-' is a value, the usual way to ask for stdin or stdout
+	if (longFlag.size() > 1 && longFlag[0] == '-')
 	{
 		try
 		{
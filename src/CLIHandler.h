@@ -29,6 +29,7 @@
 #include <functional>
 #include <tuple>
 #include <stdexcept>
+#include <cstdint>
 #pragma once
 
 class CLIArg
@@ -64,6 +65,7 @@ public:
 	char getShortFlag();
 	const ArgValue& getValue();
 	int getValueInt();
+	uint64_t getValueUint64();
 	std::string getValueString();
 	template <typename T>
 	void setValue(T&& val);
@@ -94,7 +96,8 @@ public:
 template<typename T>
 inline void CLIArg::setValue(T&& val)
 {
-	validationResult validateResult = validator(val);
+	// auto keeps the lookup dependent, validationResult is only complete once Validators.h is included
+	auto validateResult = validator(val);
 	if (!validateResult.outcome)
 	{
 		throw std::invalid_argument(validateResult.outcomeMessage);
@@ -0,0 +1,405 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ConnectEngine:
+// Event driven TCP connect prober, keeps many non-blocking connects in flight per thread.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "ConnectEngine.h"
+#include <stdexcept>
+#include <format>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <climits>
+#ifdef _WIN32
+#pragma comment (lib, "Mswsock.lib")
+#include <WinSock2.h>
+#pragma comment(lib, "ws2_32")
+#include <ws2tcpip.h>
+#include <mstcpip.h>
+#else
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#ifdef _WIN32
+constexpr int CONNECT_PENDING = WSAEWOULDBLOCK;
+constexpr int CONNECT_TIMED_OUT = WSAETIMEDOUT;
+#else
+constexpr SOCKET INVALID_SOCKET = -1;
+constexpr int CONNECT_PENDING = EINPROGRESS;
+constexpr int CONNECT_TIMED_OUT = ETIMEDOUT;
+constexpr int EPOLL_BATCH = 256;
+#endif
+
+class NetException : public std::runtime_error {
+public:
+    NetException(const std::string& message)
+        : std::runtime_error(message) {}
+};
+
+static int lastSocketError()
+{
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+static void closeProbeSocket(SOCKET probeSocket)
+{
+#ifdef _WIN32
+    closesocket(probeSocket);
+#else
+    close(probeSocket);
+#endif
+}
+
+ConnectEngine::ConnectEngine(int maxOutstanding, int connectTimeout)
+{
+    this->maxOutstanding = std::max(maxOutstanding, 1);
+    this->connectTimeout = connectTimeout;
+    this->probeSlots.resize(this->maxOutstanding);
+    this->freeSlots.reserve(this->maxOutstanding);
+    for (size_t i = this->maxOutstanding; i > 0; i--)
+    {
+        this->freeSlots.push_back((uint32_t)(i - 1));
+    }
+#ifdef _WIN32
+    this->pollSet.reserve(this->maxOutstanding);
+    this->pollSlots.reserve(this->maxOutstanding);
+    this->pollPositions.resize(this->maxOutstanding);
+#else
+    raiseDescriptorLimit();
+    this->epollHandle = epoll_create1(EPOLL_CLOEXEC);
+    if (this->epollHandle < 0)
+    {
+        throw NetException(std::format("Failed to create epoll instance with error: {}\n", errno));
+    }
+#endif
+}
+
+ConnectEngine::~ConnectEngine()
+{
+    for (ProbeSlot& probeSlot : this->probeSlots)
+    {
+        if (probeSlot.inUse)
+        {
+            closeProbeSocket(probeSlot.probeSocket);
+        }
+    }
+    for (ProbeResult& instantResult : this->instantResults)
+    {
+        if (instantResult.openSocket != NO_SOCKET)
+        {
+            closeProbeSocket(instantResult.openSocket);
+        }
+    }
+#ifndef _WIN32
+    if (this->epollHandle >= 0)
+    {
+        close(this->epollHandle);
+    }
+#endif
+}
+
+/// <summary>
+/// Start a non-blocking connect against the target, never waits on the network.
+/// Callers should check isFull() first, the engine will not grow past its capacity.
+/// </summary>
+/// <param name="targetAddr">address with the port already set</param>
+/// <param name="addrLen">size of targetAddr</param>
+/// <param name="probeTag">caller defined id handed back with the result</param>
+/// <param name="probeTimeout">ms before the probe counts as filtered, 0 or less for the engine default</param>
+/// <returns>false if there was no descriptor to spare and nothing was sent</returns>
+bool ConnectEngine::submit(const sockaddr* targetAddr, int addrLen, uint64_t probeTag, int probeTimeout)
+{
+    if (probeTimeout <= 0)
+    {
+        probeTimeout = this->connectTimeout;
+    }
+    if (this->freeSlots.empty())
+    {
+        throw NetException("Connect engine is full\n");
+    }
+
+    SOCKET probeSocket = socket(targetAddr->sa_family, SOCK_STREAM, IPPROTO_TCP);
+    if (probeSocket == INVALID_SOCKET)
+    {
+        int socketError = lastSocketError();
+        if (isDescriptorShortage(socketError))
+        {
+            return false;
+        }
+        throw NetException(std::format("Failed to create socket with error: {}\n", socketError));
+    }
+
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(probeSocket, FIONBIO, &nonBlocking);
+
+    // no SYN retransmissions, the engine deadline decides when a port is filtered
+    TCP_INITIAL_RTO_PARAMETERS params = { (USHORT)std::min(probeTimeout, (int)USHRT_MAX), TCP_INITIAL_RTO_NO_SYN_RETRANSMISSIONS };
+    DWORD dwval = 0;
+    WSAIoctl(probeSocket, SIO_TCP_INITIAL_RTO, &params, sizeof(params), NULL, 0, &dwval, NULL, NULL);
+#else
+    fcntl(probeSocket, F_SETFL, fcntl(probeSocket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    // reset rather than linger so open ports don't pile up in TIME_WAIT
+    struct linger l;
+    l.l_onoff = 1;
+    l.l_linger = 0;
+    setsockopt(probeSocket, SOL_SOCKET, SO_LINGER, (const char*)&l, sizeof(l));
+
+    if (connect(probeSocket, targetAddr, addrLen) == 0)
+    {
+        // loopback targets can complete straight away
+        if (!this->keepOpen)
+        {
+            closeProbeSocket(probeSocket);
+        }
+        this->instantResults.push_back({ probeTag, true, 0, false, -1, this->keepOpen ? probeSocket : NO_SOCKET });
+        return true;
+    }
+    int connectError = lastSocketError();
+    if (connectError != CONNECT_PENDING)
+    {
+        closeProbeSocket(probeSocket);
+        this->instantResults.push_back({ probeTag, false, connectError });
+        return true;
+    }
+
+    uint32_t slotIndex = this->freeSlots.back();
+    this->freeSlots.pop_back();
+    ProbeSlot& probeSlot = this->probeSlots[slotIndex];
+    probeSlot.probeSocket = probeSocket;
+    probeSlot.probeTag = probeTag;
+    probeSlot.sentAt = std::chrono::steady_clock::now();
+    probeSlot.deadline = probeSlot.sentAt + std::chrono::milliseconds(probeTimeout);
+    probeSlot.generation++;
+    probeSlot.inUse = true;
+
+#ifdef _WIN32
+    this->pollPositions[slotIndex] = this->pollSet.size();
+    this->pollSet.push_back({ probeSocket, POLLWRNORM, 0 });
+    this->pollSlots.push_back(slotIndex);
+#else
+    struct epoll_event probeEvent{};
+    probeEvent.events = EPOLLOUT;
+    probeEvent.data.u64 = ((uint64_t)probeSlot.generation << 32) | slotIndex;
+    if (epoll_ctl(this->epollHandle, EPOLL_CTL_ADD, probeSocket, &probeEvent) != 0)
+    {
+        int epollError = errno;
+        probeSlot.inUse = false;
+        this->freeSlots.push_back(slotIndex);
+        close(probeSocket);
+        throw NetException(std::format("Failed to register probe with error: {}\n", epollError));
+    }
+#endif
+    this->timeoutQueue.push({ probeSlot.deadline, slotIndex, probeSlot.generation });
+    this->outstanding++;
+    return true;
+}
+
+/// <summary>
+/// Release a slot and record its outcome.
+/// </summary>
+void ConnectEngine::finishProbe(uint32_t slotIndex, bool isOpen, int errorCode, std::vector<ProbeResult>& completed)
+{
+    ProbeSlot& probeSlot = this->probeSlots[slotIndex];
+
+#ifdef _WIN32
+    // swap the last entry into the hole so the poll set stays dense
+    size_t position = this->pollPositions[slotIndex];
+    size_t lastPosition = this->pollSet.size() - 1;
+    if (position != lastPosition)
+    {
+        this->pollSet[position] = this->pollSet[lastPosition];
+        this->pollSlots[position] = this->pollSlots[lastPosition];
+        this->pollPositions[this->pollSlots[position]] = position;
+    }
+    this->pollSet.pop_back();
+    this->pollSlots.pop_back();
+#endif
+    SOCKET openSocket = NO_SOCKET;
+    if (isOpen && this->keepOpen)
+    {
+        // whoever takes it next has their own poller, so it leaves ours first
+#ifndef _WIN32
+        epoll_ctl(this->epollHandle, EPOLL_CTL_DEL, probeSlot.probeSocket, nullptr);
+#endif
+        openSocket = probeSlot.probeSocket;
+    }
+    else
+    {
+        // closing also drops the socket from the epoll set
+        closeProbeSocket(probeSlot.probeSocket);
+    }
+    probeSlot.inUse = false;
+    this->freeSlots.push_back(slotIndex);
+    this->outstanding--;
+    bool timedOut = errorCode == CONNECT_TIMED_OUT;
+    int64_t roundTrip = timedOut ? -1 : std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - probeSlot.sentAt).count();
+    completed.push_back({ probeSlot.probeTag, isOpen, errorCode, timedOut, roundTrip, openSocket });
+}
+
+/// <summary>
+/// Time out any probes that have passed their deadline, the top of the heap is always the next one due.
+/// </summary>
+void ConnectEngine::expireProbes(std::vector<ProbeResult>& completed)
+{
+    auto timeNow = std::chrono::steady_clock::now();
+    while (!this->timeoutQueue.empty())
+    {
+        TimeoutEntry timeoutEntry = this->timeoutQueue.top();
+        ProbeSlot& probeSlot = this->probeSlots[timeoutEntry.slotIndex];
+        if (!probeSlot.inUse || probeSlot.generation != timeoutEntry.generation)
+        {
+            // already finished through the poller
+            this->timeoutQueue.pop();
+            continue;
+        }
+        if (timeoutEntry.deadline > timeNow)
+        {
+            return;
+        }
+        uint32_t slotIndex = timeoutEntry.slotIndex;
+        this->timeoutQueue.pop();
+        this->finishProbe(slotIndex, false, CONNECT_TIMED_OUT, completed);
+    }
+}
+
+/// <summary>
+/// Wait for connects to finish and append their results.
+/// Completion is read from SO_ERROR once the socket becomes writable or errors.
+/// </summary>
+/// <param name="waitTime">max time to block in ms, 0 to only collect what is ready</param>
+/// <param name="completed">results are appended here</param>
+/// <returns>number of results appended</returns>
+size_t ConnectEngine::poll(int waitTime, std::vector<ProbeResult>& completed)
+{
+    size_t startCount = completed.size();
+    if (!this->instantResults.empty())
+    {
+        completed.insert(completed.end(), this->instantResults.begin(), this->instantResults.end());
+        this->instantResults.clear();
+        waitTime = 0;
+    }
+    if (this->outstanding == 0)
+    {
+        return completed.size() - startCount;
+    }
+
+    // never sleep past the oldest deadline, but leave expiring until readiness has been read
+    // so a connect that finished while the worker was busy isn't reported as a timeout
+    while (!this->timeoutQueue.empty()
+        && (!this->probeSlots[this->timeoutQueue.top().slotIndex].inUse
+            || this->probeSlots[this->timeoutQueue.top().slotIndex].generation != this->timeoutQueue.top().generation))
+    {
+        this->timeoutQueue.pop();
+    }
+    if (!this->timeoutQueue.empty())
+    {
+        auto untilDeadline = std::chrono::duration_cast<std::chrono::milliseconds>(
+            this->timeoutQueue.top().deadline - std::chrono::steady_clock::now());
+        waitTime = std::clamp(waitTime, 0, std::max((int)untilDeadline.count() + 1, 0));
+    }
+
+#ifdef _WIN32
+    // older windows 10 builds never flag a refused connect here, those probes fall through to the timeout instead
+    if (!this->pollSet.empty())
+    {
+        int readyCount = WSAPoll(this->pollSet.data(), (ULONG)this->pollSet.size(), waitTime);
+        // walk backwards as finishing a probe moves the last entry into its place
+        for (size_t i = this->pollSet.size(); readyCount > 0 && i > 0; i--)
+        {
+            WSAPOLLFD& pollEntry = this->pollSet[i - 1];
+            if (pollEntry.revents == 0)
+            {
+                continue;
+            }
+            readyCount--;
+            int socketError = 0;
+            int errorLen = sizeof(socketError);
+            getsockopt(pollEntry.fd, SOL_SOCKET, SO_ERROR, (char*)&socketError, &errorLen);
+            if (socketError == 0 && (pollEntry.revents & (POLLERR | POLLHUP)))
+            {
+                socketError = WSAECONNREFUSED;
+            }
+            this->finishProbe(this->pollSlots[i - 1], socketError == 0, socketError, completed);
+        }
+    }
+#else
+    struct epoll_event readyEvents[EPOLL_BATCH];
+    int readyCount = EPOLL_BATCH;
+    // keep draining while batches come back full, anything left behind would expire below
+    for (int batchWait = waitTime; readyCount == EPOLL_BATCH; batchWait = 0)
+    {
+        readyCount = epoll_wait(this->epollHandle, readyEvents, EPOLL_BATCH, batchWait);
+        for (int i = 0; i < readyCount; i++)
+        {
+            uint32_t slotIndex = (uint32_t)(readyEvents[i].data.u64 & 0xFFFFFFFF);
+            uint32_t generation = (uint32_t)(readyEvents[i].data.u64 >> 32);
+            ProbeSlot& probeSlot = this->probeSlots[slotIndex];
+            if (!probeSlot.inUse || probeSlot.generation != generation)
+            {
+                continue;
+            }
+            int socketError = 0;
+            socklen_t errorLen = sizeof(socketError);
+            getsockopt(probeSlot.probeSocket, SOL_SOCKET, SO_ERROR, &socketError, &errorLen);
+            if (socketError == 0 && (readyEvents[i].events & (EPOLLERR | EPOLLHUP)))
+            {
+                socketError = ECONNREFUSED;
+            }
+            this->finishProbe(slotIndex, socketError == 0, socketError, completed);
+        }
+    }
+#endif
+    this->expireProbes(completed);
+    return completed.size() - startCount;
+}
+
+size_t ConnectEngine::getOutstanding()
+{
+    return this->outstanding + this->instantResults.size();
+}
+
+bool ConnectEngine::isFull()
+{
+    return this->freeSlots.empty();
+}
+
+/// <summary>
+/// Leave open ports connected and hand their sockets back in the results, for reading banners from.
+/// The caller then has to close every socket it is given.
+/// </summary>
+bool ConnectEngine::setKeepOpen(bool keepOpen)
+{
+    this->keepOpen = keepOpen;
+    return true;
+}
@@ -0,0 +1,85 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ConnectEngine:
+// Event driven TCP connect prober, keeps many non-blocking connects in flight per thread. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include "ProbeEngine.h"
+#include <vector>
+#include <queue>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#ifndef _WIN32
+typedef int SOCKET;
+#endif
+
+class ConnectEngine : public ProbeEngine
+{
+public:
+	ConnectEngine(int maxOutstanding, int connectTimeout);
+	~ConnectEngine();
+	ConnectEngine(const ConnectEngine&) = delete;
+	ConnectEngine& operator=(const ConnectEngine&) = delete;
+public:
+	bool submit(const sockaddr* targetAddr, int addrLen, uint64_t probeTag, int probeTimeout) override;
+	size_t poll(int waitTime, std::vector<ProbeResult>& completed) override;
+	size_t getOutstanding() override;
+	bool isFull() override;
+	bool setKeepOpen(bool keepOpen) override;
+private:
+	struct ProbeSlot
+	{
+		SOCKET probeSocket{};
+		uint64_t probeTag = 0;
+		std::chrono::steady_clock::time_point sentAt{};
+		std::chrono::steady_clock::time_point deadline{};
+		uint32_t generation = 0;
+		bool inUse = false;
+	};
+	void finishProbe(uint32_t slotIndex, bool isOpen, int errorCode, std::vector<ProbeResult>& completed);
+	void expireProbes(std::vector<ProbeResult>& completed);
+private:
+	struct TimeoutEntry
+	{
+		std::chrono::steady_clock::time_point deadline;
+		uint32_t slotIndex;
+		uint32_t generation;
+		bool operator>(const TimeoutEntry& timeoutEntry) const { return this->deadline > timeoutEntry.deadline; }
+	};
+	std::vector<ProbeSlot> probeSlots;
+	std::vector<uint32_t> freeSlots;
+	// earliest deadline on top, probes each carry their own timeout so submission order is no longer deadline order
+	std::priority_queue<TimeoutEntry, std::vector<TimeoutEntry>, std::greater<TimeoutEntry>> timeoutQueue;
+	// probes that were answered inside connect() itself, handed back on the next poll
+	std::vector<ProbeResult> instantResults;
+	size_t outstanding = 0;
+	size_t maxOutstanding;
+	int connectTimeout;
+	bool keepOpen = false;
+#ifdef _WIN32
+	std::vector<WSAPOLLFD> pollSet;
+	std::vector<uint32_t> pollSlots;
+	std::vector<size_t> pollPositions;
+#else
+	int epollHandle = -1;
+#endif
+};
@@ -0,0 +1,244 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// CyclicPermutation:
+// Walks 0..n-1 in a seeded pseudo random order by stepping through the multiplicative group modulo a prime.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "CyclicPermutation.h"
+#include <random>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// (a * b) % m without overflowing, the group can be larger than 2^32
+static uint64_t mulMod(uint64_t a, uint64_t b, uint64_t m)
+{
+#ifdef _MSC_VER
+    uint64_t highPart = 0;
+    uint64_t lowPart = _umul128(a, b, &highPart);
+    uint64_t remainder = 0;
+    _udiv128(highPart, lowPart, m, &remainder);
+    return remainder;
+#else
+    return (uint64_t)((unsigned __int128)a * b % m);
+#endif
+}
+
+static uint64_t powMod(uint64_t base, uint64_t exponent, uint64_t m)
+{
+    uint64_t result = 1 % m;
+    base %= m;
+    while (exponent > 0)
+    {
+        if (exponent & 1)
+        {
+            result = mulMod(result, base, m);
+        }
+        base = mulMod(base, base, m);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+static bool isPrime(uint64_t candidate)
+{
+    if (candidate < 2)
+    {
+        return false;
+    }
+    for (uint64_t witness : PERMUTATION_WITNESSES)
+    {
+        if (candidate % witness == 0)
+        {
+            return candidate == witness;
+        }
+    }
+    uint64_t oddPart = candidate - 1;
+    int twos = 0;
+    while ((oddPart & 1) == 0)
+    {
+        oddPart >>= 1;
+        twos++;
+    }
+    for (uint64_t witness : PERMUTATION_WITNESSES)
+    {
+        uint64_t x = powMod(witness, oddPart, candidate);
+        if (x == 1 || x == candidate - 1)
+        {
+            continue;
+        }
+        bool isComposite = true;
+        for (int i = 1; i < twos && isComposite; i++)
+        {
+            x = mulMod(x, x, candidate);
+            isComposite = x != candidate - 1;
+        }
+        if (isComposite)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// distinct prime factors by trial division, only ever run once per permutation
+static std::vector<uint64_t> primeFactors(uint64_t value)
+{
+    std::vector<uint64_t> valueFactors;
+    for (uint64_t divisor = 2; divisor * divisor <= value; divisor += divisor == 2 ? 1 : 2)
+    {
+        if (value % divisor == 0)
+        {
+            valueFactors.push_back(divisor);
+            while (value % divisor == 0)
+            {
+                value /= divisor;
+            }
+        }
+    }
+    if (value > 1)
+    {
+        valueFactors.push_back(value);
+    }
+    return valueFactors;
+}
+
+CyclicPermutation::Cursor::Cursor(uint64_t firstValue, uint64_t positionCount, uint64_t elementCount, uint64_t generator, uint64_t groupPrime)
+{
+    this->currentValue = firstValue;
+    this->positionsLeft = positionCount;
+    this->elementCount = elementCount;
+    this->generator = generator;
+    this->groupPrime = groupPrime;
+}
+
+/// <summary>
+/// Step to the next position that lands inside the element range.
+/// </summary>
+/// <param name="element">set to the next element, 0 based</param>
+/// <returns>false once the cursor's positions run out</returns>
+bool CyclicPermutation::Cursor::next(uint64_t& element)
+{
+    while (this->positionsLeft > 0)
+    {
+        uint64_t groupValue = this->currentValue;
+        this->currentValue = mulMod(this->currentValue, this->generator, this->groupPrime);
+        this->positionsLeft--;
+        // the prime overshoots the range a little, those members are skipped
+        if (groupValue <= this->elementCount)
+        {
+            element = groupValue - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// <summary>
+/// Pick the group and a random generator and starting point for it. Powers of a generator
+/// modulo a prime visit every member exactly once, so the cycle is a full permutation
+/// that needs no memory, and the same seed always gives the same order.
+/// </summary>
+/// <param name="elementCount">size of the space to permute</param>
+/// <param name="permutationSeed">seed for the generator and starting point</param>
+CyclicPermutation::CyclicPermutation(uint64_t elementCount, uint64_t permutationSeed)
+{
+    this->elementCount = elementCount;
+    this->groupPrime = elementCount + 1;
+    while (!isPrime(this->groupPrime))
+    {
+        this->groupPrime++;
+    }
+    uint64_t groupOrder = this->groupPrime - 1;
+    if (groupOrder == 1)
+    {
+        return;
+    }
+
+    std::mt19937_64 seedEngine(permutationSeed);
+    std::uniform_int_distribution<uint64_t> memberPick(1, groupOrder);
+    std::vector<uint64_t> orderFactors = primeFactors(groupOrder);
+    // a member generates the whole group when no power g^(order/q) for a prime factor q comes back to 1
+    bool isGenerator = false;
+    while (!isGenerator)
+    {
+        this->generator = memberPick(seedEngine);
+        isGenerator = true;
+        for (uint64_t orderFactor : orderFactors)
+        {
+            isGenerator = isGenerator && powMod(this->generator, groupOrder / orderFactor, this->groupPrime) != 1;
+        }
+    }
+    this->firstValue = memberPick(seedEngine);
+}
+
+uint64_t CyclicPermutation::getElementCount() const
+{
+    return this->elementCount;
+}
+
+// positions in a full cycle, a little more than the element count
+uint64_t CyclicPermutation::getCycleLength() const
+{
+    return this->groupPrime - 1;
+}
+
+/// <summary>
+/// Cursor over cycle positions [positionBegin, positionEnd), disjoint runs can be walked by different workers.
+/// </summary>
+CyclicPermutation::Cursor CyclicPermutation::getCursor(uint64_t positionBegin, uint64_t positionEnd) const
+{
+    if (positionEnd <= positionBegin)
+    {
+        return Cursor();
+    }
+    uint64_t runStart = mulMod(this->firstValue, powMod(this->generator, positionBegin, this->groupPrime), this->groupPrime);
+    return Cursor(runStart, positionEnd - positionBegin, this->elementCount, this->generator, this->groupPrime);
+}
+
+/// <summary>
+/// Cycle position of each of the given elements, found with one walk of the whole cycle.
+/// Only worth it for a handful of elements at the end of a sweep, nothing is kept for the rest.
+/// </summary>
+/// <param name="elements">elements to look for, 0 based</param>
+/// <returns>position of each element found, keyed by the element</returns>
+std::unordered_map<uint64_t, uint64_t> CyclicPermutation::findPositions(const std::vector<uint64_t>& elements) const
+{
+    std::unordered_map<uint64_t, uint64_t> elementPositions;
+    for (uint64_t element : elements)
+    {
+        elementPositions.emplace(element, UINT64_MAX);
+    }
+    size_t elementsLeft = elementPositions.size();
+    uint64_t groupValue = this->firstValue;
+    for (uint64_t position = 0; position < this->getCycleLength() && elementsLeft > 0; position++)
+    {
+        auto elementEntry = elementPositions.find(groupValue - 1);
+        if (elementEntry != elementPositions.end() && elementEntry->second == UINT64_MAX)
+        {
+            elementEntry->second = position;
+            elementsLeft--;
+        }
+        groupValue = mulMod(groupValue, this->generator, this->groupPrime);
+    }
+    return elementPositions;
+}
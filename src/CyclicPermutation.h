@@ -0,0 +1,64 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// CyclicPermutation:
+// Walks 0..n-1 in a seeded pseudo random order by stepping through the multiplicative group modulo a prime. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// deterministic Miller-Rabin witnesses, enough for any 64 bit candidate
+constexpr uint64_t PERMUTATION_WITNESSES[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37 };
+
+class CyclicPermutation
+{
+public:
+	// a run of cycle positions, yields the elements they map to and skips the ones past the end
+	class Cursor
+	{
+	public:
+		Cursor() = default;
+		Cursor(uint64_t firstValue, uint64_t positionCount, uint64_t elementCount, uint64_t generator, uint64_t groupPrime);
+	public:
+		bool next(uint64_t& element);
+	private:
+		uint64_t currentValue = 1;
+		uint64_t positionsLeft = 0;
+		uint64_t elementCount = 0;
+		uint64_t generator = 1;
+		uint64_t groupPrime = 2;
+	};
+public:
+	CyclicPermutation(uint64_t elementCount, uint64_t permutationSeed);
+public:
+	uint64_t getElementCount() const;
+	uint64_t getCycleLength() const;
+	Cursor getCursor(uint64_t positionBegin, uint64_t positionEnd) const;
+	std::unordered_map<uint64_t, uint64_t> findPositions(const std::vector<uint64_t>& elements) const;
+private:
+	uint64_t elementCount = 0;
+	// smallest prime past elementCount, the group's members are 1..groupPrime-1
+	uint64_t groupPrime = 2;
+	uint64_t generator = 1;
+	// group member at cycle position 0
+	uint64_t firstValue = 1;
+};
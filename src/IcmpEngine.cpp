@@ -0,0 +1,444 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// IcmpEngine:
+// Host discovery over a single ICMP socket, a paced sender and a receiver thread matching replies.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "IcmpEngine.h"
+#include <stdexcept>
+#include <format>
+#include <random>
+#include <algorithm>
+#include <string.h>
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#include <process.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#ifdef _WIN32
+#define getpid _getpid
+#else
+constexpr SOCKET INVALID_SOCKET = -1;
+#endif
+
+// cookie, host index, attempt and send time
+constexpr int ICMP_ECHO_PAYLOAD = 24;
+constexpr int ICMP_ECHO_SIZE = 8 + ICMP_ECHO_PAYLOAD;
+constexpr uint8_t ICMP_ECHO_REQUEST = 8;
+constexpr uint8_t ICMP_ECHO_REPLY = 0;
+// upper bound in ms for a single wait in either loop
+constexpr int ICMP_POLL_INTERVAL = 50;
+
+class NetException : public std::runtime_error {
+public:
+    NetException(const std::string& message)
+        : std::runtime_error(message) {}
+};
+
+static void closeEchoSocket(SOCKET echoSocket)
+{
+#ifdef _WIN32
+    closesocket(echoSocket);
+#else
+    close(echoSocket);
+#endif
+}
+
+/// <summary>
+/// Open an ICMP socket, an unprivileged ping socket where the kernel allows one and a raw socket otherwise.
+/// </summary>
+/// <param name="isRaw">set when the socket is raw and replies carry their IP header</param>
+static SOCKET openEchoSocket(bool& isRaw)
+{
+    isRaw = false;
+#ifndef _WIN32
+    SOCKET echoSocket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_ICMP);
+    if (echoSocket != INVALID_SOCKET)
+    {
+        return echoSocket;
+    }
+#endif
+    // windows has no ping sockets, raw ICMP needs an elevated process there
+    isRaw = true;
+    return socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+}
+
+static uint16_t icmpChecksum(const uint8_t* packet, int packetLength)
+{
+    uint32_t checkSum = 0;
+    for (int i = 0; i + 1 < packetLength; i += 2)
+    {
+        checkSum += (uint32_t)((packet[i] << 8) | packet[i + 1]);
+    }
+    if (packetLength & 1)
+    {
+        checkSum += (uint32_t)packet[packetLength - 1] << 8;
+    }
+    while (checkSum >> 16)
+    {
+        checkSum = (checkSum & 0xFFFF) + (checkSum >> 16);
+    }
+    return (uint16_t)~checkSum;
+}
+
+static int64_t steadyMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+IcmpEngine::IcmpEngine(int replyTimeout, int maxTries)
+{
+    this->replyTimeout = replyTimeout;
+    this->maxTries = std::clamp(maxTries, 1, 255);
+    this->echoSocket = openEchoSocket(this->echoRaw);
+    if (this->echoSocket == INVALID_SOCKET)
+    {
+        throw NetException("Failed to open an ICMP socket, raw sockets need elevated rights\n");
+    }
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(this->echoSocket, FIONBIO, &nonBlocking);
+#else
+    fcntl(this->echoSocket, F_SETFL, fcntl(this->echoSocket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    // a big receive buffer rides out reply bursts from large subnets
+    int bufferSize = 4 * 1024 * 1024;
+    setsockopt(this->echoSocket, SOL_SOCKET, SO_RCVBUF, (const char*)&bufferSize, sizeof(bufferSize));
+    this->echoIdentifier = (uint16_t)(getpid() & 0xFFFF);
+}
+
+IcmpEngine::~IcmpEngine()
+{
+    this->receiverEnabled = false;
+    if (this->receiverThread.joinable())
+    {
+        this->receiverThread.join();
+    }
+    closeEchoSocket(this->echoSocket);
+}
+
+bool IcmpEngine::isSupported()
+{
+    static const bool icmpSupported = []() {
+        bool isRaw;
+        SOCKET testSocket = openEchoSocket(isRaw);
+        if (testSocket == INVALID_SOCKET)
+        {
+            return false;
+        }
+        closeEchoSocket(testSocket);
+        return true;
+    }();
+    return icmpSupported;
+}
+
+/// <summary>
+/// Build and send one echo request. The payload carries everything needed to match the reply,
+/// so the receiver never has to look up what was sent.
+/// </summary>
+void IcmpEngine::sendEcho(uint32_t hostIndex, uint8_t echoAttempt)
+{
+    uint8_t echoPacket[ICMP_ECHO_SIZE]{};
+    int64_t sendTime = steadyMicros();
+    echoPacket[0] = ICMP_ECHO_REQUEST;
+    echoPacket[4] = (uint8_t)(this->echoIdentifier >> 8);
+    echoPacket[5] = (uint8_t)(this->echoIdentifier & 0xFF);
+    echoPacket[6] = (uint8_t)(hostIndex >> 8);
+    echoPacket[7] = (uint8_t)(hostIndex & 0xFF);
+    memcpy(echoPacket + 8, &this->sweepCookie, sizeof(uint32_t));
+    memcpy(echoPacket + 12, &hostIndex, sizeof(uint32_t));
+    echoPacket[16] = echoAttempt;
+    memcpy(echoPacket + 17, &sendTime, sizeof(int64_t));
+    uint16_t checkSum = icmpChecksum(echoPacket, ICMP_ECHO_SIZE);
+    echoPacket[2] = (uint8_t)(checkSum >> 8);
+    echoPacket[3] = (uint8_t)(checkSum & 0xFF);
+
+    sockaddr_in targetAddr{};
+    targetAddr.sin_family = AF_INET;
+    targetAddr.sin_addr.s_addr = htonl(this->targetSpace->getAddress(hostIndex));
+    // a failed send is left to time out and retry like a lost one
+    sendto(this->echoSocket, (const char*)echoPacket, ICMP_ECHO_SIZE, 0, (sockaddr*)&targetAddr, sizeof(targetAddr));
+}
+
+/// <summary>
+/// Check a reply against the sweep and record its host the first time it answers.
+/// Any attempt's reply counts, a slow host answering its first echo after a retry is still up.
+/// </summary>
+void IcmpEngine::handleReply(const uint8_t* replyPacket, int replyLength, uint32_t sourceAddr)
+{
+    if (replyLength < ICMP_ECHO_SIZE || replyPacket[0] != ICMP_ECHO_REPLY)
+    {
+        return;
+    }
+    uint16_t identifier = (uint16_t)((replyPacket[4] << 8) | replyPacket[5]);
+    uint32_t replyCookie;
+    uint32_t hostIndex;
+    int64_t sendTime;
+    memcpy(&replyCookie, replyPacket + 8, sizeof(uint32_t));
+    memcpy(&hostIndex, replyPacket + 12, sizeof(uint32_t));
+    uint8_t echoAttempt = replyPacket[16];
+    memcpy(&sendTime, replyPacket + 17, sizeof(int64_t));
+
+    // raw sockets see every echo reply on the box, ping sockets rewrite the identifier themselves
+    if ((this->echoRaw && identifier != this->echoIdentifier) || replyCookie != this->sweepCookie
+        || hostIndex >= this->targetSpace->size() || this->targetSpace->getAddress(hostIndex) != sourceAddr)
+    {
+        return;
+    }
+    int64_t roundTrip = steadyMicros() - sendTime;
+    {
+        std::lock_guard<std::mutex> echoGuard(this->echoLock);
+        if (!this->repliedHosts.insert(hostIndex).second)
+        {
+            return;
+        }
+        this->echoResults.push_back({ hostIndex, roundTrip });
+        auto echoEntry = this->echoEntries.find(hostIndex);
+        // no entry means the sender already gave up on this host and counted it as finished
+        if (echoEntry != this->echoEntries.end())
+        {
+            if (echoEntry->second.echoState == Waiting)
+            {
+                // a reply that needed a retry means an earlier echo was lost somewhere
+                if (echoAttempt > 1)
+                {
+                    this->scanPacer->onDrop();
+                }
+                else
+                {
+                    this->scanPacer->onResponse();
+                }
+            }
+            this->echoEntries.erase(echoEntry);
+            this->repliesPending++;
+        }
+    }
+    this->onReply(hostIndex, roundTrip);
+}
+
+/// <summary>
+/// Receiver loop, drains the socket whenever it is readable until the sweep ends.
+/// </summary>
+void IcmpEngine::receiveReplies()
+{
+    uint8_t recvBuffer[2048];
+#ifdef _WIN32
+    WSAPOLLFD recvPoll{ this->echoSocket, POLLRDNORM, 0 };
+#else
+    pollfd recvPoll{ this->echoSocket, POLLIN, 0 };
+#endif
+    while (this->receiverEnabled)
+    {
+#ifdef _WIN32
+        int readyCount = WSAPoll(&recvPoll, 1, ICMP_POLL_INTERVAL);
+#else
+        int readyCount = ::poll(&recvPoll, 1, ICMP_POLL_INTERVAL);
+#endif
+        if (readyCount <= 0)
+        {
+            continue;
+        }
+        while (true)
+        {
+            sockaddr_in sourceAddr{};
+            socklen_t sourceLen = sizeof(sourceAddr);
+            int recvLength = (int)recvfrom(this->echoSocket, (char*)recvBuffer, sizeof(recvBuffer), 0,
+                (sockaddr*)&sourceAddr, &sourceLen);
+            if (recvLength <= 0)
+            {
+                break;
+            }
+            const uint8_t* replyPacket = recvBuffer;
+            if (this->echoRaw)
+            {
+                int headerLength = (recvBuffer[0] & 0x0F) * 4;
+                if (recvLength < headerLength)
+                {
+                    continue;
+                }
+                replyPacket += headerLength;
+                recvLength -= headerLength;
+            }
+            this->handleReply(replyPacket, recvLength, ntohl(sourceAddr.sin_addr.s_addr));
+        }
+    }
+}
+
+/// <summary>
+/// Ping every target, retrying silent ones up to maxTries, and block until all have finished.
+/// Echoes go out as fast as the pacer allows while a second thread matches replies.
+/// </summary>
+/// <param name="targetSpace">the targets, 0.0.0.0 is skipped as unreachable</param>
+/// <param name="sendOrder">permutation over the targets giving the order first echoes go out in</param>
+/// <param name="scanPacer">shared pacer, one window slot is held per echo in flight</param>
+/// <param name="keepRunning">polled between batches, returning false ends the sweep early</param>
+/// <param name="onProgress">given the number of hosts that finished since the last call</param>
+/// <param name="onReply">called from the receiver thread as each host first answers</param>
+/// <returns>one result per host that replied, in the order the replies came</returns>
+std::vector<EchoResult> IcmpEngine::sweep(const TargetSpace& targetSpace, const CyclicPermutation& sendOrder, Pacer& scanPacer,
+    std::function<bool()> keepRunning, std::function<void(int hostsFinished)> onProgress,
+    std::function<void(uint32_t hostIndex, int64_t roundTrip)> onReply)
+{
+    this->targetSpace = &targetSpace;
+    this->scanPacer = &scanPacer;
+    this->onReply = std::move(onReply);
+    this->echoEntries.clear();
+    this->repliedHosts.clear();
+    this->echoResults.clear();
+    this->repliesPending = 0;
+    std::random_device randomDevice;
+    this->sweepCookie = randomDevice();
+
+    this->receiverEnabled = true;
+    this->receiverThread = std::thread(&IcmpEngine::receiveReplies, this);
+
+    // echoes in flight, they all share one timeout so this stays in deadline order
+    std::deque<TimeoutEntry> timeoutQueue;
+    std::deque<uint32_t> retryQueue;
+    CyclicPermutation::Cursor hostCursor = sendOrder.getCursor(0, sendOrder.getCycleLength());
+    uint64_t nextHost = 0;
+    bool hostsLeft = hostCursor.next(nextHost);
+    int skippedHosts = 0;
+
+    while (keepRunning())
+    {
+        int hostsFinished = skippedHosts + this->repliesPending.exchange(0);
+        skippedHosts = 0;
+
+        // hand back timed out echoes and queue their retries
+        auto timeNow = std::chrono::steady_clock::now();
+        while (!timeoutQueue.empty() && timeoutQueue.front().deadline <= timeNow)
+        {
+            uint32_t hostIndex = timeoutQueue.front().hostIndex;
+            timeoutQueue.pop_front();
+            std::lock_guard<std::mutex> echoGuard(this->echoLock);
+            auto echoEntry = this->echoEntries.find(hostIndex);
+            // gone when a reply claimed it, in which case it was counted as it came in
+            if (echoEntry == this->echoEntries.end() || echoEntry->second.echoState != Waiting)
+            {
+                continue;
+            }
+            // silence is more likely a down host than a drop, so it opens the window rather than cutting it
+            scanPacer.onSilence();
+            if (echoEntry->second.echoAttempts < this->maxTries)
+            {
+                echoEntry->second.echoState = Idle;
+                retryQueue.push_back(hostIndex);
+            }
+            else
+            {
+                this->echoEntries.erase(echoEntry);
+                hostsFinished++;
+            }
+        }
+
+        for (int sent = 0; sent < ICMP_SEND_BATCH; sent++)
+        {
+            bool isRetry = !retryQueue.empty();
+            if (!isRetry && !hostsLeft)
+            {
+                break;
+            }
+            uint32_t hostIndex = isRetry ? retryQueue.front() : (uint32_t)nextHost;
+            if (!isRetry && targetSpace.getAddress(hostIndex) == 0)
+            {
+                hostsLeft = hostCursor.next(nextHost);
+                hostsFinished++;
+                continue;
+            }
+            if (!scanPacer.tryAcquire())
+            {
+                break;
+            }
+            if (isRetry)
+            {
+                retryQueue.pop_front();
+            }
+            else
+            {
+                hostsLeft = hostCursor.next(nextHost);
+            }
+            // waiting has to be visible before the reply can possibly arrive,
+            // and a late reply may have claimed a host sitting in the retry queue
+            uint8_t echoAttempt;
+            {
+                std::lock_guard<std::mutex> echoGuard(this->echoLock);
+                auto echoEntry = isRetry ? this->echoEntries.find(hostIndex) : this->echoEntries.try_emplace(hostIndex).first;
+                if (echoEntry == this->echoEntries.end())
+                {
+                    scanPacer.release();
+                    continue;
+                }
+                echoEntry->second.echoState = Waiting;
+                echoAttempt = ++echoEntry->second.echoAttempts;
+            }
+            this->sendEcho(hostIndex, echoAttempt);
+            timeoutQueue.push_back({ hostIndex, std::chrono::steady_clock::now() + std::chrono::milliseconds(this->replyTimeout) });
+        }
+
+        if (hostsFinished > 0)
+        {
+            onProgress(hostsFinished);
+        }
+        if (timeoutQueue.empty() && retryQueue.empty() && !hostsLeft)
+        {
+            break;
+        }
+
+        // sleep until the next deadline or pacer token, whichever is first
+        int waitTime = scanPacer.getWaitTime();
+        if (!timeoutQueue.empty())
+        {
+            auto untilDeadline = std::chrono::duration_cast<std::chrono::milliseconds>(
+                timeoutQueue.front().deadline - std::chrono::steady_clock::now());
+            waitTime = std::clamp((int)untilDeadline.count() + 1, 0, waitTime);
+        }
+        if (waitTime > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min(waitTime, ICMP_POLL_INTERVAL)));
+        }
+    }
+
+    this->receiverEnabled = false;
+    this->receiverThread.join();
+    int lateReplies = this->repliesPending.exchange(0);
+    if (lateReplies > 0)
+    {
+        onProgress(lateReplies);
+    }
+
+    std::vector<EchoResult> echoResults = std::move(this->echoResults);
+    this->echoResults.clear();
+    this->echoEntries.clear();
+    this->repliedHosts.clear();
+    this->targetSpace = nullptr;
+    this->scanPacer = nullptr;
+    this->onReply = nullptr;
+    return echoResults;
+}
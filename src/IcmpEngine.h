@@ -0,0 +1,103 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// IcmpEngine:
+// Host discovery over a single ICMP socket, a paced sender and a receiver thread matching replies. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include "Pacer.h"
+#include "TargetSpace.h"
+#include "CyclicPermutation.h"
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#ifdef _WIN32
+#include <WinSock2.h>
+#pragma comment(lib, "ws2_32")
+#else
+typedef int SOCKET;
+#endif
+
+// echoes sent per pass of the sender loop before it checks timeouts again
+constexpr int ICMP_SEND_BATCH = 64;
+
+// one per host that replied
+struct EchoResult
+{
+	uint32_t hostIndex = 0;
+	// microseconds
+	int64_t roundTrip = -1;
+};
+
+class IcmpEngine
+{
+public:
+	IcmpEngine(int replyTimeout, int maxTries);
+	~IcmpEngine();
+	IcmpEngine(const IcmpEngine&) = delete;
+	IcmpEngine& operator=(const IcmpEngine&) = delete;
+public:
+	static bool isSupported();
+	std::vector<EchoResult> sweep(const TargetSpace& targetSpace, const CyclicPermutation& sendOrder, Pacer& scanPacer,
+		std::function<bool()> keepRunning, std::function<void(int hostsFinished)> onProgress,
+		std::function<void(uint32_t hostIndex, int64_t roundTrip)> onReply);
+private:
+	// Idle hosts are queued for a retry, hosts leave the table once they reply or run out of tries
+	enum EchoState : uint8_t { Idle, Waiting };
+	struct EchoEntry
+	{
+		EchoState echoState = Waiting;
+		uint8_t echoAttempts = 0;
+	};
+	struct TimeoutEntry
+	{
+		uint32_t hostIndex;
+		std::chrono::steady_clock::time_point deadline;
+	};
+	void sendEcho(uint32_t hostIndex, uint8_t echoAttempt);
+	void receiveReplies();
+	void handleReply(const uint8_t* replyPacket, int replyLength, uint32_t sourceAddr);
+private:
+	SOCKET echoSocket{};
+	bool echoRaw = false;
+	uint16_t echoIdentifier = 0;
+	uint32_t sweepCookie = 0;
+	int replyTimeout;
+	int maxTries;
+	// only valid for the length of a sweep
+	const TargetSpace* targetSpace = nullptr;
+	Pacer* scanPacer = nullptr;
+	std::function<void(uint32_t hostIndex, int64_t roundTrip)> onReply{};
+	// only hosts with an echo in flight or a retry queued have an entry, so memory follows the send window
+	std::mutex echoLock;
+	std::unordered_map<uint32_t, EchoEntry> echoEntries;
+	std::unordered_set<uint32_t> repliedHosts;
+	std::vector<EchoResult> echoResults;
+	std::atomic<int> repliesPending{ 0 };
+	std::thread receiverThread;
+	std::atomic<bool> receiverEnabled{ false };
+};
@@ -0,0 +1,172 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// LiteralAutomaton:
+// Aho-Corasick automaton finding every one of a set of literals in a single pass over the text.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "LiteralAutomaton.h"
+#include <deque>
+#include <stdexcept>
+
+static uint8_t foldCase(uint8_t textByte)
+{
+    return (textByte >= 'A' && textByte <= 'Z') ? (uint8_t)(textByte + ('a' - 'A')) : textByte;
+}
+
+/// <summary>
+/// Queue a literal to be found, takes effect on the next compile.
+/// </summary>
+/// <param name="literalText">bytes to look for, may hold anything including nulls</param>
+/// <param name="literalId">handed back by findAll wherever the literal turns up, several literals can share one</param>
+void LiteralAutomaton::addLiteral(std::string_view literalText, uint32_t literalId)
+{
+    if (literalText.empty())
+    {
+        return;
+    }
+    this->pendingLiterals.emplace_back(std::string(literalText), literalId);
+}
+
+/// <summary>
+/// Build the trie, link each state to the longest proper suffix that is also in the trie,
+/// then fill in every missing edge so searching is one table read per byte of text.
+/// </summary>
+void LiteralAutomaton::compile()
+{
+    // only the bytes the literals use need their own column
+    std::array<uint8_t, 256> foldedClasses{};
+    this->classCount = 1;
+    for (const auto& [literalText, literalId] : this->pendingLiterals)
+    {
+        for (char literalChar : literalText)
+        {
+            uint8_t foldedByte = foldCase((uint8_t)literalChar);
+            if (foldedClasses[foldedByte] == 0)
+            {
+                if (this->classCount > UINT8_MAX)
+                {
+                    throw std::length_error("Literal automaton ran out of byte classes");
+                }
+                foldedClasses[foldedByte] = (uint8_t)this->classCount++;
+            }
+        }
+    }
+    for (size_t textByte = 0; textByte < 256; textByte++)
+    {
+        this->byteClasses[textByte] = foldedClasses[foldCase((uint8_t)textByte)];
+    }
+
+    this->stateTransitions.assign(this->classCount, AUTOMATON_NO_STATE);
+    std::vector<std::vector<uint32_t>> stateOutputs(1);
+    for (const auto& [literalText, literalId] : this->pendingLiterals)
+    {
+        uint32_t currentState = 0;
+        for (char literalChar : literalText)
+        {
+            uint32_t& nextState = this->stateTransitions[(size_t)currentState * this->classCount + this->byteClasses[(uint8_t)literalChar]];
+            if (nextState == AUTOMATON_NO_STATE)
+            {
+                nextState = (uint32_t)stateOutputs.size();
+                stateOutputs.emplace_back();
+                // may move the table, so nextState is not touched again after this
+                this->stateTransitions.resize(this->stateTransitions.size() + this->classCount, AUTOMATON_NO_STATE);
+            }
+            currentState = this->stateTransitions[(size_t)currentState * this->classCount + this->byteClasses[(uint8_t)literalChar]];
+        }
+        stateOutputs[currentState].push_back(literalId);
+    }
+
+    // breadth first, so a state's failure target is always finished before the state itself
+    std::vector<uint32_t> failStates(stateOutputs.size(), 0);
+    std::deque<uint32_t> stateQueue;
+    for (uint32_t classIndex = 0; classIndex < this->classCount; classIndex++)
+    {
+        uint32_t& rootEdge = this->stateTransitions[classIndex];
+        if (rootEdge == AUTOMATON_NO_STATE)
+        {
+            rootEdge = 0;
+        }
+        else
+        {
+            stateQueue.push_back(rootEdge);
+        }
+    }
+    while (!stateQueue.empty())
+    {
+        uint32_t currentState = stateQueue.front();
+        stateQueue.pop_front();
+        const std::vector<uint32_t>& failOutputs = stateOutputs[failStates[currentState]];
+        stateOutputs[currentState].insert(stateOutputs[currentState].end(), failOutputs.begin(), failOutputs.end());
+        for (uint32_t classIndex = 0; classIndex < this->classCount; classIndex++)
+        {
+            size_t edgeIndex = (size_t)currentState * this->classCount + classIndex;
+            uint32_t failEdge = this->stateTransitions[(size_t)failStates[currentState] * this->classCount + classIndex];
+            if (this->stateTransitions[edgeIndex] == AUTOMATON_NO_STATE)
+            {
+                this->stateTransitions[edgeIndex] = failEdge;
+            }
+            else
+            {
+                failStates[this->stateTransitions[edgeIndex]] = failEdge;
+                stateQueue.push_back(this->stateTransitions[edgeIndex]);
+            }
+        }
+    }
+
+    this->outputStarts.assign(1, 0);
+    this->outputIds.clear();
+    for (std::vector<uint32_t>& stateOutput : stateOutputs)
+    {
+        this->outputIds.insert(this->outputIds.end(), stateOutput.begin(), stateOutput.end());
+        this->outputStarts.push_back((uint32_t)this->outputIds.size());
+    }
+    this->pendingLiterals.clear();
+    this->pendingLiterals.shrink_to_fit();
+}
+
+/// <summary>
+/// Run the text through the automaton once, whatever the number of literals.
+/// </summary>
+/// <param name="searchText">text to search</param>
+/// <param name="foundIds">the id of every literal found is appended, once per place it was found</param>
+void LiteralAutomaton::findAll(std::string_view searchText, std::vector<uint32_t>& foundIds) const
+{
+    if (this->stateTransitions.empty())
+    {
+        return;
+    }
+    uint32_t currentState = 0;
+    for (char textChar : searchText)
+    {
+        currentState = this->stateTransitions[(size_t)currentState * this->classCount + this->byteClasses[(uint8_t)textChar]];
+        uint32_t outputBegin = this->outputStarts[currentState];
+        uint32_t outputEnd = this->outputStarts[currentState + 1];
+        if (outputBegin != outputEnd)
+        {
+            foundIds.insert(foundIds.end(), this->outputIds.begin() + outputBegin, this->outputIds.begin() + outputEnd);
+        }
+    }
+}
+
+size_t LiteralAutomaton::getStateCount() const
+{
+    return this->outputStarts.empty() ? 0 : this->outputStarts.size() - 1;
+}
@@ -0,0 +1,55 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// LiteralAutomaton:
+// Aho-Corasick automaton finding every one of a set of literals in a single pass over the text. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+// stands in for a missing trie edge while the automaton is being built
+constexpr uint32_t AUTOMATON_NO_STATE = UINT32_MAX;
+
+// literals are matched without regard to ASCII case, callers check case themselves where it matters
+class LiteralAutomaton
+{
+public:
+	LiteralAutomaton() = default;
+public:
+	void addLiteral(std::string_view literalText, uint32_t literalId);
+	void compile();
+	void findAll(std::string_view searchText, std::vector<uint32_t>& foundIds) const;
+	size_t getStateCount() const;
+private:
+	// kept until compile, the byte classes can only be worked out once every literal is known
+	std::vector<std::pair<std::string, uint32_t>> pendingLiterals;
+	// bytes no literal uses share class 0, and upper and lower case letters share a class
+	std::array<uint8_t, 256> byteClasses{};
+	uint32_t classCount = 1;
+	// full DFA, one row of classCount next states per state, so a search never follows a failure link
+	std::vector<uint32_t> stateTransitions;
+	// ids found on reaching each state, state s owns outputIds[outputStarts[s]] up to outputStarts[s + 1]
+	std::vector<uint32_t> outputStarts;
+	std::vector<uint32_t> outputIds;
+};
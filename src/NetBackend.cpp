@@ -0,0 +1,95 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// NetBackend:
+// Platform layer under the scanner, name resolution, probes, echo, ARP and console input.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "NetBackend.h"
+#include <string.h>
+#ifdef _WIN32
+#include "Win32NetBackend.h"
+#else
+#include "PosixNetBackend.h"
+#endif
+
+/// <summary>
+/// The backend for the platform we were built for, created on first use.
+/// </summary>
+NetBackend& getNetBackend()
+{
+#ifdef _WIN32
+    static Win32NetBackend netBackend;
+#else
+    static PosixNetBackend netBackend;
+#endif
+    return netBackend;
+}
+
+/// <summary>
+/// Turn a host name or literal address into a sockaddr. Literals are parsed directly,
+/// anything else gets a single getaddrinfo call, which behaves the same over WinSock and BSD sockets.
+/// </summary>
+/// <param name="hostName">name or literal address to resolve</param>
+/// <param name="addrFamily">AF_INET, AF_INET6 or AF_UNSPEC for whichever the resolver returns first</param>
+/// <param name="hostAddr">filled with the address, port left at 0</param>
+/// <param name="hostAddrLen">set to the length of the filled address</param>
+/// <returns>false when the name could not be resolved in the requested family</returns>
+bool NetBackend::resolveHost(const std::string& hostName, int addrFamily, sockaddr_storage& hostAddr, int& hostAddrLen)
+{
+    memset(&hostAddr, 0, sizeof(hostAddr));
+    sockaddr_in* IPv4Addr = (sockaddr_in*)&hostAddr;
+    sockaddr_in6* IPv6Addr = (sockaddr_in6*)&hostAddr;
+
+    if (addrFamily != AF_INET6 && inet_pton(AF_INET, hostName.c_str(), &IPv4Addr->sin_addr) == 1)
+    {
+        IPv4Addr->sin_family = AF_INET;
+        hostAddrLen = sizeof(sockaddr_in);
+        return true;
+    }
+    if (addrFamily != AF_INET && inet_pton(AF_INET6, hostName.c_str(), &IPv6Addr->sin6_addr) == 1)
+    {
+        IPv6Addr->sin6_family = AF_INET6;
+        hostAddrLen = sizeof(sockaddr_in6);
+        return true;
+    }
+
+    struct addrinfo hints = {};
+    struct addrinfo* result = nullptr;
+    hints.ai_family = addrFamily;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    if (getaddrinfo(hostName.c_str(), nullptr, &hints, &result) != 0 || result == nullptr)
+    {
+        return false;
+    }
+    memcpy(&hostAddr, result->ai_addr, result->ai_addrlen);
+    hostAddrLen = (int)result->ai_addrlen;
+    freeaddrinfo(result);
+    return true;
+}
+
+/// <summary>
+/// Connect probes already have a portable engine per platform, the backend just hands them out.
+/// </summary>
+std::unique_ptr<ProbeEngine> NetBackend::createProbeEngine(ProbeBackend probeBackend, int maxOutstanding, int connectTimeout)
+{
+    return ::createProbeEngine(probeBackend, maxOutstanding, connectTimeout);
+}
@@ -0,0 +1,68 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// NetBackend:
+// Platform layer under the scanner, name resolution, probes, echo, ARP and console input. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include "ProbeEngine.h"
+#include <string>
+#include <memory>
+#include <cstdint>
+#ifdef _WIN32
+#include <WinSock2.h>
+#pragma comment(lib, "ws2_32")
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#endif
+
+// upper bound in ms for a single wait on console input
+constexpr int CONSOLE_POLL_INTERVAL = 50;
+
+// outcome of a single blocking echo, unreachable hosts are not worth retrying
+enum class EchoStatus
+{
+	Replied,
+	Unreachable,
+	TimedOut
+};
+
+// everything the scanner needs from the OS, one implementation per platform
+// addresses are host order IPv4 like NetworkNode::getPackedAddr
+class NetBackend
+{
+public:
+	virtual ~NetBackend() = default;
+public:
+	virtual bool startup() = 0;
+	virtual void cleanup() = 0;
+	bool resolveHost(const std::string& hostName, int addrFamily, sockaddr_storage& hostAddr, int& hostAddrLen);
+	std::unique_ptr<ProbeEngine> createProbeEngine(ProbeBackend probeBackend, int maxOutstanding, int connectTimeout);
+	virtual EchoStatus echoHost(uint32_t targetAddr, int replyTimeout, int64_t& roundTrip) = 0;
+	virtual std::string lookupMac(uint32_t targetAddr) = 0;
+	virtual int readKey(int waitTime) = 0;
+	virtual void wakeConsole() = 0;
+};
+
+NetBackend& getNetBackend();
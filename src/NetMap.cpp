@@ -24,7 +24,14 @@
 #include "CLIHandler.h"
 #include "Validators.h"
 #include "ScanHandler.h"
+#include "UringEngine.h"
+#include "SynScanner.h"
+#include "UdpScanner.h"
+#include "NetBackend.h"
+#include "ServiceRegistry.h"
+#include "ResultFormatter.h"
 #include <iostream>
+#include <fstream>
 #include <chrono>
 #include <vector>
 #include <format>
@@ -37,6 +44,22 @@ char const constexpr* const TARGET_FLAG = "target";
 char const constexpr* const PORT_FLAG = "port";
 char const constexpr* const DELAY_FLAG = "delay";
 char const constexpr* const THREADS_FLAG = "net-threads";
+char const constexpr* const URING_FLAG = "io-uring";
+char const constexpr* const SYN_FLAG = "syn";
+char const constexpr* const MAX_RATE_FLAG = "max-rate";
+char const constexpr* const MIN_RATE_FLAG = "min-rate";
+char const constexpr* const STATS_FLAG = "stats-every";
+char const constexpr* const SEED_FLAG = "seed";
+char const constexpr* const TOP_PORTS_FLAG = "top-ports";
+char const constexpr* const JSON_LINES_FLAG = "json-lines";
+char const constexpr* const OUTPUT_FORMAT_FLAG = "output-format";
+char const constexpr* const OUTPUT_FILE_FLAG = "output-file";
+char const constexpr* const CHECKPOINT_FLAG = "checkpoint";
+char const constexpr* const RESUME_FLAG = "resume";
+char const constexpr* const BASELINE_FLAG = "baseline";
+char const constexpr* const SAMPLE_FLAG = "sample";
+char const constexpr* const GRAB_FLAG = "grab-banners";
+char const constexpr* const UDP_FLAG = "udp";
 
 static void handlePingSweep(bool isVerbose, ScanHandler& scanHandle)
 {
@@ -48,10 +71,19 @@ static void handlePingSweep(bool isVerbose, ScanHandler& scanHandle)
 
     auto pingComplete = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(pingComplete - pingStart);
-    std::cout << std::format("Pinged {} hosts in {}", scanHandle.getHostnames().size(), duration) << std::endl;
+    std::cout << std::format("Pinged {} hosts in {}", scanHandle.getHostCount(), duration) << std::endl;
 }
 
-static void handleTCPSweep(bool isVerbose, ScanHandler& scanHandle, std::vector<int> portNumbers)
+static void printScanResults(bool isVerbose, ScanHandler& scanHandle, size_t portCount, OutputFormat outputFormat, std::ostream& resultsStream)
+{
+    // quick fix for verbose output bieng useless if too many ports are specified.
+    // machine readable formats are left alone, whatever reads them can cope
+    bool verboseResults = isVerbose && (outputFormat != OutputFormat::Text || portCount < 64);
+    std::unique_ptr<ResultFormatter> resultFormatter = createResultFormatter(outputFormat, resultsStream, getServiceRegistry(), verboseResults);
+    scanHandle.printResults(*resultFormatter);
+}
+
+static void handleTCPSweep(bool isVerbose, ScanHandler& scanHandle, std::vector<int> portNumbers, OutputFormat outputFormat, std::ostream& resultsStream)
 {
     std::cout << "Running TCP scan against active hosts" << std::endl;
     std::cout << SPLITTER << std::endl;
@@ -63,18 +95,27 @@ static void handleTCPSweep(bool isVerbose, ScanHandler& scanHandle, std::vector<
     auto tcpComplete = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(tcpComplete - tcpStart);
 
-    std::cout << std::format("Scanned {} hosts in {}", scanHandle.getHostnames().size(), duration) << std::endl;
+    std::cout << std::format("Scanned {} hosts in {}", scanHandle.getHostCount(), duration) << std::endl;
 
+    printScanResults(isVerbose, scanHandle, portNumbers.size(), outputFormat, resultsStream);
+    scanHandle.printChanges();
+}
 
-    // quick fix for verbose output bieng useless if too many ports are specified.
-    if (isVerbose && portNumbers.size() < 64)
-    {
-        scanHandle.printResults(isVerbose);
-    }
-    else
-    {
-        scanHandle.printResults(false);
-    }
+static void handleUDPSweep(bool isVerbose, ScanHandler& scanHandle, std::vector<int> portNumbers, OutputFormat outputFormat, std::ostream& resultsStream)
+{
+    std::cout << "Running UDP scan against active hosts" << std::endl;
+    std::cout << SPLITTER << std::endl;
+
+    auto udpStart = std::chrono::high_resolution_clock::now();
+
+    scanHandle.UDPSweep(portNumbers, isVerbose);
+
+    auto udpComplete = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(udpComplete - udpStart);
+
+    std::cout << std::format("Scanned {} hosts in {}", scanHandle.getHostCount(), duration) << std::endl;
+
+    printScanResults(isVerbose, scanHandle, portNumbers.size(), outputFormat, resultsStream);
 }
 
 std::vector<CLIArg> argSetup()
@@ -83,16 +124,14 @@ std::vector<CLIArg> argSetup()
 
     // setup default ports
     // not the smartest way but it works sort of
-    std::map<int, std::string> allServices = loadKnownServices();
+    const ServiceRegistry& serviceRegistry = getServiceRegistry();
     std::vector<int> defaultPorts;
 
-    for (auto service : allServices)
+    for (int portNumber = 0; portNumber < 3500; portNumber++)
     {
-        if (service.first < 3500)
+        if (serviceRegistry.isNamed((uint16_t)portNumber, ServiceProtocol::Tcp))
         {
-            defaultPorts.push_back(
-                service.first
-            );
+            defaultPorts.push_back(portNumber);
         }
     }
 
@@ -103,7 +142,29 @@ std::vector<CLIArg> argSetup()
     CLIArg(TARGET_FLAG,true,validateTarget),
     CLIArg(PORT_FLAG,false,validatePort,defaultPorts),
     CLIArg(THREADS_FLAG,false,validateThreads, defaultThreads),
-    CLIArg(DELAY_FLAG,false,validateDelay,0)
+    CLIArg(DELAY_FLAG,false,validateDelay,0),
+    CLIArg(URING_FLAG,false),
+    CLIArg(SYN_FLAG,false),
+    CLIArg(MAX_RATE_FLAG,false,validateRate,0),
+    // shares its short flag with max-rate, so this one is long form only
+    CLIArg(MIN_RATE_FLAG,false,validateRate,0),
+    // shares its short flag with syn, so this one is long form only
+    CLIArg(STATS_FLAG,false,validateInterval,0),
+    // shares its short flag with syn, so this one is long form only
+    CLIArg(SEED_FLAG,false,validateSeed,0),
+    // shares its short flag with target, so this one is long form only
+    CLIArg(TOP_PORTS_FLAG,false,validateTopPorts,0),
+    CLIArg(JSON_LINES_FLAG,false,validateOutputPath),
+    CLIArg(OUTPUT_FORMAT_FLAG,false,validateOutputFormat),
+    // shares its short flag with output-format, so this one is long form only
+    CLIArg(OUTPUT_FILE_FLAG,false,validateOutputPath),
+    CLIArg(CHECKPOINT_FLAG,false,validateOutputPath),
+    CLIArg(RESUME_FLAG,false,validateOutputPath),
+    CLIArg(BASELINE_FLAG,false,validateOutputPath),
+    // shares its short flag with syn, so this one is long form only
+    CLIArg(SAMPLE_FLAG,false,validateSample,BASELINE_DEFAULT_SAMPLE),
+    CLIArg(GRAB_FLAG,false),
+    CLIArg(UDP_FLAG,false)
     };
 }
 
@@ -115,11 +176,11 @@ int main(int argc, char* argv[])
         displayHelp(false);
         exit(0);
     }
-    // some host resolution stuff requires a WSAStartup call first
+    // host resolution needs the platform's sockets up first (WSAStartup on Windows)
     // quit if this fails 
-    if (!windowsInit()) {
-        std:: cout << "Failed to start Windows socket, Exiting!" << std::endl;
-        windowsCleanup();
+    if (!getNetBackend().startup()) {
+        std:: cout << "Failed to start networking, Exiting!" << std::endl;
+        getNetBackend().cleanup();
         exit(1);
     }
    
@@ -130,17 +191,33 @@ int main(int argc, char* argv[])
         if (!argHandler.parseArgs(argc, argv))
         {
             displayHelp(true);
-            windowsCleanup();
+            getNetBackend().cleanup();
             exit(0);
         }
 
         // grab parsed args
         bool isVerbose = argHandler.getHandledArg(VERBOSE_FLAG).size() > 0;
         bool isFastMode = argHandler.getHandledArg(FAST_FLAG).size() > 0;
+        bool useUring = argHandler.getHandledArg(URING_FLAG).size() > 0;
+        bool useSyn = argHandler.getHandledArg(SYN_FLAG).size() > 0;
         std::vector<CLIArg> targetHosts = argHandler.getHandledArg(TARGET_FLAG);
         std::vector<CLIArg> targetPorts = argHandler.getHandledArg(PORT_FLAG);
         int netDelay = argHandler.getHandledArg(DELAY_FLAG)[0].getValueInt();
         int netThreads = argHandler.getHandledArg(THREADS_FLAG)[0].getValueInt();
+        int maxRate = argHandler.getHandledArg(MAX_RATE_FLAG)[0].getValueInt();
+        int minRate = argHandler.getHandledArg(MIN_RATE_FLAG)[0].getValueInt();
+        int statsInterval = argHandler.getHandledArg(STATS_FLAG)[0].getValueInt();
+        uint64_t scanSeed = argHandler.getHandledArg(SEED_FLAG)[0].getValueUint64();
+        int topPorts = argHandler.getHandledArg(TOP_PORTS_FLAG)[0].getValueInt();
+        std::vector<CLIArg> jsonLinesPath = argHandler.getHandledArg(JSON_LINES_FLAG);
+        std::vector<CLIArg> outputFormatName = argHandler.getHandledArg(OUTPUT_FORMAT_FLAG);
+        std::vector<CLIArg> outputFilePath = argHandler.getHandledArg(OUTPUT_FILE_FLAG);
+        std::vector<CLIArg> checkpointPath = argHandler.getHandledArg(CHECKPOINT_FLAG);
+        std::vector<CLIArg> resumePath = argHandler.getHandledArg(RESUME_FLAG);
+        std::vector<CLIArg> baselinePath = argHandler.getHandledArg(BASELINE_FLAG);
+        int samplePercent = argHandler.getHandledArg(SAMPLE_FLAG)[0].getValueInt();
+        bool grabBanners = argHandler.getHandledArg(GRAB_FLAG).size() > 0;
+        bool useUdp = argHandler.getHandledArg(UDP_FLAG).size() > 0;
 
         if (isVerbose)
         {
@@ -150,15 +227,39 @@ int main(int argc, char* argv[])
         {
             std::cout << "Running in fast mode, skipping ping sweep" << std::endl;
         }
+        if (useUring && !UringEngine::isSupported())
+        {
+            std::cout << "io_uring is not supported on this system, falling back to the poll engine" << std::endl;
+        }
+        if (useSyn && !SynScanner::isSupported())
+        {
+            std::cout << "SYN scanning needs raw sockets (Linux, root or CAP_NET_RAW), falling back to connect scanning" << std::endl;
+        }
+        // the UDP sweep replaces the TCP one, so the options that only shape the TCP sweep are dropped
+        if (useUdp && (useSyn || grabBanners || checkpointPath.size() > 0 || resumePath.size() > 0 || baselinePath.size() > 0))
+        {
+            std::cout << "SYN, banner grabbing, checkpoints and baselines only apply to TCP scans, ignoring them for the UDP scan" << std::endl;
+            useSyn = false;
+            grabBanners = false;
+            checkpointPath.clear();
+            resumePath.clear();
+            baselinePath.clear();
+        }
+        if (useUdp && !UdpScanner::isSupported())
+        {
+            std::cout << "Failed to open a UDP socket, Exiting!" << std::endl;
+            getNetBackend().cleanup();
+            exit(1);
+        }
 
-        std::vector<std::string> hostAddresses{};
+        // ranges stay as ranges, hosts are only enumerated once the scan is set up
+        TargetSpace targetSpace;
         for (CLIArg host : targetHosts)
         {
-            std::vector<std::string> expandedHost = expandNetwork(host.getValueString());
-            hostAddresses.insert(hostAddresses.end(), expandedHost.begin(), expandedHost.end());
+            expandNetwork(host.getValueString(), targetSpace);
         }
 
-        if (hostAddresses.size() == 0)
+        if (targetSpace.empty())
         {
             std::cout << "Failed to resolve any valid hosts from provided targets" << std::endl;
             exit(0);
@@ -177,16 +278,89 @@ int main(int argc, char* argv[])
                 portNumbers.push_back(port.getValueInt());
             }
         }
+        // replaces the port list rather than adding to it, the same as nmap
+        if (topPorts > 0)
+        {
+            portNumbers = getServiceRegistry().getTopPorts(topPorts, useUdp ? ServiceProtocol::Udp : ServiceProtocol::Tcp);
+            if (isVerbose)
+            {
+                std::cout << std::format("Scanning the {} ports most often found open", portNumbers.size()) << std::endl;
+            }
+        }
 
         if (isVerbose)
         {
             std::cout << std::format("Running with {} threads", netThreads) << std::endl;
             std::cout << std::format("Using a {}ms delay", netDelay) << std::endl;
+            if (maxRate > 0)
+            {
+                std::cout << std::format("Limiting to {} probes per second", maxRate) << std::endl;
+            }
+            if (minRate > 0)
+            {
+                std::cout << std::format("Keeping at least {} probes per second", minRate) << std::endl;
+            }
         }
 
-        ScanHandler scanHandle(hostAddresses, portNumbers, netThreads,netDelay);
+        ScanHandler scanHandle(targetSpace, portNumbers, netThreads,netDelay);
+        scanHandle.setBackend(useUring ? ProbeBackend::Uring : ProbeBackend::Poll);
+        scanHandle.setSynScan(useSyn && SynScanner::isSupported());
+        scanHandle.setRateLimits(maxRate, minRate);
+        scanHandle.setStatsInterval(statsInterval);
+        scanHandle.setBannerGrab(grabBanners);
+        if (scanSeed > 0)
+        {
+            scanHandle.setSeed(scanSeed);
+        }
+        // a resumed scan keeps checkpointing to the file it came from unless told otherwise
+        if (resumePath.size() > 0)
+        {
+            scanHandle.resumeScan(resumePath[0].getValueString(), targetSpace, portNumbers);
+            std::cout << std::format("Resuming from checkpoint {}", resumePath[0].getValueString()) << std::endl;
+        }
+        if (baselinePath.size() > 0)
+        {
+            scanHandle.setBaseline(baselinePath[0].getValueString(), samplePercent);
+            if (isVerbose)
+            {
+                std::cout << std::format("Rescanning against {}, sampling {}% of the probes it has nothing for", baselinePath[0].getValueString(), samplePercent) << std::endl;
+            }
+        }
+        if (checkpointPath.size() > 0 || resumePath.size() > 0)
+        {
+            scanHandle.setCheckpoint((checkpointPath.size() > 0 ? checkpointPath : resumePath)[0].getValueString(), targetSpace, portNumbers);
+        }
+        if (isVerbose)
+        {
+            std::cout << std::format("Probing in the order given by seed {}", scanHandle.getSeed()) << std::endl;
+        }
+        if (jsonLinesPath.size() > 0 && !scanHandle.openResultStream(jsonLinesPath[0].getValueString()))
+        {
+            std::cout << std::format("Failed to open {} for writing, Exiting!", jsonLinesPath[0].getValueString()) << std::endl;
+            getNetBackend().cleanup();
+            exit(1);
+        }
+
+        // the final results go to stdout unless a file was given
+        OutputFormat outputFormat = OutputFormat::Text;
+        if (outputFormatName.size() > 0)
+        {
+            parseOutputFormat(outputFormatName[0].getValueString(), outputFormat);
+        }
+        std::ofstream resultsFile;
+        if (outputFilePath.size() > 0)
+        {
+            resultsFile.open(outputFilePath[0].getValueString(), std::ios::out | std::ios::trunc | std::ios::binary);
+            if (!resultsFile.is_open())
+            {
+                std::cout << std::format("Failed to open {} for writing, Exiting!", outputFilePath[0].getValueString()) << std::endl;
+                getNetBackend().cleanup();
+                exit(1);
+            }
+        }
+        std::ostream& resultsStream = resultsFile.is_open() ? resultsFile : std::cout;
        
-        std::cout << "Targeting: " << hostAddresses.size() << " hosts" << std::endl;
+        std::cout << "Targeting: " << targetSpace.size() << " hosts" << std::endl;
         std::cout << "Targeting: " << portNumbers.size() << " ports" << std::endl;
 
         if (!isFastMode)
@@ -194,14 +368,23 @@ int main(int argc, char* argv[])
             handlePingSweep(isVerbose, scanHandle);
         }
 
-        handleTCPSweep(isVerbose, scanHandle, portNumbers);
+        if (useUdp)
+        {
+            handleUDPSweep(isVerbose, scanHandle, portNumbers, outputFormat, resultsStream);
+        }
+        else
+        {
+            handleTCPSweep(isVerbose, scanHandle, portNumbers, outputFormat, resultsStream);
+        }
+        scanHandle.closeResultStream();
+        resultsFile.close();
  
-        windowsCleanup();
+        getNetBackend().cleanup();
         exit(0);
     }
     catch (const std::exception& x)
     {
-        windowsCleanup();
+        getNetBackend().cleanup();
         std::cerr << x.what() << "\n";
         displayHelp(false);
         exit(1);
@@ -1 +0,0 @@
-#include "NetworkHandler.h"
\ No newline at end of file
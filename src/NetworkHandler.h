@@ -1,5 +0,0 @@
-#pragma once
-class NetworkHandler
-{
-};
-
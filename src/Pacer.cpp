@@ -0,0 +1,228 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// Pacer:
+// Shared send pacing, a global token bucket plus an adaptive congestion window.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "Pacer.h"
+#include <algorithm>
+#include <thread>
+#include <cmath>
+
+/// <summary>
+/// One pacer is shared by every worker in a sweep.
+/// </summary>
+/// <param name="maxRate">ceiling in probes per second, 0 for none</param>
+/// <param name="minRate">floor in probes per second the window may not throttle below, 0 for none</param>
+Pacer::Pacer(int maxRate, int minRate)
+{
+    this->maxRate = std::max(maxRate, 0);
+    this->minRate = std::max(minRate, 0);
+    if (this->maxRate > 0 && this->minRate > this->maxRate)
+    {
+        this->minRate = this->maxRate;
+    }
+    this->lastRefill = std::chrono::steady_clock::now();
+    // start with one burst banked so the first probes go straight out
+    this->maxTokens = std::max(this->maxRate * PACER_BURST_TIME / 1000.0, 1.0);
+    // a second's worth of probes at the asked for rate, so the window isn't what holds it back from the start
+    if (this->maxRate > 0)
+    {
+        this->congestionWindow = std::clamp((double)this->maxRate, PACER_INITIAL_WINDOW, PACER_MAX_WINDOW);
+    }
+}
+
+// must hold pacerLock
+void Pacer::growWindow()
+{
+    if (this->congestionWindow < this->slowStartThreshold)
+    {
+        this->congestionWindow += 1;
+    }
+    else
+    {
+        this->congestionWindow += 1 / this->congestionWindow;
+    }
+    this->congestionWindow = std::min(this->congestionWindow, PACER_MAX_WINDOW);
+}
+
+// must hold pacerLock
+void Pacer::refillTokens()
+{
+    auto timeNow = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(timeNow - this->lastRefill).count();
+    this->lastRefill = timeNow;
+    if (this->maxRate > 0)
+    {
+        double burstSize = std::max(this->maxRate * PACER_BURST_TIME / 1000.0, 1.0);
+        this->maxTokens = std::min(this->maxTokens + elapsed * this->maxRate, burstSize);
+    }
+    if (this->minRate > 0)
+    {
+        double burstSize = std::max(this->minRate * PACER_BURST_TIME / 1000.0, 1.0);
+        this->minTokens = std::min(this->minTokens + elapsed * this->minRate, burstSize);
+    }
+}
+
+/// <summary>
+/// Claim a token and a window slot for one probe, never blocks.
+/// Every successful call must be paired with onResponse, onDrop or release.
+/// A full window is overridden while the sweep is running below --min-rate.
+/// </summary>
+/// <returns>true if the probe may be sent now</returns>
+bool Pacer::tryAcquire()
+{
+    std::lock_guard<std::mutex> pacerGuard(this->pacerLock);
+    this->refillTokens();
+    if (this->maxRate > 0 && this->maxTokens < 1)
+    {
+        return false;
+    }
+    bool windowOpen = this->inFlight < (size_t)this->congestionWindow;
+    if (!windowOpen && !(this->minRate > 0 && this->minTokens >= 1))
+    {
+        return false;
+    }
+    // every send drains the floor bucket, so it only has tokens spare when we are under the floor
+    if (this->maxRate > 0)
+    {
+        this->maxTokens -= 1;
+    }
+    if (this->minRate > 0)
+    {
+        this->minTokens = std::max(this->minTokens - 1, -1.0);
+    }
+    this->inFlight++;
+    return true;
+}
+
+/// <summary>
+/// Claim a token only, for stateless senders that never learn which probe went unanswered.
+/// </summary>
+bool Pacer::tryAcquireRate()
+{
+    std::lock_guard<std::mutex> pacerGuard(this->pacerLock);
+    this->refillTokens();
+    if (this->maxRate > 0)
+    {
+        if (this->maxTokens < 1)
+        {
+            return false;
+        }
+        this->maxTokens -= 1;
+    }
+    return true;
+}
+
+/// <summary>
+/// Blocking tryAcquire for callers that wait on each probe themselves.
+/// </summary>
+void Pacer::acquire()
+{
+    while (!this->tryAcquire())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(this->getWaitTime()));
+    }
+}
+
+/// <summary>
+/// Rough time in ms until the bucket has a token again, capped at PACER_MAX_WAIT.
+/// A full window can't be predicted here, the caller should be reaping completions meanwhile.
+/// </summary>
+int Pacer::getWaitTime()
+{
+    std::lock_guard<std::mutex> pacerGuard(this->pacerLock);
+    this->refillTokens();
+    if (this->maxRate > 0 && this->maxTokens < 1)
+    {
+        int waitTime = (int)std::ceil((1 - this->maxTokens) * 1000.0 / this->maxRate);
+        return std::clamp(waitTime, 1, PACER_MAX_WAIT);
+    }
+    return 1;
+}
+
+/// <summary>
+/// The probe was answered, open or refused. Grows the window, doubling per round trip
+/// in slow start and by one probe per window after that.
+/// </summary>
+void Pacer::onResponse()
+{
+    std::lock_guard<std::mutex> pacerGuard(this->pacerLock);
+    if (this->inFlight > 0)
+    {
+        this->inFlight--;
+    }
+    this->growWindow();
+}
+
+/// <summary>
+/// The probe was lost, a timeout against a host that answers nearly everything or a reply that only came on a retry.
+/// Halves the window, at most once per PACER_DECREASE_INTERVAL so a burst of losses counts as a single event.
+/// </summary>
+void Pacer::onDrop()
+{
+    std::lock_guard<std::mutex> pacerGuard(this->pacerLock);
+    if (this->inFlight > 0)
+    {
+        this->inFlight--;
+    }
+    auto timeNow = std::chrono::steady_clock::now();
+    if (timeNow - this->lastDecrease < std::chrono::milliseconds(PACER_DECREASE_INTERVAL))
+    {
+        return;
+    }
+    this->lastDecrease = timeNow;
+    this->slowStartThreshold = std::max(this->congestionWindow / 2, PACER_MIN_WINDOW);
+    this->congestionWindow = this->slowStartThreshold;
+}
+
+/// <summary>
+/// The probe timed out where silence is the norm, a host that never answered or one that filters many of its ports,
+/// so most likely down or filtered rather than a drop. Grows the window the same as an answer, otherwise silent
+/// address space holds the sweep at the initial window for every timeout it waits out. Losses still cut it through onDrop.
+/// </summary>
+void Pacer::onSilence()
+{
+    std::lock_guard<std::mutex> pacerGuard(this->pacerLock);
+    if (this->inFlight > 0)
+    {
+        this->inFlight--;
+    }
+    this->growWindow();
+}
+
+/// <summary>
+/// Give back a slot without a verdict, e.g. a probe abandoned when the scan is stopped.
+/// </summary>
+void Pacer::release()
+{
+    std::lock_guard<std::mutex> pacerGuard(this->pacerLock);
+    if (this->inFlight > 0)
+    {
+        this->inFlight--;
+    }
+}
+
+double Pacer::getWindow()
+{
+    std::lock_guard<std::mutex> pacerGuard(this->pacerLock);
+    return this->congestionWindow;
+}
@@ -0,0 +1,69 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// Pacer:
+// Shared send pacing, a global token bucket plus an adaptive congestion window. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <mutex>
+#include <chrono>
+
+// probes allowed in flight before anything has answered, unless --max-rate asks for more
+constexpr double PACER_INITIAL_WINDOW = 64;
+// the window never shrinks below this, so a lossy path still makes progress
+constexpr double PACER_MIN_WINDOW = 16;
+constexpr double PACER_MAX_WINDOW = 65536;
+// at most one window cut per this many ms, a burst of timeouts is one congestion event
+constexpr int PACER_DECREASE_INTERVAL = 200;
+// ms worth of tokens a bucket may bank, caps the burst after an idle spell
+constexpr int PACER_BURST_TIME = 20;
+// longest a caller is told to wait in ms, so stop requests stay responsive
+constexpr int PACER_MAX_WAIT = 50;
+
+class Pacer
+{
+public:
+	Pacer(int maxRate, int minRate);
+public:
+	bool tryAcquire();
+	bool tryAcquireRate();
+	void acquire();
+	int getWaitTime();
+	void onResponse();
+	void onDrop();
+	void onSilence();
+	void release();
+	double getWindow();
+private:
+	void refillTokens();
+	void growWindow();
+private:
+	std::mutex pacerLock;
+	// probes per second, 0 leaves that side unbounded
+	int maxRate;
+	int minRate;
+	double maxTokens = 0;
+	double minTokens = 0;
+	std::chrono::steady_clock::time_point lastRefill;
+	std::chrono::steady_clock::time_point lastDecrease;
+	double congestionWindow = PACER_INITIAL_WINDOW;
+	double slowStartThreshold = PACER_MAX_WINDOW;
+	size_t inFlight = 0;
+};
@@ -0,0 +1,123 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// PortSet:
+// A set of port numbers kept as a sorted list while small and a 65536 bit map once dense.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "PortSet.h"
+#include <algorithm>
+#include <bit>
+
+/// <summary>
+/// Add a port, a no-op if it is already there. Ports usually arrive in ascending order, which appends.
+/// </summary>
+void PortSet::insert(uint16_t port)
+{
+    if (!this->portBits.empty())
+    {
+        uint64_t portMask = (uint64_t)1 << (port % 64);
+        if ((this->portBits[port / 64] & portMask) == 0)
+        {
+            this->portBits[port / 64] |= portMask;
+            this->portCount++;
+        }
+        return;
+    }
+
+    auto insertAt = this->sparsePorts.end();
+    if (!this->sparsePorts.empty() && this->sparsePorts.back() >= port)
+    {
+        insertAt = std::lower_bound(this->sparsePorts.begin(), this->sparsePorts.end(), port);
+        if (*insertAt == port)
+        {
+            return;
+        }
+    }
+    this->sparsePorts.insert(insertAt, port);
+    this->portCount++;
+    if (this->portCount > PORTSET_SPARSE_LIMIT)
+    {
+        this->makeDense();
+    }
+}
+
+bool PortSet::contains(uint16_t port) const
+{
+    if (!this->portBits.empty())
+    {
+        return (this->portBits[port / 64] >> (port % 64)) & 1;
+    }
+    return std::binary_search(this->sparsePorts.begin(), this->sparsePorts.end(), port);
+}
+
+size_t PortSet::size() const
+{
+    return this->portCount;
+}
+
+bool PortSet::empty() const
+{
+    return this->portCount == 0;
+}
+
+void PortSet::clear()
+{
+    this->sparsePorts.clear();
+    this->sparsePorts.shrink_to_fit();
+    this->portBits.clear();
+    this->portBits.shrink_to_fit();
+    this->portCount = 0;
+}
+
+/// <summary>
+/// Every member in ascending order, a bit scan over the map once the set is dense.
+/// </summary>
+std::vector<uint16_t> PortSet::getPorts() const
+{
+    if (this->portBits.empty())
+    {
+        return this->sparsePorts;
+    }
+    std::vector<uint16_t> setPorts;
+    setPorts.reserve(this->portCount);
+    for (size_t wordIndex = 0; wordIndex < PORTSET_WORDS; wordIndex++)
+    {
+        uint64_t portWord = this->portBits[wordIndex];
+        while (portWord != 0)
+        {
+            setPorts.push_back((uint16_t)(wordIndex * 64 + std::countr_zero(portWord)));
+            // drop the lowest set bit
+            portWord &= portWord - 1;
+        }
+    }
+    return setPorts;
+}
+
+void PortSet::makeDense()
+{
+    this->portBits.assign(PORTSET_WORDS, 0);
+    for (uint16_t port : this->sparsePorts)
+    {
+        this->portBits[port / 64] |= (uint64_t)1 << (port % 64);
+    }
+    this->sparsePorts.clear();
+    this->sparsePorts.shrink_to_fit();
+}
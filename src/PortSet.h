@@ -0,0 +1,53 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// PortSet:
+// A set of port numbers kept as a sorted list while small and a 65536 bit map once dense. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// one bit per possible port
+constexpr size_t PORTSET_WORDS = 65536 / 64;
+// past this many members the sorted list would outgrow the bit map, so switch over
+constexpr size_t PORTSET_SPARSE_LIMIT = PORTSET_WORDS * sizeof(uint64_t) / sizeof(uint16_t);
+
+class PortSet
+{
+public:
+	PortSet() = default;
+public:
+	void insert(uint16_t port);
+	bool contains(uint16_t port) const;
+	size_t size() const;
+	bool empty() const;
+	void clear();
+	std::vector<uint16_t> getPorts() const;
+private:
+	void makeDense();
+private:
+	// sorted and unique, only used until the set goes dense
+	std::vector<uint16_t> sparsePorts;
+	// empty until the set goes dense, then PORTSET_WORDS long
+	std::vector<uint64_t> portBits;
+	size_t portCount = 0;
+};
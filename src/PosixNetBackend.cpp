@@ -0,0 +1,331 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// PosixNetBackend:
+// NetBackend over BSD sockets, the kernel ARP table and a raw mode terminal.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "PosixNetBackend.h"
+#ifndef _WIN32
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <fcntl.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+#include <vector>
+#include <cctype>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <string.h>
+#include <errno.h>
+
+// the kernel's ARP cache, a header line and then one entry per line
+char const constexpr* const ARP_TABLE_PATH = "/proc/net/arp";
+// ATF_COM from the kernel's arp flags, set once the entry has a hardware address
+constexpr unsigned int ARP_ENTRY_COMPLETE = 0x2;
+
+// ICMP header plus a short payload, the reply echoes it back
+constexpr int ECHO_PACKET_SIZE = 16;
+constexpr uint8_t ECHO_REQUEST_TYPE = 8;
+constexpr uint8_t ECHO_REPLY_TYPE = 0;
+constexpr uint8_t ECHO_UNREACHABLE_TYPE = 3;
+
+class NetException : public std::runtime_error {
+public:
+    NetException(const std::string& message)
+        : std::runtime_error(message) {}
+};
+
+static uint16_t echoChecksum(const uint8_t* echoPacket, int packetLength)
+{
+    uint32_t checkSum = 0;
+    for (int i = 0; i + 1 < packetLength; i += 2)
+    {
+        checkSum += (uint32_t)((echoPacket[i] << 8) | echoPacket[i + 1]);
+    }
+    if (packetLength & 1)
+    {
+        checkSum += (uint32_t)echoPacket[packetLength - 1] << 8;
+    }
+    while (checkSum >> 16)
+    {
+        checkSum = (checkSum & 0xFFFF) + (checkSum >> 16);
+    }
+    return (uint16_t)~checkSum;
+}
+
+// terminal settings from before raw input was enabled, restored on every way out of the process
+static struct termios savedTerminal;
+static volatile sig_atomic_t terminalSaved = 0;
+
+static void restoreTerminal()
+{
+    if (terminalSaved)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &savedTerminal);
+    }
+}
+
+static void restoreTerminalSignal(int signalNumber)
+{
+    restoreTerminal();
+    signal(signalNumber, SIG_DFL);
+    raise(signalNumber);
+}
+
+/// <summary>
+/// Nothing to initialise for BSD sockets, but writes to a reset connection shouldn't kill the process.
+/// </summary>
+bool PosixNetBackend::startup()
+{
+    signal(SIGPIPE, SIG_IGN);
+#ifdef __linux__
+    this->wakeRead = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    this->wakeWrite = this->wakeRead;
+#else
+    int wakePipe[2];
+    if (pipe(wakePipe) == 0)
+    {
+        fcntl(wakePipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakePipe[1], F_SETFL, O_NONBLOCK);
+        this->wakeRead = wakePipe[0];
+        this->wakeWrite = wakePipe[1];
+    }
+#endif
+    return true;
+}
+
+void PosixNetBackend::cleanup()
+{
+    restoreTerminal();
+    this->rawInput = false;
+    if (this->wakeWrite >= 0 && this->wakeWrite != this->wakeRead)
+    {
+        close(this->wakeWrite);
+    }
+    if (this->wakeRead >= 0)
+    {
+        close(this->wakeRead);
+    }
+    this->wakeRead = -1;
+    this->wakeWrite = -1;
+}
+
+/// <summary>
+/// Send one echo through an unprivileged ping socket and wait for its reply.
+/// Only the fallback for when IcmpEngine can't open a socket, so this is likely to fail the same way,
+/// in which case it throws rather than report every host as down.
+/// </summary>
+/// <param name="roundTrip">set to the reply's round trip in microseconds</param>
+EchoStatus PosixNetBackend::echoHost(uint32_t targetAddr, int replyTimeout, int64_t& roundTrip)
+{
+    int echoSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP);
+    if (echoSocket < 0)
+    {
+        throw NetException("Pinging needs an ICMP socket, run as root or with CAP_NET_RAW, or skip the ping sweep with -f\n");
+    }
+    // the kernel sets the identifier on ping sockets, so only the sequence number tells our reply apart
+    static thread_local std::mt19937 sequenceEngine(std::random_device{}());
+    uint16_t echoSequence = (uint16_t)sequenceEngine();
+    uint8_t echoPacket[ECHO_PACKET_SIZE]{};
+    echoPacket[0] = ECHO_REQUEST_TYPE;
+    echoPacket[6] = (uint8_t)(echoSequence >> 8);
+    echoPacket[7] = (uint8_t)(echoSequence & 0xFF);
+    uint16_t checkSum = echoChecksum(echoPacket, ECHO_PACKET_SIZE);
+    echoPacket[2] = (uint8_t)(checkSum >> 8);
+    echoPacket[3] = (uint8_t)(checkSum & 0xFF);
+
+    sockaddr_in hostAddr{};
+    hostAddr.sin_family = AF_INET;
+    hostAddr.sin_addr.s_addr = htonl(targetAddr);
+    auto sendTime = std::chrono::steady_clock::now();
+    if (sendto(echoSocket, echoPacket, ECHO_PACKET_SIZE, 0, (sockaddr*)&hostAddr, sizeof(hostAddr)) < 0)
+    {
+        int sendError = errno;
+        close(echoSocket);
+        return sendError == EHOSTUNREACH || sendError == ENETUNREACH ? EchoStatus::Unreachable : EchoStatus::TimedOut;
+    }
+
+    auto deadline = sendTime + std::chrono::milliseconds(replyTimeout);
+    EchoStatus echoStatus = EchoStatus::TimedOut;
+    uint8_t replyBuffer[512];
+    pollfd replyPoll{ echoSocket, POLLIN, 0 };
+    while (echoStatus == EchoStatus::TimedOut)
+    {
+        int waitTime = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (waitTime <= 0 || poll(&replyPoll, 1, waitTime) <= 0)
+        {
+            break;
+        }
+        sockaddr_in sourceAddr{};
+        socklen_t sourceLen = sizeof(sourceAddr);
+        ssize_t replyLength = recvfrom(echoSocket, replyBuffer, sizeof(replyBuffer), 0, (sockaddr*)&sourceAddr, &sourceLen);
+        if (replyLength < 0)
+        {
+            if (errno == EHOSTUNREACH || errno == ENETUNREACH)
+            {
+                echoStatus = EchoStatus::Unreachable;
+            }
+            continue;
+        }
+        // Linux hands back the bare ICMP message, the BSDs keep the IP header in front of it
+        const uint8_t* replyPacket = replyBuffer;
+        if (replyLength >= 20 && (replyBuffer[0] >> 4) == 4)
+        {
+            int headerLength = (replyBuffer[0] & 0x0F) * 4;
+            replyPacket += headerLength;
+            replyLength -= headerLength;
+        }
+        if (replyLength < 8 || ntohl(sourceAddr.sin_addr.s_addr) != targetAddr)
+        {
+            continue;
+        }
+        if (replyPacket[0] == ECHO_UNREACHABLE_TYPE)
+        {
+            echoStatus = EchoStatus::Unreachable;
+        }
+        else if (replyPacket[0] == ECHO_REPLY_TYPE && ((replyPacket[6] << 8) | replyPacket[7]) == echoSequence)
+        {
+            roundTrip = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - sendTime).count();
+            echoStatus = EchoStatus::Replied;
+        }
+    }
+    close(echoSocket);
+    return echoStatus;
+}
+
+/// <summary>
+/// Find a host's MAC in the kernel's ARP table. There is no portable way to send an ARP request,
+/// but a host that just answered an echo or a connect on the local link will already be in the table.
+/// </summary>
+/// <returns>the MAC as dash separated hex, or an empty string when the host has no complete entry</returns>
+std::string PosixNetBackend::lookupMac(uint32_t targetAddr)
+{
+    std::ifstream arpTable(ARP_TABLE_PATH);
+    if (!arpTable.is_open())
+    {
+        return "";
+    }
+    in_addr hostAddr{};
+    hostAddr.s_addr = htonl(targetAddr);
+    char hostString[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &hostAddr, hostString, sizeof(hostString));
+
+    // IP address, HW type, Flags, HW address, Mask, Device, after a header line
+    std::string tableLine;
+    std::getline(arpTable, tableLine);
+    while (std::getline(arpTable, tableLine))
+    {
+        std::istringstream lineStream(tableLine);
+        std::string entryAddr, hardwareType, entryFlags, macAddr;
+        if (!(lineStream >> entryAddr >> hardwareType >> entryFlags >> macAddr) || entryAddr != hostString)
+        {
+            continue;
+        }
+        if ((std::strtoul(entryFlags.c_str(), nullptr, 16) & ARP_ENTRY_COMPLETE) == 0)
+        {
+            return "";
+        }
+        // match the formatting SendARP results get on Windows
+        for (char& macChar : macAddr)
+        {
+            macChar = macChar == ':' ? '-' : (char)toupper(macChar);
+        }
+        return macAddr;
+    }
+    return "";
+}
+
+/// <summary>
+/// Switch the terminal to unbuffered, unechoed input so single key presses can be read.
+/// Signals still work, and the old settings come back at exit or on a fatal signal.
+/// </summary>
+void PosixNetBackend::enableRawInput()
+{
+    if (this->rawInput || !isatty(STDIN_FILENO))
+    {
+        return;
+    }
+    this->rawInput = true;
+    if (!terminalSaved)
+    {
+        if (tcgetattr(STDIN_FILENO, &savedTerminal) != 0)
+        {
+            return;
+        }
+        terminalSaved = 1;
+        atexit(restoreTerminal);
+        signal(SIGINT, restoreTerminalSignal);
+        signal(SIGTERM, restoreTerminalSignal);
+    }
+    struct termios rawTerminal = savedTerminal;
+    rawTerminal.c_lflag &= ~(ICANON | ECHO);
+    rawTerminal.c_cc[VMIN] = 0;
+    rawTerminal.c_cc[VTIME] = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &rawTerminal);
+}
+
+/// <summary>
+/// Block up to waitTime ms for a key press on stdin, or until wakeConsole() is called.
+/// </summary>
+/// <returns>the key, or -1 if nothing was pressed in time or the wait was woken</returns>
+int PosixNetBackend::readKey(int waitTime)
+{
+    this->enableRawInput();
+    // once stdin is gone only the wake descriptor is left to wait on
+    struct pollfd waitPoll[2] = {
+        { this->wakeRead, POLLIN, 0 },
+        { this->inputClosed ? -1 : STDIN_FILENO, POLLIN, 0 }
+    };
+    if (poll(waitPoll, 2, waitTime) <= 0)
+    {
+        return -1;
+    }
+    if (waitPoll[0].revents != 0)
+    {
+        uint64_t wakeCount;
+        while (read(this->wakeRead, &wakeCount, sizeof(wakeCount)) > 0);
+        return -1;
+    }
+    unsigned char keyInput;
+    ssize_t readCount = read(STDIN_FILENO, &keyInput, 1);
+    if (readCount == 0)
+    {
+        this->inputClosed = true;
+    }
+    return readCount == 1 ? keyInput : -1;
+}
+
+void PosixNetBackend::wakeConsole()
+{
+    uint64_t wakeCount = 1;
+    if (this->wakeWrite >= 0)
+    {
+        write(this->wakeWrite, &wakeCount, sizeof(wakeCount));
+    }
+}
+#endif
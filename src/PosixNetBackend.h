@@ -0,0 +1,47 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// PosixNetBackend:
+// NetBackend over BSD sockets, the kernel ARP table and a raw mode terminal. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include "NetBackend.h"
+#ifndef _WIN32
+
+class PosixNetBackend : public NetBackend
+{
+public:
+	bool startup() override;
+	void cleanup() override;
+	EchoStatus echoHost(uint32_t targetAddr, int replyTimeout, int64_t& roundTrip) override;
+	std::string lookupMac(uint32_t targetAddr) override;
+	int readKey(int waitTime) override;
+	void wakeConsole() override;
+private:
+	void enableRawInput();
+private:
+	bool rawInput = false;
+	// set once stdin hits end of file, there is nothing left to wait on
+	bool inputClosed = false;
+	// eventfd on Linux, a self pipe elsewhere, readable once wakeConsole has been called
+	int wakeRead = -1;
+	int wakeWrite = -1;
+};
+#endif
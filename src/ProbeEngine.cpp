@@ -0,0 +1,78 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ProbeEngine:
+// Picks the probe backend to use, falling back when the kernel can't support the one asked for.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "ProbeEngine.h"
+#include "ConnectEngine.h"
+#include "UringEngine.h"
+#include <memory>
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/resource.h>
+#include <mutex>
+#endif
+
+/// <summary>
+/// Build an engine for the requested backend.
+/// io_uring quietly falls back to the poll engine when the kernel lacks support.
+/// </summary>
+std::unique_ptr<ProbeEngine> createProbeEngine(ProbeBackend probeBackend, int maxOutstanding, int connectTimeout)
+{
+    if (probeBackend == ProbeBackend::Uring && UringEngine::isSupported())
+    {
+        return std::make_unique<UringEngine>(maxOutstanding, connectTimeout);
+    }
+    return std::make_unique<ConnectEngine>(maxOutstanding, connectTimeout);
+}
+
+/// <summary>
+/// Every in flight probe holds a descriptor, so lift the soft fd limit to the hard limit once per process.
+/// Windows has no equivalent limit on sockets.
+/// </summary>
+void raiseDescriptorLimit()
+{
+#ifndef _WIN32
+    static std::once_flag limitFlag;
+    std::call_once(limitFlag, []() {
+        struct rlimit fdLimit;
+        if (getrlimit(RLIMIT_NOFILE, &fdLimit) == 0 && fdLimit.rlim_cur < fdLimit.rlim_max)
+        {
+            fdLimit.rlim_cur = fdLimit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &fdLimit);
+        }
+    });
+#endif
+}
+
+/// <summary>
+/// Whether a failed socket() only means the process or system has run out of descriptors for now.
+/// Those come back as probes complete, so the caller waits rather than giving up on the scan.
+/// </summary>
+bool isDescriptorShortage(int socketError)
+{
+#ifdef _WIN32
+    return socketError == WSAEMFILE || socketError == WSAENOBUFS;
+#else
+    return socketError == EMFILE || socketError == ENFILE || socketError == ENOBUFS || socketError == ENOMEM;
+#endif
+}
@@ -0,0 +1,84 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ProbeEngine:
+// Common interface for the asynchronous probe backends. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#ifdef _WIN32
+#pragma comment (lib, "Mswsock.lib")
+#include <WinSock2.h>
+#pragma comment(lib, "ws2_32")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+typedef int SOCKET;
+#endif
+
+// probes kept in flight by a single engine, each one holds a socket until it completes
+constexpr int CONNECT_MAX_OUTSTANDING = 2048;
+// time in ms before an unanswered connect is treated as filtered, used until a host has an RTT estimate
+constexpr int CONNECT_TIMEOUT = 1000;
+// upper bound in ms for a single wait on an engine
+constexpr int CONNECT_POLL_INTERVAL = 50;
+// stands in for the socket of a result that doesn't carry one, the same value as INVALID_SOCKET
+constexpr SOCKET NO_SOCKET = (SOCKET)-1;
+
+// outcome of a single probe, isOpen means connected for TCP and replied for ICMP
+// timedOut separates silence from an explicit refusal, which is what congestion control cares about
+// roundTrip is in microseconds from submit to answer, negative when there was no answer to time
+struct ProbeResult
+{
+	uint64_t probeTag = 0;
+	bool isOpen = false;
+	int errorCode = 0;
+	bool timedOut = false;
+	int64_t roundTrip = -1;
+	// the connected socket when the engine was told to keep them open, whoever takes the result owns it
+	SOCKET openSocket = NO_SOCKET;
+};
+
+enum class ProbeBackend
+{
+	Poll,
+	Uring
+};
+
+class ProbeEngine
+{
+public:
+	virtual ~ProbeEngine() = default;
+public:
+	// false when the system is out of descriptors and nothing went out, reap some probes and submit it again
+	virtual bool submit(const sockaddr* targetAddr, int addrLen, uint64_t probeTag, int probeTimeout) = 0;
+	virtual size_t poll(int waitTime, std::vector<ProbeResult>& completed) = 0;
+	virtual size_t getOutstanding() = 0;
+	virtual bool isFull() = 0;
+	// hand connected sockets back through the results instead of closing them, false if the engine can't
+	virtual bool setKeepOpen(bool /*keepOpen*/) { return false; }
+};
+
+std::unique_ptr<ProbeEngine> createProbeEngine(ProbeBackend probeBackend, int maxOutstanding, int connectTimeout);
+
+void raiseDescriptorLimit();
+bool isDescriptorShortage(int socketError);
@@ -0,0 +1,158 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ProgressReporter:
+// Console thread for a sweep, answers key presses and prints progress with rate and ETA.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "ProgressReporter.h"
+#include "NetBackend.h"
+#include <iostream>
+#include <format>
+#include <algorithm>
+#include <cmath>
+
+ProgressReporter::ProgressReporter(ScanProgress& scanProgress, int reportInterval)
+    : scanProgress(scanProgress), reportInterval(reportInterval)
+{
+}
+
+ProgressReporter::~ProgressReporter()
+{
+    this->stop();
+}
+
+void ProgressReporter::start()
+{
+    this->lastSample = std::chrono::steady_clock::now();
+    this->lastWorkDone = 0;
+    this->smoothedRate = 0;
+    this->hasRate = false;
+    this->consoleThread = std::thread(&ProgressReporter::handleConsole, this);
+}
+
+/// <summary>
+/// Mark the sweep finished and wake the console thread out of its wait so it exits straight away.
+/// </summary>
+void ProgressReporter::stop()
+{
+    if (!this->consoleThread.joinable())
+    {
+        return;
+    }
+    this->scanProgress.finish();
+    getNetBackend().wakeConsole();
+    this->consoleThread.join();
+}
+
+/// <summary>
+/// Block on the keyboard until a key, the next rate sample or the next periodic report is due.
+/// Only reads the shared counters, so workers never wait on the console.
+/// </summary>
+void ProgressReporter::handleConsole()
+{
+    using namespace std::chrono;
+    std::cout << "Press q to exit, s for status\n";
+    auto nextSample = this->lastSample + milliseconds(PROGRESS_SAMPLE_INTERVAL);
+    auto nextReport = this->reportInterval > 0 ? this->lastSample + seconds(this->reportInterval) : steady_clock::time_point::max();
+
+    while (!this->scanProgress.isFinished())
+    {
+        auto waitTime = duration_cast<milliseconds>(std::min(nextSample, nextReport) - steady_clock::now());
+        int charInput = getNetBackend().readKey((int)std::max<long long>(waitTime.count(), 0));
+
+        auto timeNow = steady_clock::now();
+        if (timeNow >= nextSample)
+        {
+            this->sampleRate(timeNow);
+            nextSample = timeNow + milliseconds(PROGRESS_SAMPLE_INTERVAL);
+        }
+        if (charInput == 'q')
+        {
+            std::cout << "Quitting Early!\n";
+            this->scanProgress.requestStop();
+            return;
+        }
+        else if (charInput == 's')
+        {
+            this->printStatus();
+        }
+        else if (charInput > 0)
+        {
+            std::cout << "Press q to exit, s for status\n";
+        }
+        if (timeNow >= nextReport && !this->scanProgress.isFinished())
+        {
+            this->printStatus();
+            nextReport = timeNow + seconds(this->reportInterval);
+        }
+    }
+}
+
+/// <summary>
+/// Fold the work done since the last sample into an exponentially smoothed rate.
+/// </summary>
+void ProgressReporter::sampleRate(std::chrono::steady_clock::time_point sampleTime)
+{
+    ProgressTotals progressTotals = this->scanProgress.getTotals();
+    uint64_t workDone = progressTotals.portsTotal > 0 ? progressTotals.portsDone : progressTotals.hostsDone;
+    double elapsed = std::chrono::duration<double>(sampleTime - this->lastSample).count();
+    if (elapsed <= 0)
+    {
+        return;
+    }
+    double sampleRate = (workDone - this->lastWorkDone) / elapsed;
+    this->smoothedRate = this->hasRate ? PROGRESS_RATE_WEIGHT * sampleRate + (1 - PROGRESS_RATE_WEIGHT) * this->smoothedRate : sampleRate;
+    this->hasRate = true;
+    this->lastSample = sampleTime;
+    this->lastWorkDone = workDone;
+}
+
+/// <summary>
+/// One status line: how far through the sweep we are, the current rate and when it should finish.
+/// Port sweeps report probes, ping sweeps report hosts.
+/// </summary>
+void ProgressReporter::printStatus()
+{
+    ProgressTotals progressTotals = this->scanProgress.getTotals();
+    bool countsPorts = progressTotals.portsTotal > 0;
+    uint64_t workDone = countsPorts ? progressTotals.portsDone : progressTotals.hostsDone;
+    uint64_t workTotal = countsPorts ? progressTotals.portsTotal : progressTotals.hostsTotal;
+    double percentDone = workTotal > 0 ? 100.0 * workDone / workTotal : 0;
+
+    std::string etaString = "--:--:--";
+    if (this->hasRate && this->smoothedRate > 0 && workTotal >= workDone)
+    {
+        uint64_t etaSeconds = (uint64_t)std::ceil((workTotal - workDone) / this->smoothedRate);
+        etaString = std::format("{:02}:{:02}:{:02}", etaSeconds / 3600, etaSeconds / 60 % 60, etaSeconds % 60);
+    }
+
+    if (countsPorts)
+    {
+        std::cout << std::format("Completed: {}/{} Ports ({:.1f}%), {} open, {} closed, {} filtered, {:.0f} probes/s, ETA {}\n",
+            workDone, workTotal, percentDone, progressTotals.portsOpen, progressTotals.portsClosed,
+            progressTotals.portsFiltered, this->smoothedRate, etaString);
+    }
+    else
+    {
+        std::cout << std::format("Completed: {}/{} Hosts ({:.1f}%), {:.0f} hosts/s, ETA {}\n",
+            workDone, workTotal, percentDone, this->smoothedRate, etaString);
+    }
+}
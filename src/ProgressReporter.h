@@ -0,0 +1,58 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ProgressReporter:
+// Console thread for a sweep, answers key presses and prints progress with rate and ETA. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include "ScanProgress.h"
+#include <thread>
+#include <chrono>
+
+// ms between rate samples, the console thread sleeps this long when nothing else is due
+constexpr int PROGRESS_SAMPLE_INTERVAL = 1000;
+// weight given to the newest sample in the smoothed rate
+constexpr double PROGRESS_RATE_WEIGHT = 0.3;
+
+class ProgressReporter
+{
+public:
+	ProgressReporter(ScanProgress& scanProgress, int reportInterval);
+	~ProgressReporter();
+	ProgressReporter(const ProgressReporter&) = delete;
+	ProgressReporter& operator=(const ProgressReporter&) = delete;
+public:
+	void start();
+	void stop();
+private:
+	void handleConsole();
+	void sampleRate(std::chrono::steady_clock::time_point sampleTime);
+	void printStatus();
+private:
+	ScanProgress& scanProgress;
+	// seconds between unprompted status lines, 0 to only print on request
+	int reportInterval;
+	std::thread consoleThread;
+	// rate state, only touched by the console thread
+	std::chrono::steady_clock::time_point lastSample;
+	uint64_t lastWorkDone = 0;
+	double smoothedRate = 0;
+	bool hasRate = false;
+};
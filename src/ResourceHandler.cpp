@@ -1 +0,0 @@
-#include "ResourceHandler.h"
@@ -0,0 +1,309 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ResultFormatter:
+// Writes scan results in the selected output format through one reusable buffer flushed in large chunks.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#include "ResultFormatter.h"
+#include "utils.h"
+#include <algorithm>
+
+ResultFormatter::ResultFormatter(std::ostream& outputStream, const ServiceRegistry& serviceRegistry, bool isVerbose)
+    : outputStream(outputStream), serviceRegistry(serviceRegistry)
+{
+    this->verboseOutput = isVerbose;
+    this->outputBuffer.reserve(OUTPUT_FLUSH_SIZE + OUTPUT_FLUSH_SIZE / 4);
+}
+
+// true when every scanned port is written rather than only the open ones
+bool ResultFormatter::isVerbose() const
+{
+    return this->verboseOutput;
+}
+
+/// <summary>
+/// Hand everything buffered to the stream in one write and keep the buffer's memory for the next batch.
+/// </summary>
+void ResultFormatter::flush()
+{
+    if (!this->outputBuffer.empty())
+    {
+        this->outputStream.write(this->outputBuffer.data(), (std::streamsize)this->outputBuffer.size());
+        this->outputBuffer.clear();
+    }
+    this->outputStream.flush();
+}
+
+// what the port's banner said it runs, or what usually runs on it when no banner was read
+std::string_view ResultFormatter::getService(const NetworkNode& targetHost, NetworkPort& hostPort) const
+{
+    const ServiceMatch* serviceMatch = targetHost.getServiceMatch(hostPort.getNumber());
+    if (serviceMatch != nullptr && !serviceMatch->serviceName.empty())
+    {
+        return serviceMatch->serviceName;
+    }
+    return hostPort.getExpectedService(this->serviceRegistry);
+}
+
+// product and version from the port's banner, empty without one
+std::string_view ResultFormatter::getVersion(const NetworkNode& targetHost, NetworkPort& hostPort) const
+{
+    const ServiceMatch* serviceMatch = targetHost.getServiceMatch(hostPort.getNumber());
+    return serviceMatch != nullptr ? std::string_view(serviceMatch->serviceVersion) : std::string_view();
+}
+
+/// <summary>
+/// The human readable listing NetMap has always printed.
+/// </summary>
+class TextFormatter : public ResultFormatter
+{
+public:
+    using ResultFormatter::ResultFormatter;
+    void beginResults() override
+    {
+        this->append("{}\n", SPLITTER);
+    }
+    void writeHost(NetworkNode& targetHost, std::vector<NetworkPort>& hostPorts) override
+    {
+        if (!this->isVerbose())
+        {
+            std::string macAddr = targetHost.getMac();
+            this->append("Host: {} ({})\n", targetHost.getName(), macAddr.empty() ? "MAC UNKNOWN" : macAddr);
+        }
+        else
+        {
+            this->append("Host: {}\n", targetHost.getName());
+        }
+        for (NetworkPort& hostPort : hostPorts)
+        {
+            // filtered TCP ports have always been listed as closed here, silent UDP ports can't be called closed
+            std::string_view serviceVersion = this->getVersion(targetHost, hostPort);
+            std::string_view portStatus = hostPort.getStatus() ? "Open"
+                : hostPort.getState() == "open|filtered" ? "Open|Filtered" : "Closed";
+            this->append("Port {}{} ({}): {}{}{}\n", hostPort.getNumber(), hostPort.getProtocol() == ServiceProtocol::Udp ? "/udp" : "",
+                this->getService(targetHost, hostPort), portStatus, serviceVersion.empty() ? "" : " ", serviceVersion);
+        }
+        this->hostsWritten++;
+    }
+    void endResults() override
+    {
+        // outside verbose mode only hosts with open ports are written
+        if (this->hostsWritten == 0 && !this->isVerbose())
+        {
+            this->append("No open ports found\n");
+        }
+        this->append("{}\n", SPLITTER);
+    }
+private:
+    size_t hostsWritten = 0;
+};
+
+/// <summary>
+/// One JSON document, an array of hosts each carrying its ports.
+/// </summary>
+class JsonFormatter : public ResultFormatter
+{
+public:
+    using ResultFormatter::ResultFormatter;
+    void beginResults() override
+    {
+        this->append("{{\"hosts\":[");
+    }
+    void writeHost(NetworkNode& targetHost, std::vector<NetworkPort>& hostPorts) override
+    {
+        std::string macAddr = targetHost.getMac();
+        this->append("{}\n{{\"addr\":\"{}\",\"mac\":", this->hostsWritten > 0 ? "," : "", targetHost.getName());
+        if (macAddr.empty())
+        {
+            this->append("null");
+        }
+        else
+        {
+            this->append("\"{}\"", macAddr);
+        }
+        this->append(",\"ports\":[");
+        for (size_t portIndex = 0; portIndex < hostPorts.size(); portIndex++)
+        {
+            this->append("{}{{\"port\":{},\"proto\":\"{}\",\"state\":\"{}\",\"service\":\"{}\"", portIndex > 0 ? "," : "",
+                hostPorts[portIndex].getNumber(), hostPorts[portIndex].getProtocolName(), hostPorts[portIndex].getState(),
+                this->getService(targetHost, hostPorts[portIndex]));
+            std::string_view serviceVersion = this->getVersion(targetHost, hostPorts[portIndex]);
+            if (!serviceVersion.empty())
+            {
+                this->append(",\"version\":\"{}\"", serviceVersion);
+            }
+            this->append("}}");
+        }
+        this->append("]}}");
+        this->hostsWritten++;
+    }
+    void endResults() override
+    {
+        this->append("\n]}}\n");
+    }
+private:
+    size_t hostsWritten = 0;
+};
+
+/// <summary>
+/// A header then one row per port, service names and cleaned up versions never hold commas or quotes so nothing is quoted.
+/// </summary>
+class CsvFormatter : public ResultFormatter
+{
+public:
+    using ResultFormatter::ResultFormatter;
+    void beginResults() override
+    {
+        this->append("addr,mac,port,proto,state,service,version\n");
+    }
+    void writeHost(NetworkNode& targetHost, std::vector<NetworkPort>& hostPorts) override
+    {
+        std::string hostName = targetHost.getName();
+        std::string macAddr = targetHost.getMac();
+        for (NetworkPort& hostPort : hostPorts)
+        {
+            this->append("{},{},{},{},{},{},{}\n", hostName, macAddr, hostPort.getNumber(), hostPort.getProtocolName(), hostPort.getState(),
+                this->getService(targetHost, hostPort), this->getVersion(targetHost, hostPort));
+        }
+    }
+    void endResults() override
+    {
+    }
+};
+
+/// <summary>
+/// nmap's -oG layout, one line per host so results can be picked out with grep and cut.
+/// </summary>
+class GrepableFormatter : public ResultFormatter
+{
+public:
+    using ResultFormatter::ResultFormatter;
+    void beginResults() override
+    {
+        this->append("# NetMap grepable output\n");
+    }
+    void writeHost(NetworkNode& targetHost, std::vector<NetworkPort>& hostPorts) override
+    {
+        this->append("Host: {} ()\tPorts: ", targetHost.getName());
+        for (size_t portIndex = 0; portIndex < hostPorts.size(); portIndex++)
+        {
+            // slashes split the fields, so the version has them swapped for pipes the way nmap does
+            std::string serviceVersion(this->getVersion(targetHost, hostPorts[portIndex]));
+            std::replace(serviceVersion.begin(), serviceVersion.end(), '/', '|');
+            this->append("{}{}/{}/{}//{}//{}/", portIndex > 0 ? ", " : "", hostPorts[portIndex].getNumber(), hostPorts[portIndex].getState(),
+                hostPorts[portIndex].getProtocolName(), this->getService(targetHost, hostPorts[portIndex]), serviceVersion);
+        }
+        this->append("\n");
+        this->hostsWritten++;
+    }
+    void endResults() override
+    {
+        this->append("# NetMap done: {} hosts listed\n", this->hostsWritten);
+    }
+private:
+    size_t hostsWritten = 0;
+};
+
+/// <summary>
+/// Elements shaped after nmap's -oX, addresses, service names and cleaned up versions hold nothing that needs escaping.
+/// </summary>
+class XmlFormatter : public ResultFormatter
+{
+public:
+    using ResultFormatter::ResultFormatter;
+    void beginResults() override
+    {
+        this->append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<netmaprun>\n");
+    }
+    void writeHost(NetworkNode& targetHost, std::vector<NetworkPort>& hostPorts) override
+    {
+        std::string macAddr = targetHost.getMac();
+        this->append("<host><status state=\"up\"/><address addr=\"{}\" addrtype=\"ipv4\"/>", targetHost.getName());
+        if (!macAddr.empty())
+        {
+            this->append("<address addr=\"{}\" addrtype=\"mac\"/>", macAddr);
+        }
+        this->append("<ports>");
+        for (NetworkPort& hostPort : hostPorts)
+        {
+            this->append("<port protocol=\"{}\" portid=\"{}\"><state state=\"{}\"/><service name=\"{}\"",
+                hostPort.getProtocolName(), hostPort.getNumber(), hostPort.getState(), this->getService(targetHost, hostPort));
+            std::string_view serviceVersion = this->getVersion(targetHost, hostPort);
+            if (!serviceVersion.empty())
+            {
+                this->append(" product=\"{}\"", serviceVersion);
+            }
+            this->append("/></port>");
+        }
+        this->append("</ports></host>\n");
+    }
+    void endResults() override
+    {
+        this->append("</netmaprun>\n");
+    }
+};
+
+/// <summary>
+/// Match a format name given on the command line.
+/// </summary>
+/// <param name="formatName">text, json, csv, grepable or xml</param>
+/// <param name="outputFormat">set to the matching format</param>
+/// <returns>false for an unknown name</returns>
+bool parseOutputFormat(std::string_view formatName, OutputFormat& outputFormat)
+{
+    constexpr std::pair<std::string_view, OutputFormat> FORMAT_NAMES[] = {
+        { "text", OutputFormat::Text },
+        { "json", OutputFormat::Json },
+        { "csv", OutputFormat::Csv },
+        { "grepable", OutputFormat::Grepable },
+        { "xml", OutputFormat::Xml },
+    };
+    for (const auto& [knownName, knownFormat] : FORMAT_NAMES)
+    {
+        if (formatName == knownName)
+        {
+            outputFormat = knownFormat;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// <summary>
+/// Build the formatter for a format, writing to the given stream.
+/// </summary>
+/// <param name="isVerbose">write every scanned port rather than only the open ones</param>
+std::unique_ptr<ResultFormatter> createResultFormatter(OutputFormat outputFormat, std::ostream& outputStream,
+    const ServiceRegistry& serviceRegistry, bool isVerbose)
+{
+    switch (outputFormat)
+    {
+    case OutputFormat::Json:
+        return std::make_unique<JsonFormatter>(outputStream, serviceRegistry, isVerbose);
+    case OutputFormat::Csv:
+        return std::make_unique<CsvFormatter>(outputStream, serviceRegistry, isVerbose);
+    case OutputFormat::Grepable:
+        return std::make_unique<GrepableFormatter>(outputStream, serviceRegistry, isVerbose);
+    case OutputFormat::Xml:
+        return std::make_unique<XmlFormatter>(outputStream, serviceRegistry, isVerbose);
+    default:
+        return std::make_unique<TextFormatter>(outputStream, serviceRegistry, isVerbose);
+    }
+}
@@ -0,0 +1,83 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ResultFormatter:
+// Writes scan results in the selected output format through one reusable buffer flushed in large chunks. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include <format>
+#include <iterator>
+#include <utility>
+#include "ScanHandler.h"
+
+// bytes gathered in the buffer before it is handed to the stream in one write
+constexpr size_t OUTPUT_FLUSH_SIZE = 64 * 1024;
+
+enum class OutputFormat
+{
+	Text,
+	Json,
+	Csv,
+	Grepable,
+	Xml
+};
+
+bool parseOutputFormat(std::string_view formatName, OutputFormat& outputFormat);
+
+class ResultFormatter
+{
+public:
+	ResultFormatter(std::ostream& outputStream, const ServiceRegistry& serviceRegistry, bool isVerbose);
+	virtual ~ResultFormatter() = default;
+	ResultFormatter(const ResultFormatter&) = delete;
+	ResultFormatter& operator=(const ResultFormatter&) = delete;
+public:
+	virtual void beginResults() = 0;
+	virtual void writeHost(NetworkNode& targetHost, std::vector<NetworkPort>& hostPorts) = 0;
+	virtual void endResults() = 0;
+	bool isVerbose() const;
+	void flush();
+protected:
+	// formats straight onto the end of the buffer, no temporary string per line
+	template <typename... Args>
+	void append(std::format_string<Args...> formatString, Args&&... formatArgs)
+	{
+		std::format_to(std::back_inserter(this->outputBuffer), formatString, std::forward<Args>(formatArgs)...);
+		if (this->outputBuffer.size() >= OUTPUT_FLUSH_SIZE)
+		{
+			this->flush();
+		}
+	}
+	std::string_view getService(const NetworkNode& targetHost, NetworkPort& hostPort) const;
+	std::string_view getVersion(const NetworkNode& targetHost, NetworkPort& hostPort) const;
+private:
+	std::string outputBuffer{};
+	std::ostream& outputStream;
+	const ServiceRegistry& serviceRegistry;
+	bool verboseOutput;
+};
+
+std::unique_ptr<ResultFormatter> createResultFormatter(OutputFormat outputFormat, std::ostream& outputStream,
+	const ServiceRegistry& serviceRegistry, bool isVerbose);
@@ -0,0 +1,197 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ResultStream:
+// Streams findings as JSON lines while a scan runs, workers queue records and one writer thread batches them out.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#include "ResultStream.h"
+#include "ServiceRegistry.h"
+#include "TargetSpace.h"
+#include <iostream>
+#include <fstream>
+#include <format>
+#include <iterator>
+#include <chrono>
+
+static int64_t unixMillis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+ResultStream::~ResultStream()
+{
+    this->close();
+}
+
+/// <summary>
+/// Start streaming to a file, or to stdout when the path is "-".
+/// An existing file is truncated, each scan writes a fresh stream.
+/// </summary>
+/// <param name="outputPath">file to write, "-" for stdout</param>
+/// <returns>false if the file couldn't be opened</returns>
+bool ResultStream::open(const std::string& outputPath)
+{
+    this->close();
+    if (outputPath == "-")
+    {
+        this->outputStream = &std::cout;
+    }
+    else
+    {
+        auto fileStream = std::make_unique<std::ofstream>(outputPath, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!fileStream->is_open())
+        {
+            return false;
+        }
+        this->outputStream = fileStream.get();
+        this->outputFile = std::move(fileStream);
+    }
+    this->queuedRecords.reserve(RESULT_QUEUE_CAPACITY);
+    this->stopRequested = false;
+    this->streamOpen = true;
+    this->writerThread = std::thread(&ResultStream::writeRecords, this);
+    return true;
+}
+
+/// <summary>
+/// Drain whatever is still queued, flush it and stop the writer. Safe to call more than once.
+/// </summary>
+void ResultStream::close()
+{
+    if (!this->streamOpen)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> queueGuard(this->queueLock);
+        this->stopRequested = true;
+    }
+    this->queueReady.notify_one();
+    this->writerThread.join();
+    this->outputFile.reset();
+    this->outputStream = nullptr;
+    this->streamOpen = false;
+}
+
+bool ResultStream::isOpen() const
+{
+    return this->streamOpen;
+}
+
+/// <summary>
+/// Report a host that answered the ping sweep. Does nothing unless the stream is open.
+/// </summary>
+void ResultStream::addHost(uint32_t packedAddr, int64_t roundTrip)
+{
+    if (this->streamOpen)
+    {
+        this->pushRecord({ ResultKind::HostUp, 0, packedAddr, roundTrip, unixMillis() });
+    }
+}
+
+/// <summary>
+/// Report an open TCP or UDP port. Does nothing unless the stream is open.
+/// </summary>
+void ResultStream::addPort(uint32_t packedAddr, uint16_t portNumber, ServiceProtocol portProtocol)
+{
+    if (this->streamOpen)
+    {
+        ResultKind resultKind = portProtocol == ServiceProtocol::Udp ? ResultKind::UdpPortOpen : ResultKind::PortOpen;
+        this->pushRecord({ resultKind, portNumber, packedAddr, -1, unixMillis() });
+    }
+}
+
+/// <summary>
+/// Queue a record for the writer, blocking while the queue is full so a slow disk or pipe
+/// holds the scan back rather than growing memory without bound.
+/// </summary>
+void ResultStream::pushRecord(const ResultRecord& resultRecord)
+{
+    bool batchReady = false;
+    {
+        std::unique_lock<std::mutex> queueGuard(this->queueLock);
+        this->queueSpace.wait(queueGuard, [this]() { return this->queuedRecords.size() < RESULT_QUEUE_CAPACITY; });
+        this->queuedRecords.push_back(resultRecord);
+        batchReady = this->queuedRecords.size() == RESULT_WRITE_BATCH;
+    }
+    if (batchReady)
+    {
+        this->queueReady.notify_one();
+    }
+}
+
+/// <summary>
+/// Writer thread, takes the whole queue at once whenever a batch has built up or the flush interval passes,
+/// formats it outside the lock and hands it to the stream in one write followed by a flush.
+/// </summary>
+void ResultStream::writeRecords()
+{
+    std::vector<ResultRecord> writeBatch;
+    writeBatch.reserve(RESULT_QUEUE_CAPACITY);
+    std::string outputBuffer;
+    bool writerDone = false;
+    while (!writerDone)
+    {
+        {
+            std::unique_lock<std::mutex> queueGuard(this->queueLock);
+            this->queueReady.wait_for(queueGuard, std::chrono::milliseconds(RESULT_FLUSH_INTERVAL), [this]() {
+                return this->stopRequested || this->queuedRecords.size() >= RESULT_WRITE_BATCH;
+            });
+            // anything queued before the stop is still in here, so this pass writes the last of it
+            writerDone = this->stopRequested;
+            writeBatch.swap(this->queuedRecords);
+        }
+        this->queueSpace.notify_all();
+        if (writeBatch.empty())
+        {
+            continue;
+        }
+        outputBuffer.clear();
+        for (const ResultRecord& resultRecord : writeBatch)
+        {
+            formatRecord(resultRecord, outputBuffer);
+        }
+        writeBatch.clear();
+        this->outputStream->write(outputBuffer.data(), (std::streamsize)outputBuffer.size());
+        this->outputStream->flush();
+    }
+}
+
+/// <summary>
+/// Append one record as a single line of JSON. Every field is a number or a plain token
+/// (dotted address, service name from known-services), so nothing needs escaping.
+/// </summary>
+void ResultStream::formatRecord(const ResultRecord& resultRecord, std::string& outputBuffer)
+{
+    std::string hostAddr = TargetSpace::formatAddress(resultRecord.packedAddr);
+    if (resultRecord.resultKind == ResultKind::HostUp)
+    {
+        std::format_to(std::back_inserter(outputBuffer), "{{\"type\":\"host\",\"time\":{},\"addr\":\"{}\",\"state\":\"up\",\"rtt_us\":{}}}\n",
+            resultRecord.foundAt, hostAddr, resultRecord.roundTrip);
+    }
+    else
+    {
+        bool udpPort = resultRecord.resultKind == ResultKind::UdpPortOpen;
+        std::format_to(std::back_inserter(outputBuffer), "{{\"type\":\"port\",\"time\":{},\"addr\":\"{}\",\"port\":{},\"proto\":\"{}\",\"state\":\"open\",\"service\":\"{}\"}}\n",
+            resultRecord.foundAt, hostAddr, resultRecord.portNumber, udpPort ? "udp" : "tcp",
+            getServiceRegistry().getName(resultRecord.portNumber, udpPort ? ServiceProtocol::Udp : ServiceProtocol::Tcp));
+    }
+}
@@ -0,0 +1,90 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ResultStream:
+// Streams findings as JSON lines while a scan runs, workers queue records and one writer thread batches them out. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <ostream>
+#include <cstdint>
+#include "ServiceRegistry.h"
+
+// records the workers may have queued before they block waiting on the writer
+constexpr size_t RESULT_QUEUE_CAPACITY = 8192;
+// queued records that wake the writer early, otherwise it wakes on the flush interval
+constexpr size_t RESULT_WRITE_BATCH = 512;
+// longest in ms a finding sits in the queue before it is written and flushed
+constexpr int RESULT_FLUSH_INTERVAL = 200;
+
+enum class ResultKind : uint8_t
+{
+	HostUp,
+	PortOpen,
+	UdpPortOpen
+};
+
+// kept small and plain so queueing one costs the workers next to nothing, the writer does the formatting
+struct ResultRecord
+{
+	ResultKind resultKind;
+	uint16_t portNumber;
+	// host order IPv4 address
+	uint32_t packedAddr;
+	// echo round trip in microseconds for host records, negative when unknown
+	int64_t roundTrip;
+	// unix time in ms the finding was made
+	int64_t foundAt;
+};
+
+class ResultStream
+{
+public:
+	ResultStream() = default;
+	~ResultStream();
+	ResultStream(const ResultStream&) = delete;
+	ResultStream& operator=(const ResultStream&) = delete;
+public:
+	bool open(const std::string& outputPath);
+	void close();
+	bool isOpen() const;
+	void addHost(uint32_t packedAddr, int64_t roundTrip);
+	void addPort(uint32_t packedAddr, uint16_t portNumber, ServiceProtocol portProtocol = ServiceProtocol::Tcp);
+private:
+	void pushRecord(const ResultRecord& resultRecord);
+	void writeRecords();
+	static void formatRecord(const ResultRecord& resultRecord, std::string& outputBuffer);
+private:
+	// set before any worker starts and cleared after they have all joined, so it is never raced
+	bool streamOpen = false;
+	std::unique_ptr<std::ostream> outputFile{};
+	std::ostream* outputStream = nullptr;
+	std::mutex queueLock;
+	std::condition_variable queueReady;
+	std::condition_variable queueSpace;
+	std::vector<ResultRecord> queuedRecords{};
+	bool stopRequested = false;
+	std::thread writerThread;
+};
@@ -0,0 +1,113 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// RttEstimator:
+// Smoothed round trip estimates per host and per /24, used to size probe timeouts.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "RttEstimator.h"
+#include <algorithm>
+#include <cmath>
+
+/// <summary>
+/// Start a scan with no estimates. Hosts are grouped into /24 subnets by address,
+/// and state is only kept for the ones that answer. Must be called before any samples are added.
+/// </summary>
+/// <param name="targetSpace">the scan's targets, has to outlive the estimator's use</param>
+/// <param name="defaultTimeout">ms to use until a host or its subnet has been measured</param>
+void RttEstimator::setHosts(const TargetSpace& targetSpace, int defaultTimeout)
+{
+    this->targetSpace = &targetSpace;
+    this->defaultTimeout = defaultTimeout;
+    for (std::array<RttStripe, RTT_LOCK_STRIPES>* rttStripes : { &this->hostStripes, &this->subnetStripes })
+    {
+        for (RttStripe& rttStripe : *rttStripes)
+        {
+            std::lock_guard<std::mutex> stripeGuard(rttStripe.stripeLock);
+            rttStripe.rttStates.clear();
+        }
+    }
+}
+
+/// <summary>
+/// Fold one sample into an estimate the way TCP does (RFC 6298) and store the resulting timeout.
+/// </summary>
+void RttEstimator::updateState(RttStripe& rttStripe, uint64_t stateKey, double roundTrip)
+{
+    std::lock_guard<std::mutex> stripeGuard(rttStripe.stripeLock);
+    auto [stateEntry, isNew] = rttStripe.rttStates.try_emplace(stateKey);
+    RttState& rttState = stateEntry->second;
+    if (isNew)
+    {
+        rttState.smoothedRtt = roundTrip;
+        rttState.rttVariance = roundTrip / 2;
+    }
+    else
+    {
+        rttState.rttVariance = 0.75 * rttState.rttVariance + 0.25 * std::fabs(rttState.smoothedRtt - roundTrip);
+        rttState.smoothedRtt = 0.875 * rttState.smoothedRtt + 0.125 * roundTrip;
+    }
+    int rttTimeout = (int)std::ceil((rttState.smoothedRtt + 4 * rttState.rttVariance) / 1000.0);
+    rttState.rttTimeout = std::clamp(rttTimeout, RTT_MIN_TIMEOUT, RTT_MAX_TIMEOUT);
+}
+
+// timeout a host or subnet has been measured at, 0 when it hasn't answered yet
+int RttEstimator::findTimeout(RttStripe& rttStripe, uint64_t stateKey)
+{
+    std::lock_guard<std::mutex> stripeGuard(rttStripe.stripeLock);
+    auto stateEntry = rttStripe.rttStates.find(stateKey);
+    return stateEntry == rttStripe.rttStates.end() ? 0 : stateEntry->second.rttTimeout;
+}
+
+/// <summary>
+/// Record a measured round trip against a host and its subnet. Safe to call from any worker.
+/// </summary>
+/// <param name="hostIndex">index of the host in the scan</param>
+/// <param name="roundTrip">time from send to answer in microseconds, negative samples are ignored</param>
+void RttEstimator::addSample(size_t hostIndex, int64_t roundTrip)
+{
+    if (roundTrip < 0 || this->targetSpace == nullptr || hostIndex >= this->targetSpace->size())
+    {
+        return;
+    }
+    this->updateState(this->hostStripes[hostIndex % RTT_LOCK_STRIPES], hostIndex, (double)roundTrip);
+    uint32_t subnetPrefix = this->targetSpace->getAddress(hostIndex) >> 8;
+    this->updateState(this->subnetStripes[subnetPrefix % RTT_LOCK_STRIPES], subnetPrefix, (double)roundTrip);
+}
+
+/// <summary>
+/// Timeout in ms for the next probe to a host, srtt + 4 * rttvar within RTT_MIN_TIMEOUT and RTT_MAX_TIMEOUT.
+/// Falls back to the subnet's estimate and then the default for hosts that haven't answered yet.
+/// </summary>
+int RttEstimator::getTimeout(size_t hostIndex)
+{
+    if (this->targetSpace == nullptr || hostIndex >= this->targetSpace->size())
+    {
+        return this->defaultTimeout;
+    }
+    int hostTimeout = this->findTimeout(this->hostStripes[hostIndex % RTT_LOCK_STRIPES], hostIndex);
+    if (hostTimeout > 0)
+    {
+        return hostTimeout;
+    }
+    uint32_t subnetPrefix = this->targetSpace->getAddress(hostIndex) >> 8;
+    int subnetTimeout = this->findTimeout(this->subnetStripes[subnetPrefix % RTT_LOCK_STRIPES], subnetPrefix);
+    return subnetTimeout > 0 ? subnetTimeout : this->defaultTimeout;
+}
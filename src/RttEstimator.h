@@ -0,0 +1,70 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// RttEstimator:
+// Smoothed round trip estimates per host and per /24, used to size probe timeouts. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <array>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include "TargetSpace.h"
+
+// bounds in ms on any timeout derived from an estimate
+constexpr int RTT_MIN_TIMEOUT = 10;
+constexpr int RTT_MAX_TIMEOUT = 3000;
+// locks shared out over the hosts and subnets by index
+constexpr size_t RTT_LOCK_STRIPES = 64;
+
+class RttEstimator
+{
+public:
+	RttEstimator() = default;
+	RttEstimator(const RttEstimator&) = delete;
+	RttEstimator& operator=(const RttEstimator&) = delete;
+public:
+	void setHosts(const TargetSpace& targetSpace, int defaultTimeout);
+	void addSample(size_t hostIndex, int64_t roundTrip);
+	int getTimeout(size_t hostIndex);
+private:
+	struct RttState
+	{
+		// both in microseconds
+		double smoothedRtt = 0;
+		double rttVariance = 0;
+		// the timeout the estimate gives in ms
+		int rttTimeout = 0;
+	};
+	// only hosts and subnets that have answered get a state, keyed by host index or /24 prefix
+	struct alignas(64) RttStripe
+	{
+		std::mutex stripeLock;
+		std::unordered_map<uint64_t, RttState> rttStates;
+	};
+	void updateState(RttStripe& rttStripe, uint64_t stateKey, double roundTrip);
+	int findTimeout(RttStripe& rttStripe, uint64_t stateKey);
+private:
+	// the scan's targets, owned by the caller, turn a host index into its subnet
+	const TargetSpace* targetSpace = nullptr;
+	std::array<RttStripe, RTT_LOCK_STRIPES> hostStripes;
+	std::array<RttStripe, RTT_LOCK_STRIPES> subnetStripes;
+	int defaultTimeout = 0;
+};
@@ -0,0 +1,265 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ScanBaseline:
+// Results of an earlier scan, used to pick which probes a rescan sends and to report what changed since.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#include "ScanBaseline.h"
+#include "ScanHandler.h"
+#include "TargetSpace.h"
+#include <fstream>
+#include <format>
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+#include <charconv>
+
+class BaselineException : public std::runtime_error {
+public:
+    BaselineException(const std::string& message)
+        : std::runtime_error(message) {}
+};
+
+static uint64_t packService(uint32_t packedAddr, uint16_t portNumber, bool isOpen)
+{
+    return (uint64_t)packedAddr << 17 | (uint64_t)portNumber << 1 | (isOpen ? 1 : 0);
+}
+
+static uint32_t serviceAddr(uint64_t knownService)
+{
+    return (uint32_t)(knownService >> 17);
+}
+
+static uint16_t servicePort(uint64_t knownService)
+{
+    return (uint16_t)(knownService >> 1);
+}
+
+// splitmix64, spreads the seeded task index so the sample has no pattern across hosts or ports
+static uint64_t mixBits(uint64_t mixValue)
+{
+    mixValue += 0x9E3779B97F4A7C15;
+    mixValue = (mixValue ^ (mixValue >> 30)) * 0xBF58476D1CE4E5B9;
+    mixValue = (mixValue ^ (mixValue >> 27)) * 0x94D049BB133111EB;
+    return mixValue ^ (mixValue >> 31);
+}
+
+/// <summary>
+/// Read an earlier scan's results as written by -o csv. Every row marks its host as having answered,
+/// and rows in the open state are the services a rescan checks on. Throws if the file can't be read.
+/// </summary>
+/// <param name="baselinePath">csv results from a previous scan, with or without verbose mode</param>
+void ScanBaseline::load(const std::string& baselinePath)
+{
+    std::ifstream baselineFile(baselinePath);
+    if (!baselineFile.is_open())
+    {
+        throw BaselineException(std::format("Failed to open baseline {}", baselinePath));
+    }
+    this->knownServices.clear();
+    std::string baselineLine;
+    size_t lineNumber = 0;
+    while (std::getline(baselineFile, baselineLine))
+    {
+        lineNumber++;
+        if (!baselineLine.empty() && baselineLine.back() == '\r')
+        {
+            baselineLine.pop_back();
+        }
+        if (baselineLine.empty() || baselineLine.starts_with("addr,"))
+        {
+            continue;
+        }
+        // addr,mac,port,proto,state,service
+        std::string_view rowFields[6];
+        std::string_view remainingLine = baselineLine;
+        size_t fieldCount = 0;
+        while (fieldCount < 6)
+        {
+            size_t fieldEnd = remainingLine.find(',');
+            rowFields[fieldCount++] = remainingLine.substr(0, fieldEnd);
+            if (fieldEnd == std::string_view::npos)
+            {
+                break;
+            }
+            remainingLine.remove_prefix(fieldEnd + 1);
+        }
+        uint32_t packedAddr = 0;
+        unsigned int portNumber = 0;
+        auto [portEnd, portError] = std::from_chars(rowFields[2].data(), rowFields[2].data() + rowFields[2].size(), portNumber);
+        if (fieldCount < 5 || !TargetSpace::parseAddress(rowFields[0], packedAddr) || portError != std::errc() || portNumber > UINT16_MAX)
+        {
+            throw BaselineException(std::format("Line {} of baseline {} is not a csv result row", lineNumber, baselinePath));
+        }
+        if (rowFields[3] != "tcp")
+        {
+            continue;
+        }
+        this->knownServices.push_back(packService(packedAddr, (uint16_t)portNumber, rowFields[4] == "open"));
+    }
+    std::sort(this->knownServices.begin(), this->knownServices.end());
+    this->baselineLoaded = true;
+}
+
+bool ScanBaseline::isLoaded() const
+{
+    return this->baselineLoaded;
+}
+
+void ScanBaseline::setSamplePercent(int samplePercent)
+{
+    this->samplePercent = std::clamp(samplePercent, 0, 100);
+}
+
+// first row for a host, or the end of the list when it wasn't in the baseline
+size_t ScanBaseline::findHost(uint32_t packedAddr) const
+{
+    auto hostRows = std::lower_bound(this->knownServices.begin(), this->knownServices.end(), packService(packedAddr, 0, false));
+    if (hostRows == this->knownServices.end() || serviceAddr(*hostRows) != packedAddr)
+    {
+        return this->knownServices.size();
+    }
+    return hostRows - this->knownServices.begin();
+}
+
+/// <summary>
+/// Get ready to pick a sweep's tasks. Call before the sweep starts, it also clears any earlier changes.
+/// </summary>
+/// <param name="targetPorts">ports in the order the sweep indexes them</param>
+/// <param name="sampleSeed">picks the sample, a different seed each night covers different tasks</param>
+void ScanBaseline::setPorts(const std::vector<int>& targetPorts, uint64_t sampleSeed)
+{
+    this->portIndexes.assign(UINT16_MAX + 1, -1);
+    for (size_t portIndex = 0; portIndex < targetPorts.size(); portIndex++)
+    {
+        this->portIndexes[(uint16_t)targetPorts[portIndex]] = (int32_t)portIndex;
+    }
+    this->seedMix = mixBits(sampleSeed);
+    this->skippedCount.store(0, std::memory_order_relaxed);
+    this->baselineChanges.clear();
+}
+
+/// <summary>
+/// Whether a rescan probes this task. Everything the baseline has a row for is probed again,
+/// which re-verifies its open services and the hosts that answered, and of the rest a seeded
+/// samplePercent is probed so new services still turn up over a few runs.
+/// </summary>
+bool ScanBaseline::isSelected(uint64_t taskIndex, uint32_t packedAddr, uint16_t portNumber) const
+{
+    if (mixBits(taskIndex ^ this->seedMix) % 100 < (uint64_t)this->samplePercent)
+    {
+        return true;
+    }
+    auto serviceRow = std::lower_bound(this->knownServices.begin(), this->knownServices.end(), packService(packedAddr, portNumber, false));
+    return serviceRow != this->knownServices.end() && serviceAddr(*serviceRow) == packedAddr && servicePort(*serviceRow) == portNumber;
+}
+
+// isSelected for a sweep's workers, counting the tasks left out, safe to call from any worker
+bool ScanBaseline::selectTask(uint64_t taskIndex, uint32_t packedAddr, uint16_t portNumber)
+{
+    if (this->isSelected(taskIndex, packedAddr, portNumber))
+    {
+        return true;
+    }
+    this->skippedCount.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+// every host the baseline has a row for, in address order
+std::vector<uint32_t> ScanBaseline::getHosts() const
+{
+    std::vector<uint32_t> baselineHosts;
+    for (uint64_t knownService : this->knownServices)
+    {
+        if (baselineHosts.empty() || baselineHosts.back() != serviceAddr(knownService))
+        {
+            baselineHosts.push_back(serviceAddr(knownService));
+        }
+    }
+    return baselineHosts;
+}
+
+uint64_t ScanBaseline::getSkippedCount() const
+{
+    return this->skippedCount.load(std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Compare one host's sweep results with the baseline and note what changed.
+/// Tasks the sweep never got to, skipped or cut short by a quit, say nothing either way.
+/// </summary>
+/// <param name="hostAnswered">whether the host replied to anything, ping or port, this sweep</param>
+/// <param name="targetPorts">ports in the order the sweep indexes them</param>
+/// <param name="portStates">the host's outcome for each entry in targetPorts</param>
+void ScanBaseline::compareHost(uint32_t packedAddr, bool hostAnswered, const std::vector<int>& targetPorts, const std::vector<TaskState>& portStates)
+{
+    size_t hostBegin = this->findHost(packedAddr);
+    size_t hostEnd = hostBegin;
+    bool hadOpen = false;
+    while (hostEnd < this->knownServices.size() && serviceAddr(this->knownServices[hostEnd]) == packedAddr)
+    {
+        hadOpen = hadOpen || (this->knownServices[hostEnd] & 1);
+        hostEnd++;
+    }
+
+    for (size_t portIndex = 0; portIndex < portStates.size(); portIndex++)
+    {
+        if (portStates[portIndex] != TaskState::Open)
+        {
+            continue;
+        }
+        uint16_t portNumber = (uint16_t)targetPorts[portIndex];
+        if (!std::binary_search(this->knownServices.begin() + hostBegin, this->knownServices.begin() + hostEnd, packService(packedAddr, portNumber, true)))
+        {
+            this->baselineChanges.push_back({ ServiceChange::New, portNumber, packedAddr });
+        }
+    }
+
+    if (hostBegin == hostEnd)
+    {
+        return;
+    }
+    bool hostProbed = false;
+    for (size_t serviceIndex = hostBegin; serviceIndex < hostEnd; serviceIndex++)
+    {
+        int32_t portIndex = this->portIndexes[servicePort(this->knownServices[serviceIndex])];
+        if (portIndex < 0 || portStates[portIndex] == TaskState::Unprobed || portStates[portIndex] == TaskState::Skipped)
+        {
+            continue;
+        }
+        hostProbed = true;
+        if ((this->knownServices[serviceIndex] & 1) && portStates[portIndex] != TaskState::Open)
+        {
+            this->baselineChanges.push_back({ hostAnswered ? ServiceChange::Closed : ServiceChange::Vanished,
+                servicePort(this->knownServices[serviceIndex]), packedAddr });
+        }
+    }
+    // a host that only ever answered with closed ports still counts as gone when it goes quiet
+    if (hostProbed && !hostAnswered && !hadOpen)
+    {
+        this->baselineChanges.push_back({ ServiceChange::Vanished, 0, packedAddr });
+    }
+}
+
+// what compareHost found, in host order
+const std::vector<BaselineChange>& ScanBaseline::getChanges() const
+{
+    return this->baselineChanges;
+}
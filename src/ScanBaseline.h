@@ -0,0 +1,81 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ScanBaseline:
+// Results of an earlier scan, used to pick which probes a rescan sends and to report what changed since. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+// percent of the tasks the baseline says nothing about that a rescan still probes
+constexpr int BASELINE_DEFAULT_SAMPLE = 10;
+
+enum class TaskState : uint8_t;
+
+enum class ServiceChange : uint8_t
+{
+	// open now and not in the baseline
+	New,
+	// open in the baseline, the host still answers but the port no longer does
+	Closed,
+	// open in the baseline on a host that no longer answers at all, port 0 for a host with no open ports
+	Vanished
+};
+
+struct BaselineChange
+{
+	ServiceChange serviceChange;
+	uint16_t portNumber;
+	uint32_t packedAddr;
+};
+
+class ScanBaseline
+{
+public:
+	ScanBaseline() = default;
+public:
+	void load(const std::string& baselinePath);
+	bool isLoaded() const;
+	void setSamplePercent(int samplePercent);
+	void setPorts(const std::vector<int>& targetPorts, uint64_t sampleSeed);
+	bool isSelected(uint64_t taskIndex, uint32_t packedAddr, uint16_t portNumber) const;
+	bool selectTask(uint64_t taskIndex, uint32_t packedAddr, uint16_t portNumber);
+	std::vector<uint32_t> getHosts() const;
+	uint64_t getSkippedCount() const;
+	void compareHost(uint32_t packedAddr, bool hostAnswered, const std::vector<int>& targetPorts, const std::vector<TaskState>& portStates);
+	const std::vector<BaselineChange>& getChanges() const;
+private:
+	size_t findHost(uint32_t packedAddr) const;
+private:
+	bool baselineLoaded = false;
+	int samplePercent = BASELINE_DEFAULT_SAMPLE;
+	// every (host, port) row of the baseline packed as address << 17 | port << 1 | open,
+	// sorted so a host's rows are one run in port order
+	std::vector<uint64_t> knownServices{};
+	// where each port sits in the sweep's port list, -1 for ports it doesn't scan
+	std::vector<int32_t> portIndexes{};
+	uint64_t seedMix = 0;
+	// tasks selectTask has left out so far, counted by every worker
+	std::atomic<uint64_t> skippedCount{ 0 };
+	std::vector<BaselineChange> baselineChanges{};
+};
@@ -0,0 +1,291 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ScanCheckpoint:
+// Saves a TCP sweep's finished work to a state file now and again so an interrupted scan can be resumed.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#include "ScanCheckpoint.h"
+#include "TaskResults.h"
+#include "SynScanner.h"
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <format>
+#include <stdexcept>
+#include <chrono>
+
+class CheckpointException : public std::runtime_error {
+public:
+    CheckpointException(const std::string& message)
+        : std::runtime_error(message) {}
+};
+
+template <typename T>
+static void writeValue(std::ofstream& checkpointFile, const T& fieldValue)
+{
+    checkpointFile.write((const char*)&fieldValue, sizeof(T));
+}
+
+template <typename T>
+static T readValue(std::ifstream& checkpointFile)
+{
+    T fieldValue{};
+    if (!checkpointFile.read((char*)&fieldValue, sizeof(T)))
+    {
+        throw CheckpointException("Checkpoint file is truncated");
+    }
+    return fieldValue;
+}
+
+ScanCheckpoint::~ScanCheckpoint()
+{
+    this->stopSaving(false);
+}
+
+/// <summary>
+/// Describe the scan about to run and where its checkpoints go, keeping any progress already loaded.
+/// </summary>
+/// <param name="checkpointPath">state file, rewritten in place at every checkpoint</param>
+/// <param name="targetSpace">targets exactly as given, a resume has to give the same ones</param>
+/// <param name="targetPorts">ports exactly as given, their order fixes the task indexes</param>
+/// <param name="scanSeed">probe order seed, a resume carries on in the same order</param>
+void ScanCheckpoint::setScan(const std::string& checkpointPath, const TargetSpace& targetSpace, const std::vector<int>& targetPorts, uint64_t scanSeed)
+{
+    this->checkpointPath = checkpointPath;
+    this->targetRanges = targetSpace.getRanges();
+    this->targetPorts = targetPorts;
+    this->scanSeed = scanSeed;
+    this->taskCount = (uint64_t)targetSpace.size() * targetPorts.size();
+}
+
+/// <summary>
+/// Read a checkpoint back. The file is laid out as: magic, version, seed, the target ranges,
+/// the ports, the task count, the chunk size and count, the done chunk bitmap and finally the open and closed task lists.
+/// Throws if the file is missing, truncated or from another version.
+/// </summary>
+void ScanCheckpoint::load(const std::string& checkpointPath)
+{
+    std::ifstream checkpointFile(checkpointPath, std::ios::in | std::ios::binary);
+    if (!checkpointFile.is_open())
+    {
+        throw CheckpointException(std::format("Failed to open checkpoint {}", checkpointPath));
+    }
+    if (readValue<uint32_t>(checkpointFile) != CHECKPOINT_MAGIC || readValue<uint32_t>(checkpointFile) != CHECKPOINT_VERSION)
+    {
+        throw CheckpointException(std::format("{} is not a checkpoint this version can read", checkpointPath));
+    }
+    this->scanSeed = readValue<uint64_t>(checkpointFile);
+    this->targetRanges.resize(readValue<uint32_t>(checkpointFile));
+    for (TargetRange& targetRange : this->targetRanges)
+    {
+        targetRange.firstAddr = readValue<uint32_t>(checkpointFile);
+        targetRange.lastAddr = readValue<uint32_t>(checkpointFile);
+    }
+    this->targetPorts.resize(readValue<uint32_t>(checkpointFile));
+    for (int& targetPort : this->targetPorts)
+    {
+        targetPort = readValue<uint16_t>(checkpointFile);
+    }
+    this->taskCount = readValue<uint64_t>(checkpointFile);
+    this->chunkSize = readValue<uint64_t>(checkpointFile);
+    this->chunkCount = readValue<uint64_t>(checkpointFile);
+    if (this->chunkSize == 0 || this->chunkCount > this->taskCount * 2 / this->chunkSize + 1)
+    {
+        throw CheckpointException(std::format("{} has a chunk layout that doesn't fit its scan", checkpointPath));
+    }
+    this->doneChunks.resize((this->chunkCount + 63) / 64);
+    for (uint64_t& doneWord : this->doneChunks)
+    {
+        doneWord = readValue<uint64_t>(checkpointFile);
+    }
+    for (std::vector<uint64_t>* answerTasks : { &this->openTasks, &this->closedTasks })
+    {
+        answerTasks->resize(readValue<uint64_t>(checkpointFile));
+        for (uint64_t& answerTask : *answerTasks)
+        {
+            answerTask = readValue<uint64_t>(checkpointFile);
+            if (answerTask >= this->taskCount)
+            {
+                throw CheckpointException(std::format("{} lists a task past the end of the scan", checkpointPath));
+            }
+        }
+    }
+    this->checkpointPath = checkpointPath;
+}
+
+/// <summary>
+/// True when a loaded checkpoint was taken with these targets and ports, so its task indexes mean the same tasks.
+/// </summary>
+bool ScanCheckpoint::matchesScan(const TargetSpace& targetSpace, const std::vector<int>& targetPorts) const
+{
+    const std::vector<TargetRange>& scanRanges = targetSpace.getRanges();
+    if (scanRanges.size() != this->targetRanges.size() || targetPorts != this->targetPorts
+        || this->taskCount != (uint64_t)targetSpace.size() * targetPorts.size())
+    {
+        return false;
+    }
+    for (size_t rangeIndex = 0; rangeIndex < scanRanges.size(); rangeIndex++)
+    {
+        if (scanRanges[rangeIndex].firstAddr != this->targetRanges[rangeIndex].firstAddr
+            || scanRanges[rangeIndex].lastAddr != this->targetRanges[rangeIndex].lastAddr)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ScanCheckpoint::isEnabled() const
+{
+    return !this->checkpointPath.empty();
+}
+
+uint64_t ScanCheckpoint::getSeed() const
+{
+    return this->scanSeed;
+}
+
+// positions per chunk the loaded checkpoint was taken with, 0 when nothing was loaded
+uint64_t ScanCheckpoint::getChunkSize() const
+{
+    return this->chunkSize;
+}
+
+/// <summary>
+/// Hand a loaded checkpoint's done chunks and answers to the sweep, so the workers pass over those chunks.
+/// </summary>
+/// <returns>how many chunks were already done</returns>
+uint64_t ScanCheckpoint::restoreTasks(TaskResults& taskResults) const
+{
+    if (this->chunkCount != taskResults.getChunkCount())
+    {
+        return 0;
+    }
+    return taskResults.restore(this->doneChunks, this->openTasks, this->closedTasks);
+}
+
+/// <summary>
+/// Start writing checkpoints of a running sweep every CHECKPOINT_INTERVAL seconds. Does nothing unless a path was set.
+/// </summary>
+/// <param name="taskResults">the sweep's results, read while the workers add to them</param>
+/// <param name="chunkSize">positions per scheduler chunk, saved so a resume chunks the same way</param>
+void ScanCheckpoint::startSaving(TaskResults& taskResults, uint64_t chunkSize)
+{
+    if (!this->isEnabled() || this->saveThread.joinable())
+    {
+        return;
+    }
+    this->taskResults = &taskResults;
+    this->chunkSize = chunkSize;
+    this->chunkCount = taskResults.getChunkCount();
+    this->stopRequested = false;
+    this->saveThread = std::thread(&ScanCheckpoint::saveLoop, this);
+}
+
+/// <summary>
+/// Stop the periodic checkpoints and write a last one.
+/// </summary>
+/// <param name="sweepComplete">false when the sweep was cut short, so SYN probes still in their grace period get sent again</param>
+void ScanCheckpoint::stopSaving(bool sweepComplete)
+{
+    if (!this->saveThread.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> saveGuard(this->saveLock);
+        this->stopRequested = true;
+    }
+    this->saveWake.notify_one();
+    this->saveThread.join();
+    this->captureTasks(sweepComplete ? 0 : SYN_GRACE_PERIOD);
+    this->writeFile();
+    this->taskResults = nullptr;
+}
+
+void ScanCheckpoint::saveLoop()
+{
+    std::unique_lock<std::mutex> saveGuard(this->saveLock);
+    while (!this->saveWake.wait_for(saveGuard, std::chrono::seconds(CHECKPOINT_INTERVAL), [this]() { return this->stopRequested; }))
+    {
+        this->captureTasks(SYN_GRACE_PERIOD);
+        this->writeFile();
+    }
+}
+
+/// <summary>
+/// Snapshot the done chunks and then the answers. Workers keep going meanwhile, but a chunk is only
+/// marked done after its answers are in, so every chunk in the bitmap has all of its answers listed.
+/// </summary>
+/// <param name="graceTime">ms SYN chunks need to have been out before they count as done, 0 at the end of a full sweep</param>
+void ScanCheckpoint::captureTasks(int graceTime)
+{
+    this->taskResults->settleChunks(graceTime);
+    this->doneChunks = this->taskResults->getDoneChunks();
+    this->taskResults->getAnswers(this->openTasks, this->closedTasks);
+}
+
+/// <summary>
+/// Write the checkpoint beside the old one and rename it over, so dying mid write leaves the last good file.
+/// </summary>
+/// <returns>false if the file couldn't be written, the scan carries on regardless</returns>
+bool ScanCheckpoint::writeFile() const
+{
+    std::string partialPath = this->checkpointPath + ".tmp";
+    {
+        std::ofstream checkpointFile(partialPath, std::ios::out | std::ios::trunc | std::ios::binary);
+        writeValue(checkpointFile, CHECKPOINT_MAGIC);
+        writeValue(checkpointFile, CHECKPOINT_VERSION);
+        writeValue(checkpointFile, this->scanSeed);
+        writeValue(checkpointFile, (uint32_t)this->targetRanges.size());
+        for (const TargetRange& targetRange : this->targetRanges)
+        {
+            writeValue(checkpointFile, targetRange.firstAddr);
+            writeValue(checkpointFile, targetRange.lastAddr);
+        }
+        writeValue(checkpointFile, (uint32_t)this->targetPorts.size());
+        for (int targetPort : this->targetPorts)
+        {
+            writeValue(checkpointFile, (uint16_t)targetPort);
+        }
+        writeValue(checkpointFile, this->taskCount);
+        writeValue(checkpointFile, this->chunkSize);
+        writeValue(checkpointFile, this->chunkCount);
+        checkpointFile.write((const char*)this->doneChunks.data(), (std::streamsize)(this->doneChunks.size() * sizeof(uint64_t)));
+        for (const std::vector<uint64_t>* answerTasks : { &this->openTasks, &this->closedTasks })
+        {
+            writeValue(checkpointFile, (uint64_t)answerTasks->size());
+            checkpointFile.write((const char*)answerTasks->data(), (std::streamsize)(answerTasks->size() * sizeof(uint64_t)));
+        }
+        if (!checkpointFile.good())
+        {
+            std::cout << std::format("Failed to write checkpoint {}\n", partialPath);
+            return false;
+        }
+    }
+    std::error_code renameError;
+    std::filesystem::rename(partialPath, this->checkpointPath, renameError);
+    if (renameError)
+    {
+        std::cout << std::format("Failed to replace checkpoint {}: {}\n", this->checkpointPath, renameError.message());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,83 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ScanCheckpoint:
+// Saves a TCP sweep's finished work to a state file now and again so an interrupted scan can be resumed. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "TargetSpace.h"
+
+// seconds between checkpoints while a sweep runs, each one copies the chunk bitmap and the answers
+constexpr int CHECKPOINT_INTERVAL = 30;
+// "NMCK" read as a little endian word, anything else is not a checkpoint
+constexpr uint32_t CHECKPOINT_MAGIC = 0x4B434D4E;
+// bumped whenever the layout changes, older files are refused rather than misread
+constexpr uint32_t CHECKPOINT_VERSION = 1;
+
+class TaskResults;
+
+class ScanCheckpoint
+{
+public:
+	ScanCheckpoint() = default;
+	~ScanCheckpoint();
+	ScanCheckpoint(const ScanCheckpoint&) = delete;
+	ScanCheckpoint& operator=(const ScanCheckpoint&) = delete;
+public:
+	void setScan(const std::string& checkpointPath, const TargetSpace& targetSpace, const std::vector<int>& targetPorts, uint64_t scanSeed);
+	void load(const std::string& checkpointPath);
+	bool matchesScan(const TargetSpace& targetSpace, const std::vector<int>& targetPorts) const;
+	bool isEnabled() const;
+	uint64_t getSeed() const;
+	uint64_t getChunkSize() const;
+	uint64_t restoreTasks(TaskResults& taskResults) const;
+	void startSaving(TaskResults& taskResults, uint64_t chunkSize);
+	void stopSaving(bool sweepComplete);
+private:
+	void saveLoop();
+	void captureTasks(int graceTime);
+	bool writeFile() const;
+private:
+	std::string checkpointPath{};
+	std::vector<TargetRange> targetRanges{};
+	std::vector<int> targetPorts{};
+	uint64_t scanSeed = 0;
+	uint64_t taskCount = 0;
+	// positions per scheduler chunk, a resume has to chunk the task order the same way
+	uint64_t chunkSize = 0;
+	uint64_t chunkCount = 0;
+	// one bit per chunk, set once every task in it has an answer or has timed out
+	std::vector<uint64_t> doneChunks{};
+	// answers are listed, a done task that isn't listed went unanswered
+	std::vector<uint64_t> openTasks{};
+	std::vector<uint64_t> closedTasks{};
+	// only valid while saving
+	TaskResults* taskResults = nullptr;
+	std::thread saveThread;
+	std::mutex saveLock;
+	std::condition_variable saveWake;
+	bool stopRequested = false;
+};
@@ -23,40 +23,51 @@
 //with this program; if not, see < https://www.gnu.org/licenses/>.
 
 #include "ScanHandler.h"
-#include "ResourceHandler.h"
-#include "resource.h"
 #include "utils.h"
+#include "ProbeEngine.h"
+#include "UringEngine.h"
+#include "TaskScheduler.h"
+#include "TaskResults.h"
+#include "ResultFormatter.h"
+#include "SynScanner.h"
+#include "Pacer.h"
+#include "RttEstimator.h"
+#include "IcmpEngine.h"
+#include "UdpScanner.h"
+#include "NetBackend.h"
+#include "ScanProgress.h"
+#include "ProgressReporter.h"
+#include "CyclicPermutation.h"
+#include "ServiceRegistry.h"
 #include <stdexcept>
 #include <format>
 #include <atomic>
-#include <conio.h>
 #include <stdio.h>
-#pragma comment (lib, "Mswsock.lib")
-#include <WinSock2.h>
-#pragma comment(lib, "ws2_32")
-#include <ws2tcpip.h>
-#include <mstcpip.h>
-#include <iphlpapi.h>
-#include<IcmpAPI.h>
+#include <string.h>
 #include <iostream>
 #include <thread>
 #include <future>
-#pragma comment(lib, "iphlpapi.lib")
 #include <algorithm>
 #include <random>
-#include <iterator>
 #include <vector>
 #include <limits.h>
-#include <sstream>
 #include <string>
-#include <map>
+#include <deque>
+#include <iterator>
+#include <unordered_map>
+#include <cerrno>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 constexpr int ICMP_MAX_TRIES = 3;
-constexpr int ICMP_DATA_SIZE = 64;
 constexpr int ICMP_REPLY_TIMEOUT = 256;
-char const constexpr* const SERVICE_FILE_PATH = "known-services";
-char const constexpr* const SERVICE_RESOURCE_PATH = "SERVICE_LIST";
-constexpr int SERVICE_RESOURCE_ID = 255;
+// probes submitted between non-blocking sweeps of the connect engine
+constexpr int CONNECT_COLLECT_INTERVAL = 64;
+// echo requests kept in flight by the io_uring ping sweep
+constexpr int URING_ECHO_OUTSTANDING = 1024;
+// a connect timeout only reads as a drop on a host that has answered this many probes for each one it let time out
+constexpr uint32_t CONNECT_LOSS_ANSWER_RATIO = 4;
 
 class NetException : public std::runtime_error {
 public:
@@ -64,31 +75,13 @@ public:
         : std::runtime_error(message) {}
 };
 
-/// <summary>
-/// run wsastartup and return hints struct for later use.
-/// only call once, if windows clean up has not been called since.
-/// </summary>
-/// <returns>addrinfo hints</returns>
-static struct addrinfo getWSA()
+// how a host a connect worker has heard from treats its probes
+struct HostReplies
 {
-    WSADATA wsaData;
-    struct addrinfo hints;
-
-    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
-    {
-        WSACleanup();
-        throw NetException(
-            "WSAStartup failed\n"
-        );
-    }
-
-    ZeroMemory(&hints, sizeof(hints));
-    hints.ai_family = AF_UNSPEC;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = IPPROTO_TCP;
+    uint32_t answeredCount = 0;
+    uint32_t timedOutCount = 0;
+};
 
-    return hints;
-}
 // Port with only a number given
 NetworkPort::NetworkPort(int portNumber)
 {
@@ -97,11 +90,12 @@ NetworkPort::NetworkPort(int portNumber)
     this->portStatus = false;
 }
 // Port with a open/close state and a error code
-NetworkPort::NetworkPort(int portNumber, bool portStatus, int portReason)
+NetworkPort::NetworkPort(int portNumber, bool portStatus, int portReason, ServiceProtocol portProtocol)
 {
     this->portNumber = portNumber;
     this->portStatus = portStatus;
     this->portReason = portReason;
+    this->portProtocol = portProtocol;
 }
 
 bool NetworkPort::getStatus()
@@ -109,11 +103,37 @@ bool NetworkPort::getStatus()
     return this->portStatus;
 }
 
+// open, closed or filtered, going by the connect error the port was reported with
+// a silent UDP port may just be ignoring the payload, so it is open|filtered the way nmap puts it
+std::string_view NetworkPort::getState()
+{
+    if (this->portStatus)
+    {
+        return "open";
+    }
+    if (this->portReason == ETIMEDOUT)
+    {
+        return this->portProtocol == ServiceProtocol::Udp ? "open|filtered" : "filtered";
+    }
+    return "closed";
+}
+
 int NetworkPort::getNumber()
 {
     return this->portNumber;
 }
 
+ServiceProtocol NetworkPort::getProtocol()
+{
+    return this->portProtocol;
+}
+
+// tcp or udp, as the output formats write it
+std::string_view NetworkPort::getProtocolName()
+{
+    return this->portProtocol == ServiceProtocol::Udp ? "udp" : "tcp";
+}
+
 /*
 Use this nifty functions to sort ports more easily.
 */
@@ -135,108 +155,97 @@ bool NetworkPort::operator>=(const NetworkPort& netPort)
     return this->portNumber >= netPort.portNumber;
 }
 
-// Given the full map of services get the service that should be present for a given port.
-std::string NetworkPort::getExpectedService(std::map<int,std::string> serviceMap)
-{
-    try
-    {
-        std::string serviceName = serviceMap.at(this->getNumber());
-        if (serviceName.size() == 0)
-        {
-            return std::string("unkown");
-        }
-        return serviceName;
-    }
-    catch (const std::exception&)
-    {
-        return std::string("unknown");
-    }
-
-}
-
-/// build the map of known services from the resource file 
-std::map<int,std::string> loadKnownServices()
+// Get the service that should be present for this port over its protocol, a view into the registry's table.
+std::string_view NetworkPort::getExpectedService(const ServiceRegistry& serviceRegistry)
 {
-    Resource ServiceResource(SERVICE_LIST,"TEXT");
-    auto resourceContents = ServiceResource.GetResourceString();
-
-    if (resourceContents.size() == 0)
-    {
-        throw NetException("Failed to load resources file\n"); 
-    }
-
-    std::istringstream serviceFile(resourceContents.data());
-    std::map<int, std::string> serviceMap;
-    std::string fileLine{};
-    
-    int res;
-    char serviceName[256];
-    char serviceType[32];
-    int portNumber;
-
-    while (std::getline(serviceFile,fileLine))
-    {
-        
-        if (fileLine[0] == '#')
-        {
-            continue;
-        }
-        res = sscanf_s(fileLine.c_str(), "%127s %d/%15s", serviceName, sizeof(serviceName), &portNumber, serviceType, sizeof(serviceType));
-        if (res == 3)
-        {
-            if (strcmp(serviceName, "unknown") != 0 && strcmp(serviceType,"tcp") == 0)
-            {
-                serviceMap[portNumber] = serviceName;
-            }
-        }
-    }
-    return serviceMap;
-}
-
-// node with a list of ports
-NetworkNode::NetworkNode(std::string hostAddress, std::vector<NetworkPort> hostPorts)
-{
-    this->networkAddress = hostAddress;
-    this->requestedPorts = hostPorts;
+    return serviceRegistry.getName((uint16_t)this->portNumber, this->portProtocol);
 }
 
-NetworkNode::NetworkNode(std::string hostAddress, std::vector<int> targetPorts, bool pingResult)
+// node with the ports it is to be scanned on, the list is shared with the rest of the scan
+NetworkNode::NetworkNode(uint32_t packedAddr, std::shared_ptr<const std::vector<int>> requestedPorts, bool pingResult)
 {
-    this->networkAddress = hostAddress;
+    this->packedAddr = packedAddr;
     this->isActive = pingResult;
-    this->requestedPorts.insert(this->requestedPorts.end(), targetPorts.begin(), targetPorts.end());
+    this->requestedPorts = requestedPorts;
 }
 
 // node with no ports but an ICMP status
-NetworkNode::NetworkNode(std::string hostAddress, bool pingResult)
+NetworkNode::NetworkNode(uint32_t packedAddr, bool pingResult)
 {
-    this->networkAddress = hostAddress;
+    this->packedAddr = packedAddr;
     this->isActive = pingResult;
 }
 
-std::string NetworkNode::getName()
+std::string NetworkNode::getName() const
 {
-    return this->networkAddress;
+    return TargetSpace::formatAddress(this->packedAddr);
 }
 
-std::vector<NetworkPort> NetworkNode::getPorts()
-{
-    return this->portResults;
-}
-
-void NetworkNode::appendPort(NetworkPort newPort)
+// reason code a port of each state is reported with, the same errors a blocking connect gives
+static int getPortReason(TaskState portState)
 {
-    this->requestedPorts.push_back(newPort);
+    return portState == TaskState::Open ? 0 : portState == TaskState::Closed ? ECONNREFUSED : ETIMEDOUT;
 }
 
-void NetworkNode::appendPorts(std::vector<NetworkPort> newPorts)
+/// <summary>
+/// Every port the host was scanned on with its result, rebuilt from the compact sets in port order.
+/// </summary>
+std::vector<NetworkPort> NetworkNode::getPorts()
 {
-    this->portResults.insert(this->portResults.end(), newPorts.begin(), newPorts.end());
+    std::vector<NetworkPort> hostPorts;
+    if (!this->scannedPorts)
+    {
+        return hostPorts;
+    }
+    TaskState unusualState = this->usualState == TaskState::Closed ? TaskState::Filtered : TaskState::Closed;
+    for (int port : *this->scannedPorts)
+    {
+        if (this->unprobedPorts.contains((uint16_t)port))
+        {
+            continue;
+        }
+        TaskState portState = this->openPorts.contains((uint16_t)port) ? TaskState::Open
+            : this->unusualPorts.contains((uint16_t)port) ? unusualState : this->usualState;
+        hostPorts.push_back(NetworkPort(port, portState == TaskState::Open, getPortReason(portState), this->portProtocol));
+    }
+    std::sort(hostPorts.begin(), hostPorts.end());
+    return hostPorts;
 }
 
-void NetworkNode::setPorts(std::vector<NetworkPort> newPorts)
+/// <summary>
+/// Store a sweep's results for this host. Whichever of closed and filtered is more common becomes
+/// the usual state and is implied, so only open ports and the exceptions take up space.
+/// </summary>
+/// <param name="scannedPorts">ports the sweep probed, shared by every host</param>
+/// <param name="portStates">outcome for each entry in scannedPorts</param>
+/// <param name="portProtocol">what the sweep probed them over</param>
+void NetworkNode::setPortResults(std::shared_ptr<const std::vector<int>> scannedPorts, const std::vector<TaskState>& portStates,
+    ServiceProtocol portProtocol)
 {
-    this->portResults = newPorts;
+    this->portProtocol = portProtocol;
+    size_t closedCount = std::count(portStates.begin(), portStates.end(), TaskState::Closed);
+    size_t filteredCount = std::count(portStates.begin(), portStates.end(), TaskState::Filtered);
+    this->usualState = filteredCount > closedCount ? TaskState::Filtered : TaskState::Closed;
+    this->openPorts.clear();
+    this->unusualPorts.clear();
+    this->unprobedPorts.clear();
+    for (size_t portIndex = 0; portIndex < portStates.size(); portIndex++)
+    {
+        uint16_t port = (uint16_t)(*scannedPorts)[portIndex];
+        if (portStates[portIndex] == TaskState::Open)
+        {
+            this->openPorts.insert(port);
+        }
+        else if (portStates[portIndex] == TaskState::Unprobed || portStates[portIndex] == TaskState::Skipped)
+        {
+            this->unprobedPorts.insert(port);
+        }
+        else if (portStates[portIndex] != this->usualState)
+        {
+            this->unusualPorts.insert(port);
+        }
+    }
+    this->scannedPorts = std::move(scannedPorts);
 }
 
 void NetworkNode::setActive()
@@ -249,22 +258,22 @@ bool NetworkNode::getActive()
     return this->isActive;
 }
 
+// open ports in ascending order, a scan of the host's open set
 std::vector<NetworkPort> NetworkNode::getActivePorts()
 {
     std::vector<NetworkPort> activePorts;
-    for (NetworkPort port : this->portResults)
+    activePorts.reserve(this->openPorts.size());
+    for (uint16_t port : this->openPorts.getPorts())
     {
-        if (port.getStatus())
-        {
-            activePorts.push_back(port);
-        }
+        activePorts.push_back(NetworkPort(port, true, 0, this->portProtocol));
     }
     return activePorts;
 }
 
-std::vector<NetworkPort> NetworkNode::getRequestedPorts()
+const std::vector<int>& NetworkNode::getRequestedPorts() const
 {
-    return this->requestedPorts;
+    static const std::vector<int> noPorts;
+    return this->requestedPorts ? *this->requestedPorts : noPorts;
 }
 
 void NetworkNode::setMac(std::string macAddr)
@@ -277,536 +286,1054 @@ std::string NetworkNode::getMac()
     return this->macAddr;
 }
 
-ScanHandler::ScanHandler(std::vector<std::string> targetAddresses, std::vector<int> targetPorts, int maxThreads, int networkDelay)
+// host order IPv4 address
+uint32_t NetworkNode::getPackedAddr() const
 {
-    this->maxThreads = maxThreads;
-    this->networkDelay = networkDelay;
-    this->hostNames = targetAddresses;
-    ScanMonitor scanValues = this->scanMonitor.load();
-    scanValues.networkDelay = this->networkDelay;
-    this->scanMonitor.store(scanValues);
-    this->serviceMap = loadKnownServices();
-    for (std::string hostAddress : targetAddresses)
-    {
-        this->targetHosts.push_back(
-            NetworkNode(hostAddress, targetPorts, false)
-        );
-    }
+    return this->packedAddr;
+}
+
+void NetworkNode::addServiceMatch(ServiceMatch serviceMatch)
+{
+    this->serviceMatches.push_back(std::move(serviceMatch));
 }
 
-bool handleConsole(std::atomic<ScanMonitor>& scanMonitor)
+// what the port's banner identified, nullptr when none was read
+const ServiceMatch* NetworkNode::getServiceMatch(int portNumber) const
 {
-    std::cout << "Press q to exit, s for status\n";
-    while (true)
+    for (const ServiceMatch& serviceMatch : this->serviceMatches)
     {
-        ScanMonitor scanValues = scanMonitor.load();
-        if (!scanValues.threadsEnabled)
-        {
-            return 0;
-        }
-        int charInput = _kbhit() ? _getch() : -1;
-        if (charInput == 'q')
-        {
-            std::cout << "Quitting Early!\n";
-            scanValues.threadsEnabled = false;
-            scanMonitor.store(scanValues);
-            return 0;
-        }
-        else if (charInput == 's')
-        {
-            std::cout << std::format("Completed: {} Hosts, {} Ports\n", scanValues.hostsDone, scanValues.portsDone);
-        }
-        else if (charInput > 0)
+        if (serviceMatch.portNumber == portNumber)
         {
-            std::cout << "Press q to exit, s for status\n";
+            return &serviceMatch;
         }
     }
+    return nullptr;
 }
 
-static std::string ARPHost(std::string targetHost)
+/// <summary>
+/// Build a host's socket address with the port left at 0, so probes only have to patch the port.
+/// </summary>
+/// <returns>length of the address written</returns>
+static int getSocketAddr(uint32_t packedAddr, sockaddr_storage& socketAddr)
 {
-    DWORD arpRetVal;
-    ULONG macAddr[2];
-    ULONG macAddrLen = 6;
-    sockaddr_in addr = {};
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    BYTE *macFormated;
-
-    std::ostringstream macString{};
+    memset(&socketAddr, 0, sizeof(socketAddr));
+    sockaddr_in* hostAddr = (sockaddr_in*)&socketAddr;
+    hostAddr->sin_family = AF_INET;
+    hostAddr->sin_addr.s_addr = htonl(packedAddr);
+    return sizeof(sockaddr_in);
+}
 
-    if (inet_pton(AF_INET, targetHost.c_str(), &addr.sin_addr) != 1)
+// swap the port in a resolved address, the only per probe work left before connecting
+static void setAddrPort(sockaddr_storage& socketAddr, int port)
+{
+    if (socketAddr.ss_family == AF_INET6)
     {
-        throw NetException(std::format("Failed to convert address: {}", targetHost));
+        ((sockaddr_in6*)&socketAddr)->sin6_port = htons((uint16_t)port);
     }
-    
-    arpRetVal = SendARP(addr.sin_addr.s_addr, INADDR_ANY, &macAddr, &macAddrLen);
-    if (arpRetVal == NO_ERROR)
+    else
     {
-        if (macAddrLen == 0)
-        {
-            return "";
-        }
-        else
-        {
-            macFormated = (BYTE*)&macAddr;
-            for (size_t i = 0; i < (int) macAddrLen; i++)
-            {
-                if (i == (macAddrLen - 1)) {
-                    macString << std::format("{:02X}", macFormated[i]);
-                }
-                else
-                {
-                    macString << std::format("{:02X}-", macFormated[i]);
-                }
-            }
-        }
-        return macString.str();
+        ((sockaddr_in*)&socketAddr)->sin_port = htons((uint16_t)port);
     }
-    else
+}
+
+ScanHandler::ScanHandler(const TargetSpace& targetSpace, std::vector<int> targetPorts, int maxThreads, int networkDelay)
+    : targetSpace(targetSpace), serviceRegistry(getServiceRegistry())
+{
+    this->maxThreads = maxThreads;
+    this->networkDelay = networkDelay;
+    // a full 64 bits like --seed takes, and never 0 since that asks for a random one
+    std::random_device randomDevice;
+    while (this->scanSeed == 0)
     {
-        switch (arpRetVal)
-        {
-        case ERROR_BAD_NET_NAME:
-            throw NetException("ARP target could not be resolved");
-        case ERROR_NOT_SUPPORTED:
-            throw NetException("ARP is not supported on this device");
-        default:
-            return "";
-        }
+        this->scanSeed = (uint64_t)randomDevice() << 32 | randomDevice();
     }
+    this->targetPorts = std::make_shared<const std::vector<int>>(targetPorts);
+    // nodes are made as hosts turn up, a big range costs nothing until something in it answers
+    this->rttEstimator.setHosts(this->targetSpace, CONNECT_TIMEOUT);
+}
 
+// the host's node, made on first use
+NetworkNode& ScanHandler::getNode(size_t hostIndex)
+{
+    return this->targetHosts.try_emplace(hostIndex, this->targetSpace.getAddress(hostIndex), this->targetPorts, false).first->second;
 }
 
 /// <summary>
-/// Ping a single host and return its status
+/// Ping a single host and return its status.
+/// Fallback for when no ICMP socket can be opened, each echo blocks until its reply or timeout.
 /// </summary>
-/// <param name="targetHost">host to ping</param>
+/// <param name="hostAddr">host order IPv4 address to ping</param>
+/// <param name="roundTrip">set to the reply's round trip in microseconds</param>
 /// <returns>true if ICMP is replied to, false if no reply is given or error occurs</returns>
-static bool pingHost(std::string targetHost, std::string& macAddr)
+static bool pingHost(uint32_t hostAddr, std::string& macAddr, int64_t& roundTrip)
 {
-    int currentAttempts = 0;
-    sockaddr_in addr = {};
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-
-    HANDLE ICMPFile;
-    ICMPFile = IcmpCreateFile();
-
-    void* replyBuffer = nullptr;
-    std::string macString{};
-
-    if (inet_pton(AF_INET, targetHost.c_str(), &addr.sin_addr) != 1)
-    {
-        throw NetException(std::format("Failed to convert address: {}", targetHost));
-    }
-
-    unsigned long IPAddr = addr.sin_addr.s_addr;
-
-    if (IPAddr == INADDR_NONE)
+    NetBackend& netBackend = getNetBackend();
+    for (int currentAttempts = 0; currentAttempts < ICMP_MAX_TRIES; currentAttempts++)
     {
-        return false;
+        EchoStatus echoStatus = netBackend.echoHost(hostAddr, ICMP_REPLY_TIMEOUT, roundTrip);
+        if (echoStatus == EchoStatus::Replied)
+        {
+            macAddr = netBackend.lookupMac(hostAddr);
+            return true;
+        }
+        else if (echoStatus == EchoStatus::Unreachable)
+        {
+            return false;
+        }
     }
+    return false;
+}
 
-    while (currentAttempts < ICMP_MAX_TRIES)
+/// <summary>
+/// Ping a worker's share of the hosts one at a time.
+/// </summary>
+/// <returns>one result per host that replied</returns>
+static std::vector<PingResult> pingHosts(int workerId, CyclicPermutation::Cursor hostCursor, const TargetSpace& targetSpace,
+    Pacer& scanPacer, ScanProgress& scanProgress, ResultStream& resultStream)
+{
+    std::vector<PingResult> pingResults;
+    uint64_t hostIndex = 0;
+    while (hostCursor.next(hostIndex))
     {
-        std::string sendData = randomString(ICMP_DATA_SIZE);
-        DWORD replySize = sizeof(ICMP_ECHO_REPLY) + sendData.size();
-        replyBuffer = malloc(replySize);
-
-        if (replyBuffer == nullptr)
+        if (!scanProgress.isRunning())
         {
-            throw NetException("Failed to allocate memory for ping attempt\n");
+            break;
         }
-
-        DWORD replyCount = IcmpSendEcho(
-            ICMPFile, IPAddr, (void*)sendData.c_str(), sendData.size(), NULL,
-            replyBuffer, replySize, ICMP_REPLY_TIMEOUT
-        );
-        PICMP_ECHO_REPLY echoReply = (PICMP_ECHO_REPLY)replyBuffer;
-
-        if (replyCount != 0)
+        uint32_t hostAddr = targetSpace.getAddress(hostIndex);
+        PingResult pingResult{ hostIndex };
+        scanPacer.acquire();
+        // silence here is far more likely a down host than a drop
+        if (pingHost(hostAddr, pingResult.macAddr, pingResult.roundTrip))
         {
-            if (echoReply->Status == IP_SUCCESS)
-            {
-                macAddr = ARPHost(targetHost.c_str());
-                return true;
-            }
-            else if (echoReply->Status == IP_DEST_HOST_UNREACHABLE)
-            {
-                return false;
-            }
-            std::cout << std::format("Got non standard error: {} for host: {}", echoReply->Status, targetHost) << std::endl;
-            return false;
+            scanPacer.onResponse();
+            resultStream.addHost(hostAddr, pingResult.roundTrip);
+            pingResults.push_back(std::move(pingResult));
+        }
+        else
+        {
+            scanPacer.onSilence();
         }
-        int errorCode = GetLastError();
-        currentAttempts++;
+        scanProgress.addHosts(workerId, 1);
     }
-    if (replyBuffer != nullptr)
+    return pingResults;
+}
+
+/// <summary>
+/// Ping every host through one ICMP socket, a paced sender streaming echoes while a receiver thread matches replies.
+/// Retries are driven by the engine's timeout queue rather than blocking on each host.
+/// </summary>
+/// <returns>one result per host that replied</returns>
+static std::vector<PingResult> pingHostsIcmp(const TargetSpace& targetSpace, const CyclicPermutation& pingOrder,
+    Pacer& scanPacer, ScanProgress& scanProgress, ResultStream& resultStream)
+{
+    IcmpEngine icmpEngine(ICMP_REPLY_TIMEOUT, ICMP_MAX_TRIES);
+    std::vector<EchoResult> echoResults = icmpEngine.sweep(targetSpace, pingOrder, scanPacer,
+        [&scanProgress]() { return scanProgress.isRunning(); },
+        [&scanProgress](int hostsFinished) { scanProgress.addHosts(0, hostsFinished); },
+        [&resultStream, &targetSpace](uint32_t hostIndex, int64_t roundTrip) { resultStream.addHost(targetSpace.getAddress(hostIndex), roundTrip); });
+
+    std::vector<PingResult> pingResults;
+    pingResults.reserve(echoResults.size());
+    for (const EchoResult& echoResult : echoResults)
     {
-        free(replyBuffer);
+        pingResults.push_back({ echoResult.hostIndex, getNetBackend().lookupMac(targetSpace.getAddress(echoResult.hostIndex)), echoResult.roundTrip });
     }
-    return false;
+    return pingResults;
 }
 
-static std::vector<tempResult> pingHosts(std::vector<std::string> targetHosts, std::atomic<ScanMonitor>& scanMonitor)
+/// <summary>
+/// Ping every host from one thread through io_uring, retrying silent hosts up to ICMP_MAX_TRIES.
+/// Echoes go out in batches and replies come back through a shared ICMP socket.
+/// Hosts are read off the permutation as the engine has room, only echoes in flight are tracked.
+/// </summary>
+/// <returns>one result per host that replied</returns>
+static std::vector<PingResult> pingHostsUring(const TargetSpace& targetSpace, const CyclicPermutation& pingOrder,
+    Pacer& scanPacer, ScanProgress& scanProgress, ResultStream& resultStream)
 {
-    std::vector<tempResult> pingResults;
-    for (std::string host : targetHosts)
+    UringEngine echoEngine(URING_ECHO_OUTSTANDING, ICMP_REPLY_TIMEOUT);
+    // tries so far for each host with an echo in flight or a retry queued
+    std::unordered_map<size_t, int> hostAttempts;
+    std::deque<size_t> retryHosts;
+    std::vector<PingResult> pingResults;
+    CyclicPermutation::Cursor hostCursor = pingOrder.getCursor(0, pingOrder.getCycleLength());
+    uint64_t nextHost = 0;
+    bool hostsLeft = hostCursor.next(nextHost);
+
+    std::vector<ProbeResult> completed;
+    while ((hostsLeft || !retryHosts.empty() || echoEngine.getOutstanding() > 0) && scanProgress.isRunning())
     {
-        ScanMonitor scanValues = scanMonitor.load();
-        if (scanValues.threadsEnabled == true)
+        while ((hostsLeft || !retryHosts.empty()) && !echoEngine.isFull() && scanPacer.tryAcquire())
         {
-            std::string macAddr;
-            bool pingResult = pingHost(host,macAddr);
-            pingResults.push_back(
-                { host,pingResult,macAddr }
-            );
-            std::this_thread::sleep_for(std::chrono::milliseconds(scanValues.networkDelay));
-            scanValues = scanMonitor.load();
-            scanValues.hostsDone += 1;
-            scanMonitor.store(scanValues);
+            size_t hostIndex;
+            if (!retryHosts.empty())
+            {
+                hostIndex = retryHosts.front();
+                retryHosts.pop_front();
+            }
+            else
+            {
+                hostIndex = (size_t)nextHost;
+                hostsLeft = hostCursor.next(nextHost);
+            }
+            hostAttempts[hostIndex]++;
+            sockaddr_in hostAddr{};
+            hostAddr.sin_family = AF_INET;
+            hostAddr.sin_addr.s_addr = htonl(targetSpace.getAddress(hostIndex));
+            echoEngine.submitEcho(&hostAddr, hostIndex);
+        }
+        completed.clear();
+        int waitTime = (!hostsLeft && retryHosts.empty()) || echoEngine.isFull() ? CONNECT_POLL_INTERVAL : scanPacer.getWaitTime();
+        if (echoEngine.getOutstanding() > 0)
+        {
+            echoEngine.poll(waitTime, completed);
         }
         else
         {
-            return pingResults;
+            std::this_thread::sleep_for(std::chrono::milliseconds(waitTime));
+        }
+        int hostsFinished = 0;
+        for (ProbeResult& echoResult : completed)
+        {
+            size_t hostIndex = (size_t)echoResult.probeTag;
+            auto hostEntry = hostAttempts.find(hostIndex);
+            if (echoResult.isOpen)
+            {
+                // a reply that needed a retry means an earlier echo was lost somewhere
+                if (hostEntry->second > 1)
+                {
+                    scanPacer.onDrop();
+                }
+                else
+                {
+                    scanPacer.onResponse();
+                }
+                hostAttempts.erase(hostEntry);
+                pingResults.push_back({ hostIndex, std::string(), echoResult.roundTrip });
+                resultStream.addHost(targetSpace.getAddress(hostIndex), echoResult.roundTrip);
+                hostsFinished++;
+                continue;
+            }
+            scanPacer.onSilence();
+            if (hostEntry->second < ICMP_MAX_TRIES)
+            {
+                retryHosts.push_back(hostIndex);
+            }
+            else
+            {
+                hostAttempts.erase(hostEntry);
+                hostsFinished++;
+            }
+        }
+        if (hostsFinished > 0)
+        {
+            scanProgress.addHosts(0, hostsFinished);
         }
     }
+
+    for (PingResult& pingResult : pingResults)
+    {
+        pingResult.macAddr = getNetBackend().lookupMac(targetSpace.getAddress(pingResult.hostIndex));
+    }
     return pingResults;
 }
 
 void ScanHandler::pingSweep(bool isVerbose)
 {
-    int hostCount = this->hostNames.size();
+    size_t hostCount = this->targetSpace.size();
     int finalThreads = this->maxThreads;
-    int pingRange;
 
     // disable threading when number of hosts is too smal
-    if (hostCount < finalThreads)
+    if (hostCount < (size_t)finalThreads)
     {
         finalThreads = 1;
-        pingRange = hostCount;
         if (isVerbose)
         {
             std::cout << "Too many threads for host count, disabling multithreading." << std::endl;
         }
     }
-    else
+
+    // one shard per pinging thread, the single socket sweeps only use the first
+    this->scanProgress.begin(this->maxThreads, hostCount, 0);
+    ProgressReporter progressReporter(this->scanProgress, this->statsInterval);
+    progressReporter.start();
+    // each worker hands back only the hosts that replied, silent hosts take no memory
+    std::vector<std::future<std::vector<PingResult>>> futures;
+    Pacer scanPacer(this->getRateLimit(1), this->minRate);
+    // hosts go out in a seeded random order so no subnet sees its echoes back to back
+    CyclicPermutation pingOrder(this->targetSpace.size(), this->scanSeed);
+
+    // a single io_uring or ICMP socket thread keeps more echoes in flight than the whole thread pool
+    if (this->probeBackend == ProbeBackend::Uring && UringEngine::isSupported())
     {
-        pingRange = (hostCount + finalThreads - 1) / finalThreads;
+        finalThreads = 0;
+        futures.push_back(
+            std::async(std::launch::async, pingHostsUring, std::cref(this->targetSpace), std::cref(pingOrder),
+                std::ref(scanPacer), std::ref(this->scanProgress), std::ref(this->resultStream))
+        );
     }
-
-    std::thread consoleThread(handleConsole, std::ref(this->scanMonitor));
-    std::vector<std::future<std::vector<tempResult>>> futures;
-    std::vector<std::string> pingTargets = this->hostNames;
-
-    auto rd = std::random_device();
-    auto rng = std::default_random_engine{ rd() };
-
-    for (size_t i = 0; i < finalThreads; i++)
+    else if (IcmpEngine::isSupported())
     {
-        std::vector<std::string> threadHosts;
-        std::sample(
-            pingTargets.begin(),
-            pingTargets.end(),
-            std::back_inserter(threadHosts),
-            pingRange,
-            std::mt19937{ std::random_device{}() }
+        finalThreads = 0;
+        futures.push_back(
+            std::async(std::launch::async, pingHostsIcmp, std::cref(this->targetSpace), std::cref(pingOrder),
+                std::ref(scanPacer), std::ref(this->scanProgress), std::ref(this->resultStream))
         );
+    }
 
-        for (std::string host : threadHosts)
-        {
-            pingTargets.erase(
-                std::remove(pingTargets.begin(), pingTargets.end(), host), pingTargets.end()
-            );
-        }
-        std::shuffle(threadHosts.begin(), threadHosts.end(), rng);
+    // each thread walks its own run of the cycle, which still lands all over the host list
+    uint64_t cycleLength = pingOrder.getCycleLength();
+    uint64_t pingRange = finalThreads > 0 ? (cycleLength + finalThreads - 1) / finalThreads : 0;
+    for (int i = 0; i < finalThreads; i++)
+    {
+        uint64_t rangeBegin = std::min(i * pingRange, cycleLength);
+        uint64_t rangeEnd = std::min(rangeBegin + pingRange, cycleLength);
         futures.push_back(
-            std::async(std::launch::async, pingHosts, threadHosts, std::ref(this->scanMonitor))
+            std::async(std::launch::async, pingHosts, i, pingOrder.getCursor(rangeBegin, rangeEnd),
+                std::cref(this->targetSpace), std::ref(scanPacer), std::ref(this->scanProgress), std::ref(this->resultStream))
         );
     }
-    int pingCount = 0;
-    for (auto& pingFuture: futures)
+    for (auto& pingFuture : futures)
     {
-        std::vector<tempResult> futureResult = pingFuture.get();
-        
-        for (size_t i = 0; i < futureResult.size(); i++)
+        for (PingResult& pingResult : pingFuture.get())
         {
-            for (NetworkNode& testedHost : this->targetHosts)
-            {
-                if (testedHost.getName() == futureResult[i].hostAddress)
-                {
-                    testedHost.setActive();
-                    testedHost.setMac(futureResult[i].macAddr);
-                }
-            }
-            pingCount++;
+            NetworkNode& targetHost = this->getNode(pingResult.hostIndex);
+            targetHost.setActive();
+            targetHost.setMac(std::move(pingResult.macAddr));
+            // echo replies seed the timeouts the TCP sweep starts with
+            this->rttEstimator.addSample(pingResult.hostIndex, pingResult.roundTrip);
         }
-        if (pingCount == hostCount)
-        {
-            ScanMonitor scanVals = this->scanMonitor.load();
-            scanVals.threadsEnabled = false;
-            this->scanMonitor.store(scanVals);
-            consoleThread.join();
-        }
-    }
-    if (consoleThread.joinable())
-    {
-        consoleThread.join();
     }
-    windowsCleanup();
+    progressReporter.stop();
 }
 
-static int scanPort(std::string targetHost, int targetPort, addrinfo scanHints)
+// a socket an engine handed back that no one took
+static void closeResultSocket(SOCKET resultSocket)
 {
-    SOCKET connectionSocket = INVALID_SOCKET;
-    struct addrinfo* result = NULL, * ptr = NULL;
-
-    std::string portString = std::to_string(targetPort);
-    if (getaddrinfo(targetHost.c_str(), portString.c_str(), (addrinfo*) &scanHints, &result) != 0)
-    {
-        freeaddrinfo(result);
-        WSACleanup();
-        throw NetException(std::format("Host resolution failed for host: {}\n",targetHost));
-    }
-    ptr = result;
-    connectionSocket = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
-
-
-    // disable lingering connection
-    // not sure this has that much of an impact
-    struct linger l;
-    l.l_onoff = 1;
-    l.l_linger = 0;
-
-    setsockopt(connectionSocket, SOL_SOCKET, SO_LINGER, (const char*)&l, sizeof(l));
-
-    /*
-    Override the default SYN attempt count to 0.
-    This is CRITICAL to performance and reduces overall network time 
-    by a factor of 10. dug around nmap to find this.
-    */
-    TCP_INITIAL_RTO_PARAMETERS params = { 1000, /* overall round trip time*/ TCP_INITIAL_RTO_NO_SYN_RETRANSMISSIONS};
-    DWORD dwval = 0;
-    WSAIoctl(connectionSocket, SIO_TCP_INITIAL_RTO, &params, sizeof(params), NULL, 0, &dwval, NULL, NULL);
-
-    
-    if (connectionSocket == INVALID_SOCKET)
-    {
-        freeaddrinfo(result);
-        WSACleanup();
-        throw NetException(std::format("Failed to create socket with error: {}\n",WSAGetLastError()));
-    }
-    int connectionResult = connect(connectionSocket, ptr->ai_addr, (int)ptr->ai_addrlen);
-    closesocket(connectionSocket);
-    freeaddrinfo(result);
-    return connectionResult;
+#ifdef _WIN32
+    closesocket(resultSocket);
+#else
+    close(resultSocket);
+#endif
 }
 
-static NetworkNode scanHost(std::string targetHost, std::vector<int> targetPorts, addrinfo hints, std::atomic<ScanMonitor>& scanMonitor)
+/// <summary>
+/// Move finished probes out of the engine into the sweep's results and report them to the pacer.
+/// Probe tags are the scheduler's task index, answers are recorded before the probe's chunk can count as done.
+/// A timeout only counts as a drop on a host that answers nearly every probe. Anywhere else it is most likely
+/// a filtered port or a down host and opens the window like an answer, so a firewall that drops some ports
+/// on an otherwise live host doesn't pin the window.
+/// Open ports go on to the banner grabber when there is one, with their socket if the engine kept it open.
+/// </summary>
+static void collectProbes(ProbeEngine& probeEngine, int waitTime, std::vector<ProbeResult>& completed,
+    TaskScheduler& taskScheduler, const TargetSpace& targetSpace, const std::vector<int>& targetPorts, Pacer& scanPacer,
+    RttEstimator& rttEstimator, std::unordered_map<size_t, HostReplies>& hostReplies, TaskResults& taskResults, ChunkTracker& chunkTracker, int workerId,
+    ScanProgress& scanProgress, ResultStream& resultStream, BannerGrabber* bannerGrabber)
 {
-    std::vector<NetworkPort> portResults{};
-    for (int port : targetPorts)
+    completed.clear();
+    probeEngine.poll(waitTime, completed);
+    for (ProbeResult& probeResult : completed)
     {
-        if (!scanMonitor.load().threadsEnabled)
+        size_t taskIndex = (size_t)probeResult.probeTag;
+        size_t hostIndex = taskScheduler.getHostIndex(taskIndex);
+        if (!probeResult.timedOut)
         {
-            return NetworkNode(targetHost, portResults);
+            hostReplies[hostIndex].answeredCount++;
+            scanPacer.onResponse();
+            rttEstimator.addSample(hostIndex, probeResult.roundTrip);
+            taskResults.addAnswer(taskIndex, probeResult.isOpen);
         }
-        int portRes = scanPort(targetHost, port, hints);
-        bool portOpen = false;
-        if (portRes == 0)
+        else
         {
-            portOpen = true;
+            // hosts that never answered get no entry, silent address space takes no room
+            auto hostEntry = hostReplies.find(hostIndex);
+            bool isLoss = false;
+            if (hostEntry != hostReplies.end())
+            {
+                hostEntry->second.timedOutCount++;
+                isLoss = hostEntry->second.answeredCount >= CONNECT_LOSS_ANSWER_RATIO * hostEntry->second.timedOutCount;
+            }
+            if (isLoss)
+            {
+                scanPacer.onDrop();
+            }
+            else
+            {
+                scanPacer.onSilence();
+            }
         }
-        portResults.push_back(
-            NetworkPort(port, portOpen, portRes)
-        );
-    }
-    return NetworkNode(
-        targetHost, portResults
-    );
-}
-
-static std::vector<NetworkNode> scanHosts(std::vector<std::string> targetHosts, std::vector<int> targetPorts, addrinfo hints,std::atomic<ScanMonitor>& scanMonitor)
-{
-    std::vector<NetworkNode> hostResults{};
-    for(std::string host: targetHosts)
-    {
-        if (!scanMonitor.load().threadsEnabled)
+        chunkTracker.finishProbe(taskIndex);
+        scanProgress.addProbe(workerId, probeResult.isOpen ? ProbeOutcome::Open
+            : probeResult.timedOut ? ProbeOutcome::Filtered : ProbeOutcome::Closed);
+        if (probeResult.isOpen)
         {
-            return hostResults;
+            uint16_t portNumber = (uint16_t)targetPorts[taskScheduler.getPortIndex(taskIndex)];
+            resultStream.addPort(targetSpace.getAddress(hostIndex), portNumber);
+            if (bannerGrabber != nullptr && probeResult.openSocket != NO_SOCKET)
+            {
+                bannerGrabber->addSocket((uint32_t)hostIndex, portNumber, probeResult.openSocket);
+                probeResult.openSocket = NO_SOCKET;
+            }
+            else if (bannerGrabber != nullptr)
+            {
+                bannerGrabber->addTarget((uint32_t)hostIndex, targetSpace.getAddress(hostIndex), portNumber);
+            }
         }
-        hostResults.push_back(
-            scanHost(host, targetPorts, hints, std::ref(scanMonitor))
-        );
-
-        ScanMonitor scanVals = scanMonitor.load();
-        if (scanVals.networkDelay > 0)
+        // a kept socket with no grabber to take it is closed rather than leaked
+        if (probeResult.openSocket != NO_SOCKET)
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(scanVals.networkDelay));
+            closeResultSocket(probeResult.openSocket);
         }
-
     }
-    ScanMonitor scanVals = scanMonitor.load();
-    scanVals.portsDone += targetPorts.size();
-    scanMonitor.store(scanVals);
-    return hostResults;
 }
 
-void ScanHandler::printResults(bool isVerbose) {
-    std::cout << SPLITTER << std::endl;
-    bool allClosed = true;
-    for (NetworkNode &targetHost: this->targetHosts)
+/// <summary>
+/// Worker loop for a TCP sweep, pulls (host, port) chunks from the scheduler until none are left.
+/// Connects are asynchronous and multiplexed through one probe engine per worker,
+/// so each worker keeps up to CONNECT_MAX_OUTSTANDING probes on the wire at once.
+/// </summary>
+static void scanTasks(int workerId, TaskScheduler& taskScheduler, const TargetSpace& targetSpace,
+    const std::vector<int>& targetPorts, ProbeBackend probeBackend, Pacer& scanPacer, RttEstimator& rttEstimator,
+    TaskResults& taskResults, ScanBaseline* scanBaseline, ScanProgress& scanProgress, ResultStream& resultStream, BannerGrabber* bannerGrabber)
+{
+    std::unique_ptr<ProbeEngine> probeEngine = getNetBackend().createProbeEngine(probeBackend, CONNECT_MAX_OUTSTANDING, CONNECT_TIMEOUT);
+    // saves the grabber connecting again, engines that can't keep sockets leave it to connect by itself
+    if (bannerGrabber != nullptr)
     {
-        std::vector<NetworkPort> activePorts = targetHost.getActivePorts();
-        if (!isVerbose) {
-
-            if (activePorts.size() == 0)
+        probeEngine->setKeepOpen(true);
+    }
+    // answers and timeouts from the hosts this worker has heard from, to tell a drop from a filtered port
+    std::unordered_map<size_t, HostReplies> hostReplies;
+    ChunkTracker chunkTracker(taskResults);
+    std::vector<ProbeResult> completed;
+    ScanTask scanTask;
+    int sinceCollect = 0;
+
+    while (scanProgress.isRunning() && taskScheduler.nextTask(workerId, scanTask))
+    {
+        // done before a resume
+        if (taskResults.isChunkDone(scanTask.chunkIndex))
+        {
+            continue;
+        }
+        chunkTracker.openChunk(scanTask.chunkIndex);
+        size_t lastHost = SIZE_MAX;
+        sockaddr_storage probeAddr{};
+        int probeAddrLen = 0;
+        TaskCursor taskCursor = taskScheduler.getCursor(scanTask);
+        uint64_t taskIndex = 0;
+        while (taskCursor.next(taskIndex))
+        {
+            if (!scanProgress.isRunning())
             {
-
+                break;
+            }
+            size_t hostIndex = taskScheduler.getHostIndex(taskIndex);
+            int port = targetPorts[taskScheduler.getPortIndex(taskIndex)];
+            // left out of a baseline rescan, it still counts towards progress
+            if (scanBaseline != nullptr && !scanBaseline->selectTask(taskIndex, targetSpace.getAddress(hostIndex), (uint16_t)port))
+            {
+                scanProgress.addPorts(workerId, 1);
                 continue;
             }
-            allClosed = false;
-
-            if (targetHost.getMac().size() > 0)
+            // tasks come in permutation order so the host rarely repeats, but a one host scan still saves the copy
+            if (hostIndex != lastHost)
             {
-                std::cout << std::format("Host: {} ({})", targetHost.getName(), targetHost.getMac()) << std::endl;
+                lastHost = hostIndex;
+                probeAddrLen = getSocketAddr(targetSpace.getAddress(hostIndex), probeAddr);
             }
-            else
+            // keep the engine saturated but never past its capacity
+            while (probeEngine->isFull())
             {
-                std::cout << std::format("Host: {} (MAC UNKNOWN)", targetHost.getName()) << std::endl;
+                collectProbes(*probeEngine, CONNECT_POLL_INTERVAL, completed, taskScheduler, targetSpace, targetPorts, scanPacer, rttEstimator, hostReplies, taskResults, chunkTracker, workerId, scanProgress, resultStream, bannerGrabber);
             }
-
-            std::sort(activePorts.begin(), activePorts.end());
-
-            for (NetworkPort activePort : activePorts)
+            // the pacer holds us back on rate or window, keep reaping meanwhile so our own slots come back
+            while (!scanPacer.tryAcquire() && scanProgress.isRunning())
             {
-                std::cout << std::format("Port {} ({}): Open", activePort.getNumber(),
-                    activePort.getExpectedService(this->serviceMap)) << std::endl;
-
+                if (probeEngine->getOutstanding() > 0)
+                {
+                    collectProbes(*probeEngine, scanPacer.getWaitTime(), completed, taskScheduler, targetSpace, targetPorts, scanPacer, rttEstimator, hostReplies, taskResults, chunkTracker, workerId, scanProgress, resultStream, bannerGrabber);
+                }
+                else
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(scanPacer.getWaitTime()));
+                }
             }
-        }
-        else {
-            std::vector<NetworkPort> netPorts = targetHost.getPorts();
-            if (netPorts.size() > 0)
+            if (!scanProgress.isRunning())
+            {
+                break;
+            }
+
+            setAddrPort(probeAddr, port);
+            // filtered ports cost a few round trips to this host rather than a fixed second
+            // out of descriptors, keep the pacer slot and reap until finished probes give some back
+            bool isSubmitted;
+            while (!(isSubmitted = probeEngine->submit((const sockaddr*)&probeAddr, probeAddrLen, taskIndex, rttEstimator.getTimeout(hostIndex)))
+                && scanProgress.isRunning())
             {
-                std::cout << std::format("Host: {}", targetHost.getName()) << std::endl;
-                for (NetworkPort netPort : netPorts)
+                if (probeEngine->getOutstanding() > 0)
                 {
-                    if (netPort.getStatus()) {
-                        std::cout << std::format("Port {} ({}): Open", netPort.getNumber(),
-                            netPort.getExpectedService(this->serviceMap)) << std::endl;
-                        allClosed = false;
-                    }
-                    else if (isVerbose && !netPort.getStatus())
-                    {
-                        std::cout << std::format("Port {} ({}): Closed",
-                            netPort.getNumber(), netPort.getExpectedService(this->serviceMap)) << std::endl;
-                    }
+                    collectProbes(*probeEngine, CONNECT_POLL_INTERVAL, completed, taskScheduler, targetSpace, targetPorts, scanPacer, rttEstimator, hostReplies, taskResults, chunkTracker, workerId, scanProgress, resultStream, bannerGrabber);
                 }
+                else
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(CONNECT_POLL_INTERVAL));
+                }
+            }
+            if (!isSubmitted)
+            {
+                scanPacer.release();
+                break;
+            }
+            chunkTracker.addProbe(taskIndex, scanTask.chunkIndex);
 
+            // reap finished probes now and again so deadlines are honoured while still filling up
+            if (++sinceCollect >= CONNECT_COLLECT_INTERVAL)
+            {
+                sinceCollect = 0;
+                collectProbes(*probeEngine, 0, completed, taskScheduler, targetSpace, targetPorts, scanPacer, rttEstimator, hostReplies, taskResults, chunkTracker, workerId, scanProgress, resultStream, bannerGrabber);
             }
         }
-
+        // a walk cut short leaves the chunk open, so a resume probes it again
+        if (scanProgress.isRunning())
+        {
+            chunkTracker.closeChunk(scanTask.chunkIndex);
+        }
     }
-    if (allClosed && !isVerbose)
+
+    while (probeEngine->getOutstanding() > 0 && scanProgress.isRunning())
     {
-        std::cout << "No open ports found" << std::endl;
+        collectProbes(*probeEngine, CONNECT_POLL_INTERVAL, completed, taskScheduler, targetSpace, targetPorts, scanPacer, rttEstimator, hostReplies, taskResults, chunkTracker, workerId, scanProgress, resultStream, bannerGrabber);
     }
-    std::cout << SPLITTER << std::endl;
 }
 
-void ScanHandler::TCPSweep(std::vector<int> targetPorts, bool isVerbose)
+/// <summary>
+/// Write the results through the chosen formatter. Hosts with nothing to report are left out,
+/// which outside verbose mode means every host without an open port.
+/// </summary>
+void ScanHandler::printResults(ResultFormatter& resultFormatter)
 {
-    int finalThreads = this->maxThreads;
-
-    // Divide hosts across threads
-
-    std::vector<std::vector<std::string>> threadHosts(finalThreads);
-    for (size_t i = 0; i < this->hostNames.size(); ++i) {
-        threadHosts[i % finalThreads].push_back(this->hostNames[i]);
+    resultFormatter.beginResults();
+    for (auto& [hostIndex, targetHost] : this->targetHosts)
+    {
+        std::vector<NetworkPort> hostPorts = resultFormatter.isVerbose() ? targetHost.getPorts() : targetHost.getActivePorts();
+        if (hostPorts.empty())
+        {
+            continue;
+        }
+        resultFormatter.writeHost(targetHost, hostPorts);
     }
+    resultFormatter.endResults();
+    resultFormatter.flush();
+}
 
-    // Divide ports across threads
-    std::vector<std::vector<int>> threadPorts(finalThreads);
-    for (size_t i = 0; i < targetPorts.size(); ++i) {
-        threadPorts[i % finalThreads].push_back(targetPorts[i]);
+/// <summary>
+/// SYN sweep worker, pulls chunks from the scheduler and fires one raw SYN per task.
+/// Nothing is tracked per probe, the receiver thread matches replies back by probe id
+/// and a chunk counts as done once its replies have had SYN_GRACE_PERIOD to land.
+/// </summary>
+static void sendSynTasks(int workerId, TaskScheduler& taskScheduler, const TargetSpace& targetSpace,
+    const std::vector<int>& targetPorts, SynScanner& synScanner, Pacer& scanPacer, TaskResults& taskResults, ScanBaseline* scanBaseline,
+    std::atomic<uint64_t>& synsSent, ScanProgress& scanProgress)
+{
+    uint64_t workerSent = 0;
+    ScanTask scanTask;
+    while (scanProgress.isRunning() && taskScheduler.nextTask(workerId, scanTask))
+    {
+        // done before a resume
+        if (taskResults.isChunkDone(scanTask.chunkIndex))
+        {
+            continue;
+        }
+        TaskCursor taskCursor = taskScheduler.getCursor(scanTask);
+        uint64_t taskIndex = 0;
+        while (scanProgress.isRunning() && taskCursor.next(taskIndex))
+        {
+            uint32_t packedAddr = targetSpace.getAddress(taskScheduler.getHostIndex(taskIndex));
+            uint16_t port = (uint16_t)targetPorts[taskScheduler.getPortIndex(taskIndex)];
+            // the outcome is counted when the reply lands, or as filtered once the sweep is over
+            scanProgress.addPorts(workerId, 1);
+            // left out of a baseline rescan
+            if (scanBaseline != nullptr && !scanBaseline->selectTask(taskIndex, packedAddr, port))
+            {
+                continue;
+            }
+            // no completions to learn from, so only the rate limit applies
+            while (!scanPacer.tryAcquireRate())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(scanPacer.getWaitTime()));
+            }
+            synScanner.sendProbe(packedAddr, port, (uint32_t)taskIndex);
+            workerSent++;
+        }
+        if (scanProgress.isRunning())
+        {
+            taskResults.markChunkSent(scanTask.chunkIndex);
+        }
     }
+    synsSent.fetch_add(workerSent, std::memory_order_relaxed);
+}
 
-    std::vector<std::future<std::vector<NetworkNode>>> futures;
-    struct addrinfo hints = getWSA(); 
-    ScanMonitor scanVals = this->scanMonitor.load();
-    scanVals.hostsDone = 0;
-    scanVals.portsDone = 0;
-    scanVals.threadsEnabled = true;
-    this->scanMonitor.store(scanVals);
+/// <summary>
+/// SYN mode needs raw socket rights, and probe ids have to fit the sequence number.
+/// </summary>
+bool ScanHandler::canSynScan(size_t portCount)
+{
+    if (!this->synScan || !SynScanner::isSupported() || this->targetSpace.empty()
+        || this->targetSpace.size() * portCount > UINT32_MAX)
+    {
+        return false;
+    }
+    return true;
+}
 
-    std::thread consoleThread(handleConsole, std::ref(this->scanMonitor));
+void ScanHandler::TCPSweep(std::vector<int> targetPorts, bool isVerbose)
+{
+    // the scheduler takes ports in index order, so the likeliest open ones go first and an early stop keeps the best finds
+    this->serviceRegistry.sortByFrequency(targetPorts, ServiceProtocol::Tcp);
+    // a resume chunks the task order the way the checkpoint did, or its done chunks would mean other tasks
+    TaskScheduler taskScheduler(this->targetSpace.size(), targetPorts.size(), this->maxThreads, this->scanSeed,
+        this->scanCheckpoint.getChunkSize());
+    // no point starting workers that would only ever steal
+    int finalThreads = (int)std::min((size_t)taskScheduler.getWorkerCount(),
+        std::max(taskScheduler.getTaskCount() / TASK_CHUNK_MIN, (size_t)1));
+    bool useSyn = this->canSynScan(targetPorts.size());
+    if (this->synScan && !useSyn)
+    {
+        std::cout << "SYN scanning needs raw socket rights and at most 2^32 probes, falling back to connect scanning" << std::endl;
+    }
 
-    // Divide work across threads according to largest load
-    if (this->hostNames.size() > maxThreads && targetPorts.size() > maxThreads)
+    std::vector<std::future<void>> futures;
+    // an extra shard past the workers for the SYN receiver thread
+    this->scanProgress.begin(finalThreads + 1, 0, taskScheduler.getTaskCount());
+    ProgressReporter progressReporter(this->scanProgress, this->statsInterval);
+    progressReporter.start();
+
+    Pacer scanPacer(this->getRateLimit(targetPorts.size()), this->minRate);
+    // a bit per chunk of the task order and the answers found, silent ports take no room
+    TaskResults taskResults(targetPorts.size(), taskScheduler.getChunkCount());
+    // chunks a resumed checkpoint finished are passed over by the workers
+    uint64_t restoredChunks = this->scanCheckpoint.restoreTasks(taskResults);
+    if (restoredChunks > 0)
     {
-        for (size_t i = 0; i < finalThreads; ++i) {
-            futures.push_back(
-                std::async(std::launch::async, scanHosts, threadHosts[i], threadPorts[i], hints, std::ref(this->scanMonitor))
+        uint64_t restoredTasks = taskScheduler.estimateTasks(restoredChunks);
+        this->scanProgress.addPorts(finalThreads, restoredTasks);
+        std::cout << std::format("Resuming with about {} of {} probes already done", restoredTasks, taskScheduler.getTaskCount()) << std::endl;
+    }
+    ScanBaseline* scanBaseline = nullptr;
+    if (this->scanBaseline.isLoaded())
+    {
+        this->scanBaseline.setPorts(targetPorts, this->scanSeed);
+        scanBaseline = &this->scanBaseline;
+    }
+    this->scanCheckpoint.startSaving(taskResults, taskScheduler.getChunkSize());
+    // banners are read alongside the sweep as open ports turn up, not in a second pass after it
+    BannerGrabber bannerGrabber;
+    if (this->grabBanners)
+    {
+        bannerGrabber.start();
+    }
+    std::atomic<uint64_t> synsSent{ 0 };
+    std::atomic<uint64_t> synAnswers{ 0 };
+    if (useSyn)
+    {
+        SynScanner synScanner(this->targetSpace.getAddress(0));
+        synScanner.startReceiver([&](uint32_t probeId, uint32_t sourceAddr, uint16_t sourcePort, bool isOpen) {
+            // a forged or stale reply decodes to garbage, so check it against the task it claims to be
+            if (probeId >= taskScheduler.getTaskCount()
+                || this->targetSpace.getAddress(taskScheduler.getHostIndex(probeId)) != sourceAddr
+                || targetPorts[taskScheduler.getPortIndex(probeId)] != sourcePort)
+            {
+                return;
+            }
+            // only the first reply to a task counts, retransmitted SYN-ACKs come through here too
+            if (!taskResults.addAnswer(probeId, isOpen))
+            {
+                return;
+            }
+            synAnswers.fetch_add(1, std::memory_order_relaxed);
+            this->scanProgress.addOutcome(finalThreads, isOpen ? ProbeOutcome::Open : ProbeOutcome::Closed);
+            if (isOpen)
+            {
+                this->resultStream.addPort(sourceAddr, sourcePort);
+                if (this->grabBanners)
+                {
+                    bannerGrabber.addTarget((uint32_t)taskScheduler.getHostIndex(probeId), sourceAddr, sourcePort);
+                }
+            }
+        });
+
+        std::vector<std::thread> sendThreads;
+        for (int i = 0; i < finalThreads; ++i) {
+            sendThreads.push_back(
+                std::thread(sendSynTasks, i, std::ref(taskScheduler), std::cref(this->targetSpace), std::cref(targetPorts),
+                    std::ref(synScanner), std::ref(scanPacer), std::ref(taskResults), scanBaseline, std::ref(synsSent), std::ref(this->scanProgress))
             );
         }
+        for (std::thread& sendThread : sendThreads)
+        {
+            sendThread.join();
+        }
+        // stragglers still count, wait out the grace period unless the user quit
+        auto graceEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(SYN_GRACE_PERIOD);
+        while (std::chrono::steady_clock::now() < graceEnd && this->scanProgress.isRunning())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(SYN_RECV_INTERVAL));
+        }
+        synScanner.stopReceiver();
     }
-    else if (this->hostNames.size() > maxThreads && targetPorts.size() < maxThreads)
+    else
     {
-        for (size_t i = 0; i < finalThreads; ++i) {
+        // workers share the whole (host, port) space and steal from each other when they run dry
+        for (int i = 0; i < finalThreads; ++i) {
             futures.push_back(
-                std::async(std::launch::async, scanHosts, threadHosts[i], targetPorts, hints, std::ref(this->scanMonitor))
+                std::async(std::launch::async, scanTasks, i, std::ref(taskScheduler), std::cref(this->targetSpace),
+                    std::cref(targetPorts), this->probeBackend, std::ref(scanPacer), std::ref(this->rttEstimator),
+                    std::ref(taskResults), scanBaseline, std::ref(this->scanProgress), std::ref(this->resultStream),
+                    this->grabBanners ? &bannerGrabber : nullptr)
             );
         }
+        for (auto& scanFuture : futures)
+        {
+            scanFuture.get();
+        }
     }
-    else if (this->hostNames.size() < maxThreads && targetPorts.size() > maxThreads)
+
+    // an early quit leaves SYN chunks that never had their grace period, the next resume sends them again
+    this->scanCheckpoint.stopSaving(this->scanProgress.isRunning());
+    // every SYN that went out has had all the wait it is going to get, so for the report its silence means filtered
+    taskResults.settleChunks(0);
+    if (useSyn)
     {
-        for (size_t i = 0; i < finalThreads; ++i) {
-            futures.push_back(
-                std::async(std::launch::async, scanHosts, this->hostNames, threadPorts[i], hints, std::ref(this->scanMonitor))
-            );
+        this->scanProgress.addOutcome(finalThreads, ProbeOutcome::Filtered,
+            synsSent.load() - std::min(synAnswers.load(), synsSent.load()));
+    }
+    if (scanBaseline != nullptr)
+    {
+        std::cout << std::format("Baseline left {} of {} probes out", scanBaseline->getSkippedCount(), taskScheduler.getTaskCount()) << std::endl;
+    }
+    // the last ports found still get their full wait, unless the user quit
+    bannerGrabber.finish(this->scanProgress.isRunning());
+    for (BannerResult& bannerResult : bannerGrabber.takeResults())
+    {
+        this->getNode(bannerResult.hostIndex).addServiceMatch(std::move(bannerResult.serviceMatch));
+    }
+
+    // only hosts with something to say get port results, the ones that answered, already have a node or are in the baseline
+    std::vector<uint64_t> reportHosts = taskResults.getAnsweredHosts();
+    for (const auto& [hostIndex, targetHost] : this->targetHosts)
+    {
+        reportHosts.push_back(hostIndex);
+    }
+    if (scanBaseline != nullptr)
+    {
+        for (uint32_t baselineAddr : scanBaseline->getHosts())
+        {
+            size_t hostIndex;
+            if (this->targetSpace.findIndex(baselineAddr, hostIndex))
+            {
+                reportHosts.push_back(hostIndex);
+            }
         }
     }
-    else
+    std::sort(reportHosts.begin(), reportHosts.end());
+    reportHosts.erase(std::unique(reportHosts.begin(), reportHosts.end()), reportHosts.end());
+    // a sweep cut short reached some of each host's ports, which ones depends on where the host sits in the order
+    bool sweepComplete = taskResults.isComplete();
+    std::unordered_map<uint64_t, uint64_t> hostPositions;
+    if (!sweepComplete)
     {
-        // if we only have small number of hosts with a small number of ports then just run one thread
-        futures.push_back(
-            std::async(std::launch::async, scanHosts, this->hostNames, targetPorts, hints, std::ref(this->scanMonitor))
-        );
+        hostPositions = taskScheduler.findHostPositions(reportHosts);
     }
 
-    for (auto& scanFuture : futures)
+    auto scannedPorts = std::make_shared<const std::vector<int>>(targetPorts);
+    size_t portCount = targetPorts.size();
+    std::vector<TaskState> portStates(portCount);
+    PortSet openPorts;
+    PortSet closedPorts;
+    for (uint64_t hostIndex : reportHosts)
     {
-        std::vector<NetworkNode> scanResults = scanFuture.get();
-        for (NetworkNode &testedNode : scanResults)
+        uint32_t packedAddr = this->targetSpace.getAddress(hostIndex);
+        taskResults.getHostAnswers(hostIndex, openPorts, closedPorts);
+        bool hostProbed = false;
+        for (size_t portIndex = 0; portIndex < portCount; portIndex++)
         {
-            for (NetworkNode &targetHost : this->targetHosts)
+            TaskState& portState = portStates[portIndex];
+            if (openPorts.contains((uint16_t)portIndex) || closedPorts.contains((uint16_t)portIndex))
             {
-                if (testedNode.getName() == targetHost.getName())
-                {
-                    targetHost.appendPorts(testedNode.getRequestedPorts());
-                    targetHost.setActive();
-                }
+                portState = openPorts.contains((uint16_t)portIndex) ? TaskState::Open : TaskState::Closed;
+            }
+            // a sweep cut short never reached the tasks in chunks that aren't done
+            else if (!sweepComplete && !taskResults.isChunkDone(taskScheduler.getChunkIndex(hostPositions[hostIndex], portIndex)))
+            {
+                portState = TaskState::Unprobed;
             }
+            else if (scanBaseline != nullptr && !scanBaseline->isSelected(hostIndex * portCount + portIndex,
+                packedAddr, (uint16_t)targetPorts[portIndex]))
+            {
+                portState = TaskState::Skipped;
+            }
+            else
+            {
+                // silence means filtered, reported like a connect that timed out
+                portState = TaskState::Filtered;
+            }
+            hostProbed = hostProbed || (portState != TaskState::Unprobed && portState != TaskState::Skipped);
+        }
+        if (scanBaseline != nullptr)
+        {
+            // a ping reply or any answer on a port, filtered ports don't count
+            auto hostEntry = this->targetHosts.find(hostIndex);
+            bool hostAnswered = (hostEntry != this->targetHosts.end() && hostEntry->second.getActive())
+                || !openPorts.empty() || !closedPorts.empty();
+            scanBaseline->compareHost(packedAddr, hostAnswered, targetPorts, portStates);
         }
+        if (!hostProbed)
+        {
+            continue;
+        }
+        NetworkNode& targetHost = this->getNode(hostIndex);
+        targetHost.setPortResults(scannedPorts, portStates);
+        targetHost.setActive();
+    }
+    progressReporter.stop();
+}
+
+/// <summary>
+/// Probe every host's ports over UDP. One socket sends each port its protocol's payload in batches and a receiver
+/// thread sorts answers (open) from port unreachables (closed), ports still silent after UDP_MAX_TRIES are open|filtered.
+/// Checkpoints, baselines and banner grabbing only follow the TCP sweep.
+/// </summary>
+void ScanHandler::UDPSweep(std::vector<int> targetPorts, bool isVerbose)
+{
+    // the likeliest open ports go first, the same as the TCP sweep but ranked by how often they answer over UDP
+    this->serviceRegistry.sortByFrequency(targetPorts, ServiceProtocol::Udp);
+    size_t portCount = targetPorts.size();
+    // one shard for the sending thread and one for the receiver
+    this->scanProgress.begin(2, 0, this->targetSpace.size() * portCount);
+    ProgressReporter progressReporter(this->scanProgress, this->statsInterval);
+    progressReporter.start();
+
+    Pacer scanPacer(this->getRateLimit(portCount), this->minRate);
+    CyclicPermutation hostOrder(this->targetSpace.size(), this->scanSeed);
+    UdpScanner udpScanner(UDP_MAX_TRIES);
+    UdpSweepResult sweepResult = udpScanner.sweep(this->targetSpace, targetPorts, hostOrder, scanPacer, this->rttEstimator,
+        [this]() { return this->scanProgress.isRunning(); },
+        [this](int portsFinished) { this->scanProgress.addPorts(0, portsFinished); },
+        [&](uint64_t taskIndex, bool isOpen) {
+            this->scanProgress.addOutcome(1, isOpen ? ProbeOutcome::Open : ProbeOutcome::Closed);
+            if (isOpen)
+            {
+                this->resultStream.addPort(this->targetSpace.getAddress(taskIndex / portCount), (uint16_t)targetPorts[taskIndex % portCount], ServiceProtocol::Udp);
+            }
+        });
+    // silence is only known for sure once the last try is up, so it is counted here
+    this->scanProgress.addOutcome(0, ProbeOutcome::Filtered, sweepResult.silentCount);
+
+    // only hosts that answered or already have a node get port results, the rest were silent on every port
+    std::unordered_map<uint64_t, bool> taskAnswers;
+    std::vector<uint64_t> reportHosts;
+    for (const UdpAnswer& udpAnswer : sweepResult.udpAnswers)
+    {
+        taskAnswers[udpAnswer.taskIndex] = udpAnswer.isOpen;
+        reportHosts.push_back(udpAnswer.taskIndex / portCount);
+    }
+    for (const auto& [hostIndex, targetHost] : this->targetHosts)
+    {
+        reportHosts.push_back(hostIndex);
     }
-    scanVals = scanMonitor.load();
-    scanVals.threadsEnabled = false;
-    scanMonitor.store(scanVals);
-    if (consoleThread.joinable())
+    std::sort(reportHosts.begin(), reportHosts.end());
+    reportHosts.erase(std::unique(reportHosts.begin(), reportHosts.end()), reportHosts.end());
+    // hosts are sent each port in permutation order, so a sweep cut short reached a host's port
+    // if it came before the port left unsent, or is that port and the host comes before the next one
+    std::unordered_map<uint64_t, uint64_t> hostPositions;
+    if (!sweepResult.allSent)
     {
-        consoleThread.join();
+        reportHosts.push_back(sweepResult.nextHost);
+        hostPositions = hostOrder.findPositions(reportHosts);
+        reportHosts.pop_back();
     }
-    windowsCleanup();
+    auto taskSent = [&](uint64_t hostIndex, size_t portIndex) {
+        return sweepResult.allSent || portIndex < sweepResult.nextPort
+            || (portIndex == sweepResult.nextPort && hostPositions[hostIndex] < hostPositions[sweepResult.nextHost]);
+    };
+
+    auto scannedPorts = std::make_shared<const std::vector<int>>(targetPorts);
+    std::vector<TaskState> portStates(portCount);
+    for (uint64_t hostIndex : reportHosts)
+    {
+        bool hostProbed = false;
+        for (size_t portIndex = 0; portIndex < portCount; portIndex++)
+        {
+            uint64_t taskIndex = hostIndex * portCount + portIndex;
+            auto taskAnswer = taskAnswers.find(taskIndex);
+            TaskState& portState = portStates[portIndex];
+            if (taskAnswer != taskAnswers.end())
+            {
+                portState = taskAnswer->second ? TaskState::Open : TaskState::Closed;
+            }
+            else if (sweepResult.unfinishedTasks.contains(taskIndex) || !taskSent(hostIndex, portIndex))
+            {
+                portState = TaskState::Unprobed;
+            }
+            else
+            {
+                portState = TaskState::Filtered;
+            }
+            hostProbed = hostProbed || portState != TaskState::Unprobed;
+        }
+        if (!hostProbed)
+        {
+            continue;
+        }
+        NetworkNode& targetHost = this->getNode(hostIndex);
+        targetHost.setPortResults(scannedPorts, portStates, ServiceProtocol::Udp);
+        targetHost.setActive();
+    }
+    progressReporter.stop();
 }
 
+// hosts that replied or have results, in target order
 std::vector<NetworkNode> ScanHandler::getTargetHosts()
 {
-    return this->targetHosts;
+    std::vector<NetworkNode> targetHosts;
+    targetHosts.reserve(this->targetHosts.size());
+    for (const auto& [hostIndex, targetHost] : this->targetHosts)
+    {
+        targetHosts.push_back(targetHost);
+    }
+    return targetHosts;
+}
+
+size_t ScanHandler::getHostCount()
+{
+    return this->targetSpace.size();
+}
+
+void ScanHandler::setBackend(ProbeBackend probeBackend)
+{
+    this->probeBackend = probeBackend;
 }
 
-std::vector<std::string> ScanHandler::getHostnames()
+void ScanHandler::setSynScan(bool synScan)
 {
-    return this->hostNames;
+    this->synScan = synScan;
+}
+
+void ScanHandler::setRateLimits(int maxRate, int minRate)
+{
+    this->maxRate = maxRate;
+    this->minRate = minRate;
+}
+
+void ScanHandler::setStatsInterval(int statsInterval)
+{
+    this->statsInterval = statsInterval;
+}
+
+// fix the probe order, so a scan can be repeated exactly
+void ScanHandler::setSeed(uint64_t scanSeed)
+{
+    this->scanSeed = scanSeed;
+}
+
+uint64_t ScanHandler::getSeed()
+{
+    return this->scanSeed;
+}
+
+// stream hosts and open ports as JSON lines while the sweeps run, "-" for stdout
+bool ScanHandler::openResultStream(const std::string& outputPath)
+{
+    return this->resultStream.open(outputPath);
+}
+
+// write out anything still queued, must be called before exiting or the tail of the stream is lost
+void ScanHandler::closeResultStream()
+{
+    this->resultStream.close();
+}
+
+/// <summary>
+/// Save the TCP sweep's progress to a state file every CHECKPOINT_INTERVAL seconds and once more as it ends.
+/// Call after the seed is settled, the checkpoint records it.
+/// </summary>
+void ScanHandler::setCheckpoint(const std::string& checkpointPath, const TargetSpace& targetSpace, const std::vector<int>& targetPorts)
+{
+    this->scanCheckpoint.setScan(checkpointPath, targetSpace, targetPorts, this->scanSeed);
+}
+
+/// <summary>
+/// Rescan against an earlier scan's csv results. Every (host, port) they list is probed again
+/// and samplePercent of the rest, then printChanges reports what is new, closed or gone.
+/// </summary>
+void ScanHandler::setBaseline(const std::string& baselinePath, int samplePercent)
+{
+    this->scanBaseline.load(baselinePath);
+    this->scanBaseline.setSamplePercent(samplePercent);
+}
+
+/// <summary>
+/// List what changed since the baseline, nothing unless one was given.
+/// </summary>
+void ScanHandler::printChanges()
+{
+    if (!this->scanBaseline.isLoaded())
+    {
+        return;
+    }
+    constexpr std::string_view CHANGE_NAMES[] = { "New", "Closed", "Vanished" };
+    size_t changeCounts[3] = {};
+    std::string changeOutput = std::format("Changes since baseline\n{}\n", SPLITTER);
+    for (const BaselineChange& baselineChange : this->scanBaseline.getChanges())
+    {
+        size_t changeIndex = (size_t)baselineChange.serviceChange;
+        changeCounts[changeIndex]++;
+        if (baselineChange.portNumber == 0)
+        {
+            std::format_to(std::back_inserter(changeOutput), "{}: {}\n", CHANGE_NAMES[changeIndex], TargetSpace::formatAddress(baselineChange.packedAddr));
+            continue;
+        }
+        std::format_to(std::back_inserter(changeOutput), "{}: {} Port {} ({})\n", CHANGE_NAMES[changeIndex],
+            TargetSpace::formatAddress(baselineChange.packedAddr), baselineChange.portNumber,
+            this->serviceRegistry.getName(baselineChange.portNumber, ServiceProtocol::Tcp));
+    }
+    std::format_to(std::back_inserter(changeOutput), "{} new, {} closed, {} vanished\n{}\n",
+        changeCounts[0], changeCounts[1], changeCounts[2], SPLITTER);
+    std::cout << changeOutput << std::flush;
+}
+
+// read what open ports announce themselves as, as the sweep finds them
+void ScanHandler::setBannerGrab(bool grabBanners)
+{
+    this->grabBanners = grabBanners;
+}
+
+/// <summary>
+/// Pick an interrupted scan back up, the sweep then skips every task the checkpoint had finished.
+/// The targets and ports have to be the ones the checkpoint was taken with, the seed is taken from it.
+/// </summary>
+void ScanHandler::resumeScan(const std::string& checkpointPath, const TargetSpace& targetSpace, const std::vector<int>& targetPorts)
+{
+    this->scanCheckpoint.load(checkpointPath);
+    if (!this->scanCheckpoint.matchesScan(targetSpace, targetPorts))
+    {
+        throw NetException(std::format("Checkpoint {} was taken with different targets or ports", checkpointPath));
+    }
+    this->scanSeed = this->scanCheckpoint.getSeed();
+}
+
+/// <summary>
+/// Global probe rate ceiling for a sweep, --max-rate if given.
+/// The older --delay (per thread, between hosts) is converted to the same average rate as a global limit.
+/// </summary>
+/// <param name="probesPerHost">probes each host receives in this sweep</param>
+/// <returns>probes per second, 0 for unlimited</returns>
+int ScanHandler::getRateLimit(size_t probesPerHost)
+{
+    if (this->maxRate > 0 || this->networkDelay <= 0)
+    {
+        return this->maxRate;
+    }
+    double delayRate = (double)this->maxThreads * probesPerHost * 1000.0 / this->networkDelay;
+    return (int)std::clamp(delayRate, 1.0, (double)INT_MAX);
 }
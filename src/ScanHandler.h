@@ -24,92 +24,154 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
 #include <atomic>
 #include <map>
-#pragma comment (lib, "Mswsock.lib")
-#include <WinSock2.h>
-#pragma comment(lib, "ws2_32")
+#include <memory>
+#include "ProbeEngine.h"
+#include "RttEstimator.h"
+#include "NetBackend.h"
+#include "ScanProgress.h"
+#include "PortSet.h"
+#include "TargetSpace.h"
+#include "ServiceRegistry.h"
+#include "ResultStream.h"
+#include "ScanCheckpoint.h"
+#include "ScanBaseline.h"
+#include "BannerGrabber.h"
+
+class ResultFormatter;
+
+// outcome of one (host, port) task, worked out per host from the sweep's results once it ends
+// Skipped tasks are left out of a baseline rescan and reported like unprobed ones
+enum class TaskState : uint8_t { Unprobed, Open, Closed, Filtered, Skipped };
 
 class NetworkPort {
 public:
 	NetworkPort(int portNumber);
-	NetworkPort(int portNumber, bool portStatus, int portReason);
+	NetworkPort(int portNumber, bool portStatus, int portReason, ServiceProtocol portProtocol = ServiceProtocol::Tcp);
 public:
 	bool getStatus();
+	std::string_view getState();
 	int getNumber();
+	ServiceProtocol getProtocol();
+	std::string_view getProtocolName();
 	bool operator<(const NetworkPort& netPort);
 	bool operator<=(const NetworkPort& netPort);
 	bool operator>(const NetworkPort& netPort);
 	bool operator>=(const NetworkPort& netPort);
-	std::string getExpectedService(std::map<int,std::string> serviceMap);
+	std::string_view getExpectedService(const ServiceRegistry& serviceRegistry);
 private:
 	int portNumber;
-	std::string serviceName;
 	int portReason;
 	bool portStatus;
+	ServiceProtocol portProtocol = ServiceProtocol::Tcp;
 };
 
 class NetworkNode
 {
 public:
-	NetworkNode(std::string hostAddress, std::vector<NetworkPort> hostPorts);
-	NetworkNode(std::string hostAddress, std::vector<int> targetPorts,bool pingStatus);
-	NetworkNode(std::string hostAddress, bool pingResult);
+	NetworkNode(uint32_t packedAddr, std::shared_ptr<const std::vector<int>> requestedPorts, bool pingStatus);
+	NetworkNode(uint32_t packedAddr, bool pingResult);
 public:
-	std::string getName();
+	std::string getName() const;
 	std::vector<NetworkPort> getPorts();
-	void appendPort(NetworkPort newPort);
-	void appendPorts(std::vector<NetworkPort> newPorts);
-	void setPorts(std::vector<NetworkPort> newPorts);
+	void setPortResults(std::shared_ptr<const std::vector<int>> scannedPorts, const std::vector<TaskState>& portStates,
+		ServiceProtocol portProtocol = ServiceProtocol::Tcp);
 	void setActive();
 	bool getActive();
 	std::vector<NetworkPort> getActivePorts();
-	std::vector<NetworkPort> getRequestedPorts();
+	const std::vector<int>& getRequestedPorts() const;
 	void setMac(std::string macAddr);
 	std::string getMac();
+	uint32_t getPackedAddr() const;
+	void addServiceMatch(ServiceMatch serviceMatch);
+	const ServiceMatch* getServiceMatch(int portNumber) const;
 private: 
-	std::vector<NetworkPort> portResults{};
-	std::vector<NetworkPort> requestedPorts{};
-	std::string networkAddress{};
+	// port lists are shared by every node in a scan rather than copied per host
+	std::shared_ptr<const std::vector<int>> requestedPorts{};
+	std::shared_ptr<const std::vector<int>> scannedPorts{};
+	// most of a host's ports answer the same way, so only open ports and the ones
+	// that differ from that usual answer are stored, memory follows what was found
+	PortSet openPorts{};
+	PortSet unusualPorts{};
+	// left behind when a sweep is stopped early
+	PortSet unprobedPorts{};
+	TaskState usualState = TaskState::Closed;
+	// what the ports were scanned over, every port of a node comes from the one sweep
+	ServiceProtocol portProtocol = ServiceProtocol::Tcp;
+	// host order IPv4 address, the dotted form is only built when the node is printed
+	uint32_t packedAddr = 0;
 	bool isActive = false;
 	std::string macAddr{};
+	// what open ports' banners identified, empty unless banners were grabbed
+	std::vector<ServiceMatch> serviceMatches{};
 };
 
-struct tempResult {
-	std::string hostAddress{};
-	bool hostStatus = false;
+// one per host that replied to the ping sweep
+struct PingResult {
+	size_t hostIndex = 0;
 	std::string macAddr{};
+	// echo round trip in microseconds
+	int64_t roundTrip = -1;
 };
 
-struct ScanMonitor
-{
-	int hostsDone = 0;
-	int portsDone = 0;
-	bool threadsEnabled = true;
-	int networkDelay = 0;
-};
-
-
 class ScanHandler
 {
 public:
-	ScanHandler(std::vector<std::string> targetAddresses, std::vector<int>targetPorts,int maxThreads, int networkDelay);
+	ScanHandler(const TargetSpace& targetSpace, std::vector<int>targetPorts,int maxThreads, int networkDelay);
 public:
 	void pingSweep(bool isVerbose);
-	void printResults(bool isVerbose);
+	void printResults(ResultFormatter& resultFormatter);
 	void TCPSweep(std::vector<int> targetPorts, bool isVerbose);
+	void UDPSweep(std::vector<int> targetPorts, bool isVerbose);
 	std::vector<NetworkNode> getTargetHosts();
-	std::vector<std::string> getHostnames();
-	std::vector<NetworkNode> targetHosts;
+	size_t getHostCount();
+	void setBackend(ProbeBackend probeBackend);
+	void setSynScan(bool synScan);
+	void setRateLimits(int maxRate, int minRate);
+	void setStatsInterval(int statsInterval);
+	void setSeed(uint64_t scanSeed);
+	uint64_t getSeed();
+	bool openResultStream(const std::string& outputPath);
+	void closeResultStream();
+	void setCheckpoint(const std::string& checkpointPath, const TargetSpace& targetSpace, const std::vector<int>& targetPorts);
+	void resumeScan(const std::string& checkpointPath, const TargetSpace& targetSpace, const std::vector<int>& targetPorts);
+	void setBaseline(const std::string& baselinePath, int samplePercent);
+	void printChanges();
+	void setBannerGrab(bool grabBanners);
 private:
-	std::vector<NetworkPort> targetPorts;
+	NetworkNode& getNode(size_t hostIndex);
+	bool canSynScan(size_t portCount);
+	int getRateLimit(size_t probesPerHost);
+private:
+	// hosts are only ever addressed by index into the target ranges, nothing is built per target
+	TargetSpace targetSpace;
+	// a node for each host that replied or has results, keyed by index so output stays in target order
+	std::map<size_t, NetworkNode> targetHosts;
+	std::shared_ptr<const std::vector<int>> targetPorts;
 	int maxThreads;
 	int networkDelay;
-	std::atomic<ScanMonitor> scanMonitor;
-	std::vector<std::string> hostNames;
-	struct addrinfo scanHints;
-	std::map<int, std::string> serviceMap;
+	ScanProgress scanProgress;
+	ProbeBackend probeBackend = ProbeBackend::Poll;
+	RttEstimator rttEstimator;
+	bool synScan = false;
+	// probes per second across every worker, 0 for no limit
+	int maxRate = 0;
+	int minRate = 0;
+	// seconds between progress lines printed unprompted, 0 for only on request
+	int statsInterval = 0;
+	// seeds the order hosts and ports are probed in, random unless one is given
+	uint64_t scanSeed = 0;
+	// shared and read only, output only ever takes views into it
+	const ServiceRegistry& serviceRegistry;
+	// findings go out here as they are made, ignored unless a stream was opened
+	ResultStream resultStream;
+	// finished work is saved here as the TCP sweep runs, unused unless a path was set
+	ScanCheckpoint scanCheckpoint;
+	// an earlier scan's results, when given the sweep probes what it found plus a sample of the rest
+	ScanBaseline scanBaseline;
+	// read banners from open ports while the TCP sweep runs and report the services they name
+	bool grabBanners = false;
 
 };
-
-std::map<int, std::string> loadKnownServices();
@@ -0,0 +1,128 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ScanProgress:
+// Per worker progress counters for a sweep plus its stop flag.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "ScanProgress.h"
+
+/// <summary>
+/// Zero the counters and clear both flags ahead of a sweep. Not safe while any worker or reader is running.
+/// </summary>
+/// <param name="workerCount">threads that will report progress, each passes its own id below this</param>
+/// <param name="hostsTotal">hosts the sweep will count as done, 0 if it counts ports instead</param>
+/// <param name="portsTotal">ports the sweep will count as done, 0 if it counts hosts instead</param>
+void ScanProgress::begin(size_t workerCount, uint64_t hostsTotal, uint64_t portsTotal)
+{
+    this->progressShards = std::vector<ProgressShard>(workerCount > 0 ? workerCount : 1);
+    this->hostsTotal = hostsTotal;
+    this->portsTotal = portsTotal;
+    this->stopRequested.store(false);
+    this->sweepFinished.store(false);
+}
+
+void ScanProgress::finish()
+{
+    this->sweepFinished.store(true);
+}
+
+void ScanProgress::requestStop()
+{
+    this->stopRequested.store(true);
+}
+
+// workers keep going until the user quits, even once the console thread has been told the sweep is over
+bool ScanProgress::isRunning() const
+{
+    return !this->stopRequested.load(std::memory_order_relaxed);
+}
+
+bool ScanProgress::isFinished() const
+{
+    return this->sweepFinished.load() || this->stopRequested.load();
+}
+
+ScanProgress::ProgressShard& ScanProgress::getShard(size_t workerId)
+{
+    return this->progressShards[workerId % this->progressShards.size()];
+}
+
+void ScanProgress::addHosts(size_t workerId, uint64_t hostCount)
+{
+    this->getShard(workerId).hostsDone.fetch_add(hostCount, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Count one finished probe against the worker, both as a port done and under its outcome.
+/// </summary>
+void ScanProgress::addProbe(size_t workerId, ProbeOutcome probeOutcome)
+{
+    this->addPorts(workerId, 1);
+    this->addOutcome(workerId, probeOutcome);
+}
+
+/// <summary>
+/// Count an outcome for ports that were already counted as done, such as a SYN answered after it went out.
+/// </summary>
+void ScanProgress::addOutcome(size_t workerId, ProbeOutcome probeOutcome, uint64_t outcomeCount)
+{
+    ProgressShard& progressShard = this->getShard(workerId);
+    switch (probeOutcome)
+    {
+    case ProbeOutcome::Open:
+        progressShard.portsOpen.fetch_add(outcomeCount, std::memory_order_relaxed);
+        break;
+    case ProbeOutcome::Closed:
+        progressShard.portsClosed.fetch_add(outcomeCount, std::memory_order_relaxed);
+        break;
+    case ProbeOutcome::Filtered:
+        progressShard.portsFiltered.fetch_add(outcomeCount, std::memory_order_relaxed);
+        break;
+    }
+}
+
+/// <summary>
+/// Count ports handled without an outcome yet, such as SYNs that have gone out but not been answered.
+/// </summary>
+void ScanProgress::addPorts(size_t workerId, uint64_t portCount)
+{
+    this->getShard(workerId).portsDone.fetch_add(portCount, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Add up every worker's counters. Each counter is read on its own, so a snapshot taken mid sweep
+/// may be a few probes out between fields but never loses any.
+/// </summary>
+ProgressTotals ScanProgress::getTotals() const
+{
+    ProgressTotals progressTotals;
+    progressTotals.hostsTotal = this->hostsTotal;
+    progressTotals.portsTotal = this->portsTotal;
+    for (const ProgressShard& progressShard : this->progressShards)
+    {
+        progressTotals.hostsDone += progressShard.hostsDone.load(std::memory_order_relaxed);
+        progressTotals.portsDone += progressShard.portsDone.load(std::memory_order_relaxed);
+        progressTotals.portsOpen += progressShard.portsOpen.load(std::memory_order_relaxed);
+        progressTotals.portsClosed += progressShard.portsClosed.load(std::memory_order_relaxed);
+        progressTotals.portsFiltered += progressShard.portsFiltered.load(std::memory_order_relaxed);
+    }
+    return progressTotals;
+}
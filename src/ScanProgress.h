@@ -0,0 +1,89 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ScanProgress:
+// Per worker progress counters for a sweep plus its stop flag. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+// sized to a cache line so workers bumping their own counters never share one
+constexpr size_t PROGRESS_SHARD_ALIGN = 64;
+
+// what a probe found, for the per outcome counters
+enum class ProbeOutcome
+{
+	Open,
+	Closed,
+	Filtered
+};
+
+// a snapshot summed over every worker's counters
+struct ProgressTotals
+{
+	// what the sweep set out to do, 0 when it doesn't count that unit
+	uint64_t hostsTotal = 0;
+	uint64_t portsTotal = 0;
+	uint64_t hostsDone = 0;
+	uint64_t portsDone = 0;
+	uint64_t portsOpen = 0;
+	uint64_t portsClosed = 0;
+	uint64_t portsFiltered = 0;
+};
+
+class ScanProgress
+{
+public:
+	ScanProgress() = default;
+	ScanProgress(const ScanProgress&) = delete;
+	ScanProgress& operator=(const ScanProgress&) = delete;
+public:
+	void begin(size_t workerCount, uint64_t hostsTotal, uint64_t portsTotal);
+	void finish();
+	void requestStop();
+	bool isRunning() const;
+	bool isFinished() const;
+	void addHosts(size_t workerId, uint64_t hostCount);
+	void addProbe(size_t workerId, ProbeOutcome probeOutcome);
+	void addOutcome(size_t workerId, ProbeOutcome probeOutcome, uint64_t outcomeCount = 1);
+	void addPorts(size_t workerId, uint64_t portCount);
+	ProgressTotals getTotals() const;
+private:
+	// only the owning worker writes its shard, readers add them all up on demand
+	struct alignas(PROGRESS_SHARD_ALIGN) ProgressShard
+	{
+		std::atomic<uint64_t> hostsDone{ 0 };
+		std::atomic<uint64_t> portsDone{ 0 };
+		std::atomic<uint64_t> portsOpen{ 0 };
+		std::atomic<uint64_t> portsClosed{ 0 };
+		std::atomic<uint64_t> portsFiltered{ 0 };
+	};
+	ProgressShard& getShard(size_t workerId);
+private:
+	std::vector<ProgressShard> progressShards;
+	uint64_t hostsTotal = 0;
+	uint64_t portsTotal = 0;
+	// set when the user quits, workers check it between probes
+	std::atomic<bool> stopRequested{ false };
+	// set once the sweep is over so the console thread can go
+	std::atomic<bool> sweepFinished{ false };
+};
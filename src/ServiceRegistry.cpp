@@ -0,0 +1,129 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ServiceRegistry:
+// Read only view of the compiled in known-services table, shared by everything that names a port.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "ServiceRegistry.h"
+#include <algorithm>
+// SERVICE_BLOB, SERVICE_RECORDS and SERVICE_INDEX, generated from res/known-services by tools/ServiceTableGen.cpp
+#include "ServiceTable.inc"
+
+static std::string_view getBlobString(uint32_t blobOffset, uint16_t blobLength)
+{
+    return std::string_view((const char*)SERVICE_BLOB + blobOffset, blobLength);
+}
+
+// record for a port, record 0 is the empty one unlisted ports point at
+static const ServiceRecord& getRecord(uint16_t portNumber, ServiceProtocol serviceProtocol)
+{
+    return SERVICE_RECORDS[SERVICE_INDEX[serviceProtocol == ServiceProtocol::Tcp ? 0 : 1][portNumber]];
+}
+
+/// <summary>
+/// Look a port up in the compiled in table, one index read and no parsing or allocation.
+/// </summary>
+/// <param name="portNumber">port to look up</param>
+/// <param name="serviceProtocol">which half of the table to look in</param>
+/// <param name="serviceEntry">filled with views into the table when the port is listed</param>
+/// <returns>false when known-services has no line for the port</returns>
+bool ServiceRegistry::findService(uint16_t portNumber, ServiceProtocol serviceProtocol, ServiceEntry& serviceEntry) const
+{
+    const ServiceRecord& serviceRecord = getRecord(portNumber, serviceProtocol);
+    if (&serviceRecord == &SERVICE_RECORDS[0])
+    {
+        return false;
+    }
+    serviceEntry.serviceName = getBlobString(serviceRecord.nameOffset, serviceRecord.nameLength);
+    serviceEntry.openFrequency = serviceRecord.openFrequency;
+    serviceEntry.serviceDescription = getBlobString(serviceRecord.commentOffset, serviceRecord.commentLength);
+    return true;
+}
+
+// service name for output, UNKNOWN_SERVICE when the port isn't listed
+std::string_view ServiceRegistry::getName(uint16_t portNumber, ServiceProtocol serviceProtocol) const
+{
+    const ServiceRecord& serviceRecord = getRecord(portNumber, serviceProtocol);
+    if (serviceRecord.nameLength == 0)
+    {
+        return UNKNOWN_SERVICE;
+    }
+    return getBlobString(serviceRecord.nameOffset, serviceRecord.nameLength);
+}
+
+// 0 for unlisted ports
+float ServiceRegistry::getFrequency(uint16_t portNumber, ServiceProtocol serviceProtocol) const
+{
+    return getRecord(portNumber, serviceProtocol).openFrequency;
+}
+
+// the comment known-services gives the port, empty when there is none
+std::string_view ServiceRegistry::getDescription(uint16_t portNumber, ServiceProtocol serviceProtocol) const
+{
+    const ServiceRecord& serviceRecord = getRecord(portNumber, serviceProtocol);
+    return getBlobString(serviceRecord.commentOffset, serviceRecord.commentLength);
+}
+
+// listed under a real name rather than as unknown
+bool ServiceRegistry::isNamed(uint16_t portNumber, ServiceProtocol serviceProtocol) const
+{
+    return this->getName(portNumber, serviceProtocol) != UNKNOWN_SERVICE;
+}
+
+/// <summary>
+/// The ports nmap found open most often, most likely first. Ties keep port order so a count always
+/// picks the same set, and port 0 is left out as nothing can be probed on it.
+/// </summary>
+/// <param name="portCount">how many ports to return, fewer if the table lists fewer</param>
+/// <param name="serviceProtocol">which half of the table to rank</param>
+std::vector<int> ServiceRegistry::getTopPorts(size_t portCount, ServiceProtocol serviceProtocol) const
+{
+    std::vector<int> listedPorts;
+    for (int portNumber = 1; portNumber <= UINT16_MAX; portNumber++)
+    {
+        if (&getRecord((uint16_t)portNumber, serviceProtocol) != &SERVICE_RECORDS[0])
+        {
+            listedPorts.push_back(portNumber);
+        }
+    }
+    this->sortByFrequency(listedPorts, serviceProtocol);
+    listedPorts.resize(std::min(portCount, listedPorts.size()));
+    return listedPorts;
+}
+
+/// <summary>
+/// Order ports from most to least likely open, unlisted ports last and ties in their given order.
+/// </summary>
+void ServiceRegistry::sortByFrequency(std::vector<int>& portNumbers, ServiceProtocol serviceProtocol) const
+{
+    std::stable_sort(portNumbers.begin(), portNumbers.end(), [serviceProtocol](int firstPort, int secondPort) {
+        return getRecord((uint16_t)firstPort, serviceProtocol).openFrequency > getRecord((uint16_t)secondPort, serviceProtocol).openFrequency;
+    });
+}
+
+/// <summary>
+/// The one registry, the table is static so there is nothing to load or free.
+/// </summary>
+const ServiceRegistry& getServiceRegistry()
+{
+    static const ServiceRegistry serviceRegistry;
+    return serviceRegistry;
+}
@@ -0,0 +1,72 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ServiceRegistry:
+// Read only view of the compiled in known-services table, shared by everything that names a port. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// what a port is reported as when known-services has nothing for it
+constexpr std::string_view UNKNOWN_SERVICE = "unknown";
+
+enum class ServiceProtocol
+{
+	Tcp,
+	Udp
+};
+
+// one known-services line as it is stored in the generated table, strings are offsets into one blob
+struct ServiceRecord
+{
+	uint32_t nameOffset;
+	uint16_t nameLength;
+	uint32_t commentOffset;
+	uint16_t commentLength;
+	// fraction of scanned hosts nmap found this port open on
+	float openFrequency;
+};
+
+struct ServiceEntry
+{
+	std::string_view serviceName{};
+	float openFrequency = 0;
+	std::string_view serviceDescription{};
+};
+
+class ServiceRegistry
+{
+public:
+	ServiceRegistry() = default;
+	ServiceRegistry(const ServiceRegistry&) = delete;
+	ServiceRegistry& operator=(const ServiceRegistry&) = delete;
+public:
+	bool findService(uint16_t portNumber, ServiceProtocol serviceProtocol, ServiceEntry& serviceEntry) const;
+	std::string_view getName(uint16_t portNumber, ServiceProtocol serviceProtocol) const;
+	float getFrequency(uint16_t portNumber, ServiceProtocol serviceProtocol) const;
+	std::string_view getDescription(uint16_t portNumber, ServiceProtocol serviceProtocol) const;
+	bool isNamed(uint16_t portNumber, ServiceProtocol serviceProtocol) const;
+	std::vector<int> getTopPorts(size_t portCount, ServiceProtocol serviceProtocol) const;
+	void sortByFrequency(std::vector<int>& portNumbers, ServiceProtocol serviceProtocol) const;
+};
+
+const ServiceRegistry& getServiceRegistry();
@@ -0,0 +1,466 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// SignatureDatabase:
+// Service probes and banner signatures from res/service-signatures, compiled once for matching many banners quickly.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "SignatureDatabase.h"
+#include <algorithm>
+#include <stdexcept>
+#include <format>
+#include <charconv>
+#include <cctype>
+#include <cstring>
+// SIGNATURE_TEXT, res/service-signatures checked and embedded by tools/SignatureTableGen.cpp
+#include "SignatureTable.inc"
+
+class SignatureException : public std::runtime_error {
+public:
+    SignatureException(const std::string& message)
+        : std::runtime_error(message) {}
+};
+
+static bool equalBytes(char firstChar, char secondChar, bool ignoreCase)
+{
+    return ignoreCase ? std::tolower((unsigned char)firstChar) == std::tolower((unsigned char)secondChar) : firstChar == secondChar;
+}
+
+// first place the literal turns up at or after startPos, npos if nowhere
+static size_t findLiteral(std::string_view searchText, std::string_view literalText, size_t startPos, bool ignoreCase)
+{
+    if (!ignoreCase)
+    {
+        return searchText.find(literalText, startPos);
+    }
+    auto foundAt = std::search(searchText.begin() + std::min(startPos, searchText.size()), searchText.end(), literalText.begin(), literalText.end(),
+        [](char textChar, char literalChar) { return equalBytes(textChar, literalChar, true); });
+    return foundAt == searchText.end() ? std::string_view::npos : (size_t)(foundAt - searchText.begin());
+}
+
+// where the line holding startPos ends, the end of the text if it never does
+static size_t findLineEnd(std::string_view searchText, size_t startPos)
+{
+    return std::min(searchText.find_first_of("\r\n", startPos), searchText.size());
+}
+
+/// <summary>
+/// Turn a field's escapes into the bytes they stand for, \r \n \t \0 \xHH and a backslash before anything else for that character.
+/// </summary>
+static std::string unescapeText(std::string_view escapedText, size_t lineNumber)
+{
+    std::string plainText;
+    for (size_t charIndex = 0; charIndex < escapedText.size(); charIndex++)
+    {
+        if (escapedText[charIndex] != '\\')
+        {
+            plainText.push_back(escapedText[charIndex]);
+            continue;
+        }
+        if (++charIndex >= escapedText.size())
+        {
+            throw SignatureException(std::format("Service signatures line {}: trailing backslash", lineNumber));
+        }
+        switch (escapedText[charIndex])
+        {
+        case 'r': plainText.push_back('\r'); break;
+        case 'n': plainText.push_back('\n'); break;
+        case 't': plainText.push_back('\t'); break;
+        case '0': plainText.push_back('\0'); break;
+        case 'x':
+        {
+            unsigned int byteValue = 0;
+            const char* hexStart = escapedText.data() + charIndex + 1;
+            auto [hexEnd, hexError] = std::from_chars(hexStart, std::min(hexStart + 2, escapedText.data() + escapedText.size()), byteValue, 16);
+            if (hexError != std::errc() || hexEnd != hexStart + 2)
+            {
+                throw SignatureException(std::format("Service signatures line {}: \\x needs two hex digits", lineNumber));
+            }
+            plainText.push_back((char)byteValue);
+            charIndex += 2;
+            break;
+        }
+        default: plainText.push_back(escapedText[charIndex]); break;
+        }
+    }
+    return plainText;
+}
+
+/// <summary>
+/// Keep what is safe to print anywhere, every output format writes versions without escaping them.
+/// </summary>
+static std::string cleanVersion(std::string_view rawVersion)
+{
+    std::string cleanedVersion;
+    for (char versionChar : rawVersion)
+    {
+        if (versionChar == '\r' || versionChar == '\n' || cleanedVersion.size() >= SIGNATURE_MAX_VERSION)
+        {
+            break;
+        }
+        if (versionChar == ' ' || versionChar == '\t')
+        {
+            if (!cleanedVersion.empty())
+            {
+                cleanedVersion.push_back(' ');
+            }
+        }
+        else if (std::isalnum((unsigned char)versionChar) || std::strchr("._-/:()+~=@[]", versionChar) != nullptr)
+        {
+            cleanedVersion.push_back(versionChar);
+        }
+    }
+    while (!cleanedVersion.empty() && cleanedVersion.back() == ' ')
+    {
+        cleanedVersion.pop_back();
+    }
+    return cleanedVersion;
+}
+
+SignatureDatabase::SignatureDatabase(std::string_view signatureText)
+{
+    this->load(signatureText);
+}
+
+/// <summary>
+/// Parse the signatures file and compile it. Lines are tab separated, # starts a comment line.
+///   probe  name  payload  ports          ports is a comma list, default marks the probe for every other port
+///   udpprobe  name  payload  ports       the same for UDP ports, without a default
+///   match  service  pattern  [product]   matchi for a pattern that ignores case
+/// Patterns are anchored at the start of the response. * skips ahead to wherever the next literal first turns up,
+/// ? is any one byte and {v} captures the version up to the next literal or the end of the line.
+/// </summary>
+/// <param name="signatureText">the whole file</param>
+void SignatureDatabase::load(std::string_view signatureText)
+{
+    this->serviceSignatures.clear();
+    this->serviceProbes.clear();
+    this->udpProbes.clear();
+    this->defaultProbe = -1;
+    size_t lineNumber = 0;
+    std::vector<std::string_view> lineFields;
+    while (!signatureText.empty())
+    {
+        lineNumber++;
+        size_t lineEnd = std::min(signatureText.find('\n'), signatureText.size());
+        std::string_view fileLine = signatureText.substr(0, lineEnd);
+        signatureText.remove_prefix(std::min(lineEnd + 1, signatureText.size()));
+        if (!fileLine.empty() && fileLine.back() == '\r')
+        {
+            fileLine.remove_suffix(1);
+        }
+        if (fileLine.empty() || fileLine[0] == '#')
+        {
+            continue;
+        }
+        // runs of tabs count as one so the columns can be lined up
+        lineFields.clear();
+        while (!fileLine.empty())
+        {
+            size_t fieldEnd = std::min(fileLine.find('\t'), fileLine.size());
+            if (fieldEnd > 0)
+            {
+                lineFields.push_back(fileLine.substr(0, fieldEnd));
+            }
+            fileLine.remove_prefix(std::min(fieldEnd + 1, fileLine.size()));
+        }
+        if (lineFields[0] == "probe" || lineFields[0] == "udpprobe")
+        {
+            this->addProbe(lineFields, lineFields[0] == "udpprobe", lineNumber);
+        }
+        else if (lineFields[0] == "match" || lineFields[0] == "matchi")
+        {
+            this->addSignature(lineFields, lineFields[0] == "matchi", lineNumber);
+        }
+        else
+        {
+            throw SignatureException(std::format("Service signatures line {}: unknown directive {}", lineNumber, lineFields[0]));
+        }
+    }
+
+    this->keyAutomaton = LiteralAutomaton();
+    for (size_t signatureIndex = 0; signatureIndex < this->serviceSignatures.size(); signatureIndex++)
+    {
+        // the longest literal rules out the most banners, the pattern itself is only run on the ones that hold it
+        const PatternToken* keyToken = nullptr;
+        for (const PatternToken& patternToken : this->serviceSignatures[signatureIndex].patternTokens)
+        {
+            if (patternToken.tokenKind == TokenKind::Literal && (keyToken == nullptr || patternToken.literalText.size() > keyToken->literalText.size()))
+            {
+                keyToken = &patternToken;
+            }
+        }
+        this->keyAutomaton.addLiteral(keyToken->literalText, (uint32_t)signatureIndex);
+    }
+    this->keyAutomaton.compile();
+}
+
+void SignatureDatabase::addProbe(const std::vector<std::string_view>& lineFields, bool udpProbe, size_t lineNumber)
+{
+    if (lineFields.size() != 4)
+    {
+        throw SignatureException(std::format("Service signatures line {}: probe takes a name, a payload and ports", lineNumber));
+    }
+    ServiceProbe serviceProbe;
+    serviceProbe.probeName = lineFields[1];
+    serviceProbe.probeData = unescapeText(lineFields[2], lineNumber);
+    std::string_view portList = lineFields[3];
+    while (!portList.empty())
+    {
+        std::string_view portEntry = portList.substr(0, portList.find(','));
+        portList.remove_prefix(std::min(portEntry.size() + 1, portList.size()));
+        // a UDP port without a payload of its own gets an empty datagram, never a guess meant for another protocol
+        if (portEntry == "default" && !udpProbe)
+        {
+            this->defaultProbe = (int)this->serviceProbes.size();
+            continue;
+        }
+        int portNumber = 0;
+        auto [portEnd, portError] = std::from_chars(portEntry.data(), portEntry.data() + portEntry.size(), portNumber);
+        if (portError != std::errc() || portEnd != portEntry.data() + portEntry.size() || portNumber < 1 || portNumber > UINT16_MAX)
+        {
+            throw SignatureException(std::format("Service signatures line {}: bad port {}", lineNumber, portEntry));
+        }
+        serviceProbe.probePorts.push_back((uint16_t)portNumber);
+    }
+    (udpProbe ? this->udpProbes : this->serviceProbes).push_back(std::move(serviceProbe));
+}
+
+void SignatureDatabase::addSignature(const std::vector<std::string_view>& lineFields, bool ignoreCase, size_t lineNumber)
+{
+    if (lineFields.size() < 3 || lineFields.size() > 4)
+    {
+        throw SignatureException(std::format("Service signatures line {}: match takes a service, a pattern and an optional product", lineNumber));
+    }
+    ServiceSignature serviceSignature;
+    serviceSignature.serviceName = lineFields[1];
+    serviceSignature.productName = lineFields.size() > 3 ? lineFields[3] : "";
+    serviceSignature.ignoreCase = ignoreCase;
+
+    std::string_view patternText = lineFields[2];
+    std::vector<PatternToken>& patternTokens = serviceSignature.patternTokens;
+    for (size_t charIndex = 0; charIndex < patternText.size(); charIndex++)
+    {
+        char patternChar = patternText[charIndex];
+        TokenKind tokenKind = TokenKind::Literal;
+        if (patternChar == '*')
+        {
+            tokenKind = TokenKind::Skip;
+        }
+        else if (patternChar == '?')
+        {
+            tokenKind = TokenKind::AnyByte;
+        }
+        else if (patternText.substr(charIndex, 3) == "{v}")
+        {
+            tokenKind = TokenKind::Capture;
+            charIndex += 2;
+        }
+        if (tokenKind != TokenKind::Literal)
+        {
+            patternTokens.push_back({ tokenKind });
+            continue;
+        }
+        // an escape runs to the end of its sequence, the rest of the literal is unescaped as a whole
+        size_t literalEnd = charIndex;
+        while (literalEnd < patternText.size() && patternText[literalEnd] != '*' && patternText[literalEnd] != '?'
+            && patternText.substr(literalEnd, 3) != "{v}")
+        {
+            literalEnd += patternText[literalEnd] == '\\' ? 2 : 1;
+        }
+        literalEnd = std::min(literalEnd, patternText.size());
+        patternTokens.push_back({ TokenKind::Literal, unescapeText(patternText.substr(charIndex, literalEnd - charIndex), lineNumber) });
+        charIndex = literalEnd - 1;
+    }
+
+    bool hasLiteral = false;
+    for (size_t tokenIndex = 0; tokenIndex < patternTokens.size(); tokenIndex++)
+    {
+        hasLiteral = hasLiteral || patternTokens[tokenIndex].tokenKind == TokenKind::Literal;
+        TokenKind nextKind = tokenIndex + 1 < patternTokens.size() ? patternTokens[tokenIndex + 1].tokenKind : TokenKind::Literal;
+        // both look ahead to a literal to know where they stop
+        if ((patternTokens[tokenIndex].tokenKind == TokenKind::Skip || patternTokens[tokenIndex].tokenKind == TokenKind::Capture)
+            && nextKind != TokenKind::Literal)
+        {
+            throw SignatureException(std::format("Service signatures line {}: * and {{v}} have to be followed by text", lineNumber));
+        }
+    }
+    if (!hasLiteral || patternTokens.back().tokenKind == TokenKind::Skip)
+    {
+        throw SignatureException(std::format("Service signatures line {}: pattern needs some text and can't end in *", lineNumber));
+    }
+    this->serviceSignatures.push_back(std::move(serviceSignature));
+}
+
+/// <summary>
+/// Run one pattern against a response from its start. Skips take the first place the next literal turns up
+/// and there is no backtracking, so a check is a handful of finds whatever the response holds.
+/// </summary>
+/// <param name="versionCapture">set to what {v} took, left empty when the pattern has none</param>
+bool SignatureDatabase::matchSignature(const ServiceSignature& serviceSignature, std::string_view serviceResponse, std::string_view& versionCapture)
+{
+    const std::vector<PatternToken>& patternTokens = serviceSignature.patternTokens;
+    size_t responsePos = 0;
+    bool afterSkip = false;
+    for (size_t tokenIndex = 0; tokenIndex < patternTokens.size(); tokenIndex++)
+    {
+        const PatternToken& patternToken = patternTokens[tokenIndex];
+        switch (patternToken.tokenKind)
+        {
+        case TokenKind::Skip:
+            afterSkip = true;
+            break;
+        case TokenKind::AnyByte:
+            if (++responsePos > serviceResponse.size())
+            {
+                return false;
+            }
+            break;
+        case TokenKind::Literal:
+        {
+            std::string_view literalText = patternToken.literalText;
+            if (afterSkip)
+            {
+                responsePos = findLiteral(serviceResponse, literalText, responsePos, serviceSignature.ignoreCase);
+                if (responsePos == std::string_view::npos)
+                {
+                    return false;
+                }
+            }
+            else if (serviceResponse.size() - responsePos < literalText.size()
+                || !std::equal(literalText.begin(), literalText.end(), serviceResponse.begin() + responsePos,
+                    [&](char literalChar, char textChar) { return equalBytes(literalChar, textChar, serviceSignature.ignoreCase); }))
+            {
+                return false;
+            }
+            responsePos += literalText.size();
+            afterSkip = false;
+            break;
+        }
+        case TokenKind::Capture:
+        {
+            size_t lineEnd = findLineEnd(serviceResponse, responsePos);
+            size_t captureEnd = lineEnd;
+            // the closing literal has to be on the same line, it is consumed along with the capture
+            if (tokenIndex + 1 < patternTokens.size())
+            {
+                std::string_view closingText = patternTokens[++tokenIndex].literalText;
+                captureEnd = findLiteral(serviceResponse.substr(0, lineEnd), closingText, responsePos, serviceSignature.ignoreCase);
+                if (captureEnd == std::string_view::npos)
+                {
+                    return false;
+                }
+                versionCapture = serviceResponse.substr(responsePos, captureEnd - responsePos);
+                responsePos = captureEnd + closingText.size();
+                break;
+            }
+            versionCapture = serviceResponse.substr(responsePos, captureEnd - responsePos);
+            responsePos = captureEnd;
+            break;
+        }
+        }
+    }
+    return true;
+}
+
+/// <summary>
+/// Work out the service from what it sent, from its greeting or from its answer to a probe.
+/// One pass of the automaton picks the signatures worth trying, they are then tried in file order and the first one to match wins.
+/// </summary>
+/// <param name="portNumber">copied into the match</param>
+/// <param name="serviceResponse">bytes read from the service, possibly cut short</param>
+/// <returns>the service and its version where recognised, otherwise the first line of the response as the version</returns>
+ServiceMatch SignatureDatabase::matchResponse(uint16_t portNumber, std::string_view serviceResponse) const
+{
+    ServiceMatch serviceMatch;
+    serviceMatch.portNumber = portNumber;
+    std::vector<uint32_t> candidateIds;
+    this->keyAutomaton.findAll(serviceResponse, candidateIds);
+    std::sort(candidateIds.begin(), candidateIds.end());
+    candidateIds.erase(std::unique(candidateIds.begin(), candidateIds.end()), candidateIds.end());
+    for (uint32_t candidateId : candidateIds)
+    {
+        const ServiceSignature& serviceSignature = this->serviceSignatures[candidateId];
+        std::string_view versionCapture;
+        if (!matchSignature(serviceSignature, serviceResponse, versionCapture))
+        {
+            continue;
+        }
+        serviceMatch.serviceName = serviceSignature.serviceName;
+        std::string serviceVersion = serviceSignature.productName;
+        if (!serviceVersion.empty() && !versionCapture.empty())
+        {
+            serviceVersion += ' ';
+        }
+        serviceVersion += versionCapture;
+        serviceMatch.serviceVersion = cleanVersion(serviceVersion);
+        return serviceMatch;
+    }
+    serviceMatch.serviceVersion = cleanVersion(serviceResponse);
+    return serviceMatch;
+}
+
+/// <summary>
+/// The probe to send a port's service.
+/// </summary>
+/// <param name="sendFirst">set when the port's service is known to wait on the client, so the probe can go without waiting for a banner</param>
+/// <returns>nullptr when the port has no probe and there is no default</returns>
+const ServiceProbe* SignatureDatabase::findProbe(uint16_t portNumber, bool& sendFirst) const
+{
+    for (const ServiceProbe& serviceProbe : this->serviceProbes)
+    {
+        if (std::find(serviceProbe.probePorts.begin(), serviceProbe.probePorts.end(), portNumber) != serviceProbe.probePorts.end())
+        {
+            sendFirst = true;
+            return &serviceProbe;
+        }
+    }
+    sendFirst = false;
+    return this->defaultProbe >= 0 ? &this->serviceProbes[this->defaultProbe] : nullptr;
+}
+
+/// <summary>
+/// The payload a UDP scan sends a port, nullptr when it has none.
+/// </summary>
+const ServiceProbe* SignatureDatabase::findUdpProbe(uint16_t portNumber) const
+{
+    for (const ServiceProbe& udpProbe : this->udpProbes)
+    {
+        if (std::find(udpProbe.probePorts.begin(), udpProbe.probePorts.end(), portNumber) != udpProbe.probePorts.end())
+        {
+            return &udpProbe;
+        }
+    }
+    return nullptr;
+}
+
+size_t SignatureDatabase::getSignatureCount() const
+{
+    return this->serviceSignatures.size();
+}
+
+/// <summary>
+/// The one database, compiled from the embedded signatures the first time it is asked for.
+/// </summary>
+const SignatureDatabase& getSignatureDatabase()
+{
+    static const SignatureDatabase signatureDatabase(std::string_view(SIGNATURE_TEXT, sizeof(SIGNATURE_TEXT) - 1));
+    return signatureDatabase;
+}
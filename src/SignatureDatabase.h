@@ -0,0 +1,94 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// SignatureDatabase:
+// Service probes and banner signatures from res/service-signatures, compiled once for matching many banners quickly. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include "LiteralAutomaton.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// longest version string kept from a banner
+constexpr size_t SIGNATURE_MAX_VERSION = 80;
+
+// what a service's banner or probe response said it was, the name is empty when nothing recognised it
+struct ServiceMatch
+{
+	uint16_t portNumber = 0;
+	std::string serviceName{};
+	// product and version as the service gave them, or the first line of an unrecognised banner
+	std::string serviceVersion{};
+};
+
+// sent to services that don't speak first, and to every UDP port a scan has a payload for
+struct ServiceProbe
+{
+	std::string probeName{};
+	std::string probeData{};
+	// ports whose services always wait on the client, these get the probe as soon as they connect
+	std::vector<uint16_t> probePorts{};
+};
+
+class SignatureDatabase
+{
+public:
+	SignatureDatabase() = default;
+	explicit SignatureDatabase(std::string_view signatureText);
+	SignatureDatabase(const SignatureDatabase&) = delete;
+	SignatureDatabase& operator=(const SignatureDatabase&) = delete;
+public:
+	void load(std::string_view signatureText);
+	ServiceMatch matchResponse(uint16_t portNumber, std::string_view serviceResponse) const;
+	const ServiceProbe* findProbe(uint16_t portNumber, bool& sendFirst) const;
+	const ServiceProbe* findUdpProbe(uint16_t portNumber) const;
+	size_t getSignatureCount() const;
+private:
+	enum class TokenKind : uint8_t { Literal, AnyByte, Skip, Capture };
+	struct PatternToken
+	{
+		TokenKind tokenKind;
+		std::string literalText{};
+	};
+	struct ServiceSignature
+	{
+		std::string serviceName;
+		// put in front of the captured version, when the signature names the product
+		std::string productName;
+		std::vector<PatternToken> patternTokens;
+		bool ignoreCase;
+	};
+	void addProbe(const std::vector<std::string_view>& lineFields, bool udpProbe, size_t lineNumber);
+	void addSignature(const std::vector<std::string_view>& lineFields, bool ignoreCase, size_t lineNumber);
+	static bool matchSignature(const ServiceSignature& serviceSignature, std::string_view serviceResponse, std::string_view& versionCapture);
+private:
+	// in file order, which is also the order they are tried in
+	std::vector<ServiceSignature> serviceSignatures;
+	std::vector<ServiceProbe> serviceProbes;
+	std::vector<ServiceProbe> udpProbes;
+	// sent after the wait to ports no probe lists, -1 for none
+	int defaultProbe = -1;
+	// every signature's longest literal, a banner only has to be checked against the signatures whose literal it holds
+	LiteralAutomaton keyAutomaton;
+};
+
+const SignatureDatabase& getSignatureDatabase();
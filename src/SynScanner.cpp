@@ -0,0 +1,309 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// SynScanner:
+// Stateless half-open TCP scanning over a raw socket, Linux only.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "SynScanner.h"
+#include <stdexcept>
+#include <format>
+#include <random>
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+class NetException : public std::runtime_error {
+public:
+    NetException(const std::string& message)
+        : std::runtime_error(message) {}
+};
+
+#ifdef __linux__
+
+// TCP header plus a single MSS option, some stacks ignore a SYN without one
+constexpr int SYN_PACKET_SIZE = 24;
+constexpr uint16_t SYN_WINDOW = 1024;
+constexpr uint16_t SYN_MSS = 1460;
+// kernel buffers for the raw socket, replies arrive in bursts at high send rates
+constexpr int SYN_SOCKET_BUFFER = 8 * 1024 * 1024;
+// source ports are picked per run from this range
+constexpr uint16_t SYN_PORT_BASE = 40000;
+constexpr uint16_t SYN_PORT_SPAN = 20000;
+
+constexpr uint8_t TCP_FLAG_SYN = 0x02;
+constexpr uint8_t TCP_FLAG_RST = 0x04;
+constexpr uint8_t TCP_FLAG_ACK = 0x10;
+
+static void writeShort(uint8_t* buffer, uint16_t value)
+{
+    buffer[0] = (uint8_t)(value >> 8);
+    buffer[1] = (uint8_t)value;
+}
+
+static void writeLong(uint8_t* buffer, uint32_t value)
+{
+    writeShort(buffer, (uint16_t)(value >> 16));
+    writeShort(buffer + 2, (uint16_t)value);
+}
+
+static uint16_t readShort(const uint8_t* buffer)
+{
+    return (uint16_t)((buffer[0] << 8) | buffer[1]);
+}
+
+static uint32_t readLong(const uint8_t* buffer)
+{
+    return ((uint32_t)readShort(buffer) << 16) | readShort(buffer + 2);
+}
+
+/// <summary>
+/// One's complement checksum over the IPv4 pseudo header and the TCP segment.
+/// </summary>
+static uint16_t tcpChecksum(uint32_t sourceAddr, uint32_t targetAddr, const uint8_t* segment, int segmentLength)
+{
+    uint32_t checkSum = 0;
+    checkSum += (sourceAddr >> 16) + (sourceAddr & 0xFFFF);
+    checkSum += (targetAddr >> 16) + (targetAddr & 0xFFFF);
+    checkSum += IPPROTO_TCP + segmentLength;
+    for (int i = 0; i + 1 < segmentLength; i += 2)
+    {
+        checkSum += readShort(segment + i);
+    }
+    if (segmentLength & 1)
+    {
+        checkSum += (uint32_t)segment[segmentLength - 1] << 8;
+    }
+    while (checkSum >> 16)
+    {
+        checkSum = (checkSum & 0xFFFF) + (checkSum >> 16);
+    }
+    return (uint16_t)~checkSum;
+}
+
+/// <summary>
+/// Open the raw socket and pick the source address the kernel would route routeAddr through.
+/// </summary>
+/// <param name="routeAddr">any target address (host order), used to find the outgoing interface</param>
+SynScanner::SynScanner(uint32_t routeAddr)
+{
+    this->rawSocket = socket(AF_INET, SOCK_RAW, IPPROTO_TCP);
+    if (this->rawSocket < 0)
+    {
+        throw NetException(std::format("Failed to open raw socket: {}\n", strerror(errno)));
+    }
+    int bufferSize = SYN_SOCKET_BUFFER;
+    setsockopt(this->rawSocket, SOL_SOCKET, SO_SNDBUF, &bufferSize, sizeof(bufferSize));
+    setsockopt(this->rawSocket, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+    // connecting a UDP socket sends nothing but makes the kernel choose a source address
+    int routeSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in routeTarget{};
+    routeTarget.sin_family = AF_INET;
+    routeTarget.sin_port = htons(53);
+    routeTarget.sin_addr.s_addr = htonl(routeAddr);
+    sockaddr_in localAddr{};
+    socklen_t localLen = sizeof(localAddr);
+    if (routeSocket < 0 || connect(routeSocket, (sockaddr*)&routeTarget, sizeof(routeTarget)) != 0
+        || getsockname(routeSocket, (sockaddr*)&localAddr, &localLen) != 0)
+    {
+        int routeError = errno;
+        if (routeSocket >= 0)
+        {
+            close(routeSocket);
+        }
+        close(this->rawSocket);
+        throw NetException(std::format("Failed to find a route for the SYN scan: {}\n", strerror(routeError)));
+    }
+    close(routeSocket);
+    this->sourceAddr = ntohl(localAddr.sin_addr.s_addr);
+
+    std::random_device randomDevice;
+    this->sourcePort = (uint16_t)(SYN_PORT_BASE + randomDevice() % SYN_PORT_SPAN);
+    this->cookieSecret = ((uint64_t)randomDevice() << 32) | randomDevice();
+}
+
+SynScanner::~SynScanner()
+{
+    this->stopReceiver();
+    if (this->rawSocket >= 0)
+    {
+        close(this->rawSocket);
+    }
+}
+
+/// <summary>
+/// Raw sockets need root or CAP_NET_RAW, so just try to open one.
+/// </summary>
+bool SynScanner::isSupported()
+{
+    static const bool rawSupported = []() {
+        int testSocket = socket(AF_INET, SOCK_RAW, IPPROTO_TCP);
+        if (testSocket < 0)
+        {
+            return false;
+        }
+        close(testSocket);
+        return true;
+    }();
+    return rawSupported;
+}
+
+/// <summary>
+/// Keyed hash of the target, XORed into the sequence number so only genuine replies decode to a probe.
+/// </summary>
+uint32_t SynScanner::getCookie(uint32_t targetAddr, uint16_t targetPort)
+{
+    // splitmix64 finaliser
+    uint64_t cookieHash = this->cookieSecret ^ (((uint64_t)targetAddr << 16) | targetPort);
+    cookieHash = (cookieHash ^ (cookieHash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    cookieHash = (cookieHash ^ (cookieHash >> 27)) * 0x94D049BB133111EBULL;
+    cookieHash ^= cookieHash >> 31;
+    return (uint32_t)cookieHash;
+}
+
+/// <summary>
+/// Build and send a single SYN, nothing is remembered about it afterwards.
+/// The probe id travels in the sequence number and comes back as ack - 1.
+/// Safe to call from several threads at once.
+/// </summary>
+/// <param name="targetAddr">host order IPv4 address</param>
+/// <param name="targetPort">port to probe</param>
+/// <param name="probeId">caller's identifier for this probe</param>
+void SynScanner::sendProbe(uint32_t targetAddr, uint16_t targetPort, uint32_t probeId)
+{
+    uint8_t synPacket[SYN_PACKET_SIZE]{};
+    writeShort(synPacket, this->sourcePort);
+    writeShort(synPacket + 2, targetPort);
+    writeLong(synPacket + 4, probeId ^ this->getCookie(targetAddr, targetPort));
+    synPacket[12] = (SYN_PACKET_SIZE / 4) << 4;
+    synPacket[13] = TCP_FLAG_SYN;
+    writeShort(synPacket + 14, SYN_WINDOW);
+    synPacket[20] = 2;
+    synPacket[21] = 4;
+    writeShort(synPacket + 22, SYN_MSS);
+    writeShort(synPacket + 16, tcpChecksum(this->sourceAddr, targetAddr, synPacket, SYN_PACKET_SIZE));
+
+    sockaddr_in targetSock{};
+    targetSock.sin_family = AF_INET;
+    targetSock.sin_addr.s_addr = htonl(targetAddr);
+    // the socket is blocking so a full send buffer just slows the sender down
+    while (sendto(this->rawSocket, synPacket, SYN_PACKET_SIZE, 0, (sockaddr*)&targetSock, sizeof(targetSock)) < 0)
+    {
+        if (errno != EINTR && errno != ENOBUFS)
+        {
+            break;
+        }
+    }
+}
+
+/// <summary>
+/// Start classifying replies on a background thread.
+/// </summary>
+void SynScanner::startReceiver(SynReplyHandler replyHandler)
+{
+    this->stopReceiver();
+    this->receiverEnabled = true;
+    this->receiverThread = std::thread(&SynScanner::receiveReplies, this, replyHandler);
+}
+
+void SynScanner::stopReceiver()
+{
+    this->receiverEnabled = false;
+    if (this->receiverThread.joinable())
+    {
+        this->receiverThread.join();
+    }
+}
+
+/// <summary>
+/// Receiver loop, every inbound TCP packet is copied to the raw socket so filter for our port and cookie.
+/// SYN-ACK means open, RST means closed, anything else is ignored.
+/// </summary>
+void SynScanner::receiveReplies(SynReplyHandler replyHandler)
+{
+    uint8_t recvBuffer[2048];
+    pollfd recvPoll{ this->rawSocket, POLLIN, 0 };
+    while (this->receiverEnabled)
+    {
+        if (::poll(&recvPoll, 1, SYN_RECV_INTERVAL) <= 0)
+        {
+            continue;
+        }
+        while (true)
+        {
+            ssize_t recvLength = recv(this->rawSocket, recvBuffer, sizeof(recvBuffer), MSG_DONTWAIT);
+            if (recvLength <= 0)
+            {
+                break;
+            }
+            int headerLength = (recvBuffer[0] & 0x0F) * 4;
+            if ((recvBuffer[0] >> 4) != 4 || recvBuffer[9] != IPPROTO_TCP || recvLength < headerLength + 20)
+            {
+                continue;
+            }
+            const uint8_t* tcpHeader = recvBuffer + headerLength;
+            uint8_t tcpFlags = tcpHeader[13];
+            if (readLong(recvBuffer + 16) != this->sourceAddr || readShort(tcpHeader + 2) != this->sourcePort
+                || !(tcpFlags & TCP_FLAG_ACK))
+            {
+                continue;
+            }
+            bool isOpen = (tcpFlags & (TCP_FLAG_SYN | TCP_FLAG_ACK)) == (TCP_FLAG_SYN | TCP_FLAG_ACK);
+            if (!isOpen && !(tcpFlags & TCP_FLAG_RST))
+            {
+                continue;
+            }
+            uint32_t replyAddr = readLong(recvBuffer + 12);
+            uint16_t replyPort = readShort(tcpHeader);
+            uint32_t probeId = (readLong(tcpHeader + 8) - 1) ^ this->getCookie(replyAddr, replyPort);
+            replyHandler(probeId, replyAddr, replyPort, isOpen);
+        }
+    }
+}
+
+#else
+
+SynScanner::SynScanner(uint32_t routeAddr)
+{
+    throw NetException("SYN scanning needs raw TCP sockets which are only available on Linux\n");
+}
+
+SynScanner::~SynScanner() {}
+
+// Windows refuses to send TCP over raw sockets
+bool SynScanner::isSupported()
+{
+    return false;
+}
+
+void SynScanner::startReceiver(SynReplyHandler replyHandler) {}
+
+void SynScanner::stopReceiver() {}
+
+void SynScanner::sendProbe(uint32_t targetAddr, uint16_t targetPort, uint32_t probeId) {}
+
+#endif
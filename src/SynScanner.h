@@ -0,0 +1,63 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// SynScanner:
+// Stateless half-open TCP scanning over a raw socket, Linux only. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+// time in ms to keep listening for replies after the last SYN has gone out
+constexpr int SYN_GRACE_PERIOD = 1000;
+// upper bound in ms for a single wait on the receive socket
+constexpr int SYN_RECV_INTERVAL = 50;
+
+// called from the receiver thread for every reply that carries one of our cookies
+// addresses and ports are host order, isOpen is true for SYN-ACK and false for RST
+using SynReplyHandler = std::function<void(uint32_t probeId, uint32_t sourceAddr, uint16_t sourcePort, bool isOpen)>;
+
+class SynScanner
+{
+public:
+	SynScanner(uint32_t routeAddr);
+	~SynScanner();
+	SynScanner(const SynScanner&) = delete;
+	SynScanner& operator=(const SynScanner&) = delete;
+public:
+	static bool isSupported();
+	void startReceiver(SynReplyHandler replyHandler);
+	void stopReceiver();
+	void sendProbe(uint32_t targetAddr, uint16_t targetPort, uint32_t probeId);
+#ifdef __linux__
+private:
+	uint32_t getCookie(uint32_t targetAddr, uint16_t targetPort);
+	void receiveReplies(SynReplyHandler replyHandler);
+private:
+	int rawSocket = -1;
+	uint32_t sourceAddr = 0;
+	uint16_t sourcePort = 0;
+	uint64_t cookieSecret = 0;
+	std::thread receiverThread;
+	std::atomic<bool> receiverEnabled{ false };
+#endif
+};
@@ -0,0 +1,183 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// TargetSpace:
+// The set of IPv4 hosts a scan targets, held as address ranges and expanded on demand.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "TargetSpace.h"
+#include <algorithm>
+#include <format>
+#include <charconv>
+
+TargetSpace::Iterator::Iterator(const TargetSpace* targetSpace, size_t rangeIndex)
+{
+    this->targetSpace = targetSpace;
+    this->rangeIndex = rangeIndex;
+}
+
+uint32_t TargetSpace::Iterator::operator*() const
+{
+    return this->targetSpace->targetRanges[this->rangeIndex].firstAddr + this->rangeOffset;
+}
+
+TargetSpace::Iterator& TargetSpace::Iterator::operator++()
+{
+    const TargetRange& targetRange = this->targetSpace->targetRanges[this->rangeIndex];
+    if (this->rangeOffset == targetRange.lastAddr - targetRange.firstAddr)
+    {
+        this->rangeIndex++;
+        this->rangeOffset = 0;
+    }
+    else
+    {
+        this->rangeOffset++;
+    }
+    return *this;
+}
+
+TargetSpace::Iterator TargetSpace::Iterator::operator++(int)
+{
+    Iterator lastPosition = *this;
+    ++(*this);
+    return lastPosition;
+}
+
+bool TargetSpace::Iterator::operator==(const Iterator& otherIterator) const
+{
+    return this->rangeIndex == otherIterator.rangeIndex && this->rangeOffset == otherIterator.rangeOffset;
+}
+
+/// <summary>
+/// Add every address from firstAddr to lastAddr inclusive, both in host order.
+/// Costs the same for a single host as for a /8.
+/// </summary>
+void TargetSpace::addRange(uint32_t firstAddr, uint32_t lastAddr)
+{
+    if (lastAddr < firstAddr)
+    {
+        return;
+    }
+    this->targetRanges.push_back({ firstAddr, lastAddr });
+    this->rangeOffsets.push_back(this->hostCount);
+    this->hostCount += (size_t)(lastAddr - firstAddr) + 1;
+}
+
+void TargetSpace::addAddress(uint32_t hostAddr)
+{
+    this->addRange(hostAddr, hostAddr);
+}
+
+size_t TargetSpace::size() const
+{
+    return this->hostCount;
+}
+
+bool TargetSpace::empty() const
+{
+    return this->hostCount == 0;
+}
+
+/// <summary>
+/// Address of the host at a given index, in the order the iterator would produce it.
+/// </summary>
+uint32_t TargetSpace::getAddress(size_t hostIndex) const
+{
+    // the last range starting at or before the index holds it
+    size_t rangeIndex = std::upper_bound(this->rangeOffsets.begin(), this->rangeOffsets.end(), hostIndex)
+        - this->rangeOffsets.begin() - 1;
+    return this->targetRanges[rangeIndex].firstAddr + (uint32_t)(hostIndex - this->rangeOffsets[rangeIndex]);
+}
+
+/// <summary>
+/// Index of a host from its address, the reverse of getAddress. Ranges are searched in order,
+/// so an address given twice maps to its first index.
+/// </summary>
+/// <returns>false when the address isn't a target</returns>
+bool TargetSpace::findIndex(uint32_t hostAddr, size_t& hostIndex) const
+{
+    for (size_t rangeIndex = 0; rangeIndex < this->targetRanges.size(); rangeIndex++)
+    {
+        const TargetRange& targetRange = this->targetRanges[rangeIndex];
+        if (hostAddr >= targetRange.firstAddr && hostAddr <= targetRange.lastAddr)
+        {
+            hostIndex = this->rangeOffsets[rangeIndex] + (hostAddr - targetRange.firstAddr);
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::vector<TargetRange>& TargetSpace::getRanges() const
+{
+    return this->targetRanges;
+}
+
+TargetSpace::Iterator TargetSpace::begin() const
+{
+    return Iterator(this, 0);
+}
+
+TargetSpace::Iterator TargetSpace::end() const
+{
+    return Iterator(this, this->targetRanges.size());
+}
+
+// dotted quad for a host order address, only needed once results are printed
+std::string TargetSpace::formatAddress(uint32_t hostAddr)
+{
+    return std::format("{}.{}.{}.{}", hostAddr >> 24, (hostAddr >> 16) & 0xFF, (hostAddr >> 8) & 0xFF, hostAddr & 0xFF);
+}
+
+/// <summary>
+/// Read a dotted quad back into a host order address, the reverse of formatAddress.
+/// </summary>
+/// <returns>false unless the text is exactly four octets</returns>
+bool TargetSpace::parseAddress(std::string_view addrString, uint32_t& hostAddr)
+{
+    uint32_t parsedAddr = 0;
+    const char* addrPos = addrString.data();
+    const char* addrEnd = addrString.data() + addrString.size();
+    for (int octetIndex = 0; octetIndex < 4; octetIndex++)
+    {
+        if (octetIndex > 0)
+        {
+            if (addrPos == addrEnd || *addrPos != '.')
+            {
+                return false;
+            }
+            addrPos++;
+        }
+        unsigned int octetValue = 0;
+        auto [parseEnd, parseError] = std::from_chars(addrPos, addrEnd, octetValue);
+        if (parseError != std::errc() || parseEnd == addrPos || octetValue > 255)
+        {
+            return false;
+        }
+        parsedAddr = (parsedAddr << 8) | octetValue;
+        addrPos = parseEnd;
+    }
+    if (addrPos != addrEnd)
+    {
+        return false;
+    }
+    hostAddr = parsedAddr;
+    return true;
+}
@@ -0,0 +1,83 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// TargetSpace:
+// The set of IPv4 hosts a scan targets, held as address ranges and expanded on demand. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+
+// inclusive run of host order IPv4 addresses
+struct TargetRange
+{
+	uint32_t firstAddr = 0;
+	uint32_t lastAddr = 0;
+};
+
+class TargetSpace
+{
+public:
+	// walks every address in order without materialising any of them
+	class Iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = uint32_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const uint32_t*;
+		using reference = uint32_t;
+		Iterator() = default;
+		Iterator(const TargetSpace* targetSpace, size_t rangeIndex);
+	public:
+		uint32_t operator*() const;
+		Iterator& operator++();
+		Iterator operator++(int);
+		bool operator==(const Iterator& otherIterator) const;
+	private:
+		const TargetSpace* targetSpace = nullptr;
+		size_t rangeIndex = 0;
+		// distance into the current range, kept apart from the address so 255.255.255.255 can't wrap
+		uint32_t rangeOffset = 0;
+	};
+public:
+	TargetSpace() = default;
+public:
+	void addRange(uint32_t firstAddr, uint32_t lastAddr);
+	void addAddress(uint32_t hostAddr);
+	size_t size() const;
+	bool empty() const;
+	uint32_t getAddress(size_t hostIndex) const;
+	bool findIndex(uint32_t hostAddr, size_t& hostIndex) const;
+	const std::vector<TargetRange>& getRanges() const;
+	Iterator begin() const;
+	Iterator end() const;
+	static std::string formatAddress(uint32_t hostAddr);
+	static bool parseAddress(std::string_view addrString, uint32_t& hostAddr);
+private:
+	std::vector<TargetRange> targetRanges;
+	// index of the first host in each range, for mapping a host index back to its address
+	std::vector<size_t> rangeOffsets;
+	size_t hostCount = 0;
+};
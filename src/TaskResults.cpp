@@ -0,0 +1,245 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// TaskResults:
+// What a TCP sweep has finished, the chunks of the task order that are done and the answers found in them.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "TaskResults.h"
+#include <algorithm>
+
+/// <summary>
+/// Start a sweep with nothing done.
+/// </summary>
+/// <param name="portCount">ports per host, task t is host (t / portCount) on port (t % portCount)</param>
+/// <param name="chunkCount">chunks the scheduler split the task order into</param>
+TaskResults::TaskResults(size_t portCount, uint64_t chunkCount)
+    : doneChunks((chunkCount + 63) / 64)
+{
+    this->portCount = portCount;
+    this->chunkCount = chunkCount;
+}
+
+// every task in the chunk has an answer or has timed out, safe to call from any worker
+void TaskResults::markChunkDone(uint64_t chunkIndex)
+{
+    uint64_t chunkBit = (uint64_t)1 << (chunkIndex % 64);
+    if (!(this->doneChunks[chunkIndex / 64].fetch_or(chunkBit, std::memory_order_release) & chunkBit))
+    {
+        this->doneCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// every SYN in the chunk has gone out, it is done once replies have had their grace period
+void TaskResults::markChunkSent(uint64_t chunkIndex)
+{
+    std::lock_guard<std::mutex> sentGuard(this->sentLock);
+    this->sentChunks.push_back({ chunkIndex, std::chrono::steady_clock::now() });
+}
+
+/// <summary>
+/// Mark done the sent chunks whose replies have had time to land.
+/// </summary>
+/// <param name="graceTime">ms a chunk has to have been out for, 0 settles every sent chunk</param>
+void TaskResults::settleChunks(int graceTime)
+{
+    auto sentBefore = std::chrono::steady_clock::now() - std::chrono::milliseconds(graceTime);
+    std::lock_guard<std::mutex> sentGuard(this->sentLock);
+    while (!this->sentChunks.empty() && (graceTime == 0 || this->sentChunks.front().sentAt <= sentBefore))
+    {
+        this->markChunkDone(this->sentChunks.front().chunkIndex);
+        this->sentChunks.pop_front();
+    }
+}
+
+bool TaskResults::isChunkDone(uint64_t chunkIndex) const
+{
+    return this->doneChunks[chunkIndex / 64].load(std::memory_order_acquire) >> (chunkIndex % 64) & 1;
+}
+
+// every chunk done, so every task not answered went unanswered
+bool TaskResults::isComplete() const
+{
+    return this->doneCount.load(std::memory_order_relaxed) == this->chunkCount;
+}
+
+uint64_t TaskResults::getChunkCount() const
+{
+    return this->chunkCount;
+}
+
+// snapshot of the done bitmap, a chunk finishing meanwhile may or may not make it in
+std::vector<uint64_t> TaskResults::getDoneChunks() const
+{
+    std::vector<uint64_t> doneWords;
+    doneWords.reserve(this->doneChunks.size());
+    for (const std::atomic<uint64_t>& doneWord : this->doneChunks)
+    {
+        doneWords.push_back(doneWord.load(std::memory_order_acquire));
+    }
+    return doneWords;
+}
+
+/// <summary>
+/// Record a task's answer, only the first answer to a task counts.
+/// </summary>
+/// <param name="isOpen">false for a refused connect or a RST</param>
+/// <returns>false when the task had already answered, a duplicate reply or one restored from a checkpoint</returns>
+bool TaskResults::addAnswer(uint64_t taskIndex, bool isOpen)
+{
+    uint64_t hostIndex = taskIndex / this->portCount;
+    uint16_t portIndex = (uint16_t)(taskIndex % this->portCount);
+    AnswerStripe& answerStripe = this->answerStripes[hostIndex % TASK_RESULT_STRIPES];
+    std::lock_guard<std::mutex> stripeGuard(answerStripe.stripeLock);
+    HostAnswers& hostAnswers = answerStripe.hostAnswers[hostIndex];
+    if (hostAnswers.openPorts.contains(portIndex) || hostAnswers.closedPorts.contains(portIndex))
+    {
+        return false;
+    }
+    (isOpen ? hostAnswers.openPorts : hostAnswers.closedPorts).insert(portIndex);
+    return true;
+}
+
+// hosts with at least one answer, in index order
+std::vector<uint64_t> TaskResults::getAnsweredHosts() const
+{
+    std::vector<uint64_t> answeredHosts;
+    for (const AnswerStripe& answerStripe : this->answerStripes)
+    {
+        std::lock_guard<std::mutex> stripeGuard(answerStripe.stripeLock);
+        for (const auto& [hostIndex, hostAnswers] : answerStripe.hostAnswers)
+        {
+            answeredHosts.push_back(hostIndex);
+        }
+    }
+    std::sort(answeredHosts.begin(), answeredHosts.end());
+    return answeredHosts;
+}
+
+/// <summary>
+/// A host's answers as port indexes, both sets are left empty for a host that never answered.
+/// </summary>
+void TaskResults::getHostAnswers(uint64_t hostIndex, PortSet& openPorts, PortSet& closedPorts) const
+{
+    const AnswerStripe& answerStripe = this->answerStripes[hostIndex % TASK_RESULT_STRIPES];
+    std::lock_guard<std::mutex> stripeGuard(answerStripe.stripeLock);
+    auto hostEntry = answerStripe.hostAnswers.find(hostIndex);
+    if (hostEntry == answerStripe.hostAnswers.end())
+    {
+        openPorts.clear();
+        closedPorts.clear();
+        return;
+    }
+    openPorts = hostEntry->second.openPorts;
+    closedPorts = hostEntry->second.closedPorts;
+}
+
+// every answer so far as task indexes, for a checkpoint
+void TaskResults::getAnswers(std::vector<uint64_t>& openTasks, std::vector<uint64_t>& closedTasks) const
+{
+    openTasks.clear();
+    closedTasks.clear();
+    for (const AnswerStripe& answerStripe : this->answerStripes)
+    {
+        std::lock_guard<std::mutex> stripeGuard(answerStripe.stripeLock);
+        for (const auto& [hostIndex, hostAnswers] : answerStripe.hostAnswers)
+        {
+            for (uint16_t portIndex : hostAnswers.openPorts.getPorts())
+            {
+                openTasks.push_back(hostIndex * this->portCount + portIndex);
+            }
+            for (uint16_t portIndex : hostAnswers.closedPorts.getPorts())
+            {
+                closedTasks.push_back(hostIndex * this->portCount + portIndex);
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Take back what a checkpoint had, before any worker starts.
+/// </summary>
+/// <returns>how many chunks were already done</returns>
+uint64_t TaskResults::restore(const std::vector<uint64_t>& doneChunks, const std::vector<uint64_t>& openTasks, const std::vector<uint64_t>& closedTasks)
+{
+    for (uint64_t chunkIndex = 0; chunkIndex < this->chunkCount && chunkIndex / 64 < doneChunks.size(); chunkIndex++)
+    {
+        if (doneChunks[chunkIndex / 64] >> (chunkIndex % 64) & 1)
+        {
+            this->markChunkDone(chunkIndex);
+        }
+    }
+    for (uint64_t openTask : openTasks)
+    {
+        this->addAnswer(openTask, true);
+    }
+    for (uint64_t closedTask : closedTasks)
+    {
+        this->addAnswer(closedTask, false);
+    }
+    return this->doneCount.load(std::memory_order_relaxed);
+}
+
+ChunkTracker::ChunkTracker(TaskResults& taskResults)
+    : taskResults(taskResults)
+{
+}
+
+// the worker has started walking a chunk, it can't be done before closeChunk
+void ChunkTracker::openChunk(uint64_t chunkIndex)
+{
+    this->pendingProbes[chunkIndex] = 1;
+}
+
+void ChunkTracker::addProbe(uint64_t taskIndex, uint64_t chunkIndex)
+{
+    this->pendingProbes[chunkIndex]++;
+    this->probeChunks[taskIndex] = chunkIndex;
+}
+
+// a probe came back answered or timed out, its answer has to be recorded first
+void ChunkTracker::finishProbe(uint64_t taskIndex)
+{
+    auto probeEntry = this->probeChunks.find(taskIndex);
+    if (probeEntry == this->probeChunks.end())
+    {
+        return;
+    }
+    uint64_t chunkIndex = probeEntry->second;
+    this->probeChunks.erase(probeEntry);
+    this->releaseChunk(chunkIndex);
+}
+
+// the walk reached the end of the chunk, a walk cut short never closes it so it is probed again on resume
+void ChunkTracker::closeChunk(uint64_t chunkIndex)
+{
+    this->releaseChunk(chunkIndex);
+}
+
+void ChunkTracker::releaseChunk(uint64_t chunkIndex)
+{
+    auto chunkEntry = this->pendingProbes.find(chunkIndex);
+    if (chunkEntry == this->pendingProbes.end() || --chunkEntry->second > 0)
+    {
+        return;
+    }
+    this->pendingProbes.erase(chunkEntry);
+    this->taskResults.markChunkDone(chunkIndex);
+}
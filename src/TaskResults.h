@@ -0,0 +1,106 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// TaskResults:
+// What a TCP sweep has finished, the chunks of the task order that are done and the answers found in them. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <vector>
+#include <deque>
+#include <array>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include "PortSet.h"
+
+// locks shared out over the answering hosts by index
+constexpr size_t TASK_RESULT_STRIPES = 64;
+
+// a task is done once its chunk is, and a done task without an answer went unanswered,
+// so silence costs nothing and memory follows the hosts that answered
+class TaskResults
+{
+public:
+	TaskResults(size_t portCount, uint64_t chunkCount);
+	TaskResults(const TaskResults&) = delete;
+	TaskResults& operator=(const TaskResults&) = delete;
+public:
+	void markChunkDone(uint64_t chunkIndex);
+	void markChunkSent(uint64_t chunkIndex);
+	void settleChunks(int graceTime);
+	bool isChunkDone(uint64_t chunkIndex) const;
+	bool isComplete() const;
+	uint64_t getChunkCount() const;
+	std::vector<uint64_t> getDoneChunks() const;
+	bool addAnswer(uint64_t taskIndex, bool isOpen);
+	std::vector<uint64_t> getAnsweredHosts() const;
+	void getHostAnswers(uint64_t hostIndex, PortSet& openPorts, PortSet& closedPorts) const;
+	void getAnswers(std::vector<uint64_t>& openTasks, std::vector<uint64_t>& closedTasks) const;
+	uint64_t restore(const std::vector<uint64_t>& doneChunks, const std::vector<uint64_t>& openTasks, const std::vector<uint64_t>& closedTasks);
+private:
+	// port indexes rather than numbers, a scan never has more than 65536 ports
+	struct HostAnswers
+	{
+		PortSet openPorts;
+		PortSet closedPorts;
+	};
+	struct alignas(64) AnswerStripe
+	{
+		mutable std::mutex stripeLock;
+		std::unordered_map<uint64_t, HostAnswers> hostAnswers;
+	};
+	struct SentChunk
+	{
+		uint64_t chunkIndex;
+		std::chrono::steady_clock::time_point sentAt;
+	};
+private:
+	size_t portCount;
+	uint64_t chunkCount;
+	// one bit per chunk, set once every task in it has an answer or has timed out
+	std::vector<std::atomic<uint64_t>> doneChunks;
+	std::atomic<uint64_t> doneCount{ 0 };
+	std::array<AnswerStripe, TASK_RESULT_STRIPES> answerStripes;
+	// SYN chunks wait here from their last send until replies have had time to land, oldest first
+	std::mutex sentLock;
+	std::deque<SentChunk> sentChunks;
+};
+
+// one connect worker's chunks that still have probes out, a chunk is done once
+// it has been walked to the end and its last probe is back
+class ChunkTracker
+{
+public:
+	ChunkTracker(TaskResults& taskResults);
+public:
+	void openChunk(uint64_t chunkIndex);
+	void addProbe(uint64_t taskIndex, uint64_t chunkIndex);
+	void finishProbe(uint64_t taskIndex);
+	void closeChunk(uint64_t chunkIndex);
+private:
+	void releaseChunk(uint64_t chunkIndex);
+private:
+	TaskResults& taskResults;
+	// probes still out per chunk, plus one while the chunk is still being walked
+	std::unordered_map<uint64_t, uint32_t> pendingProbes;
+	std::unordered_map<uint64_t, uint64_t> probeChunks;
+};
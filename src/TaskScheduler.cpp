@@ -0,0 +1,229 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// TaskScheduler:
+// Splits the (host, port) space into chunks and balances them across workers with work stealing.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <mutex>
+
+/// <summary>
+/// Build the task space and deal it out to the workers.
+/// Positions run port by port in the order the ports were given, so ports sorted most likely first
+/// find open ports early, and within a port over a random permutation of the hosts so every chunk
+/// is spread across the whole target range.
+/// </summary>
+/// <param name="hostCount">number of hosts to scan</param>
+/// <param name="portCount">number of ports per host, probed in index order</param>
+/// <param name="workerCount">threads that will call nextTask</param>
+/// <param name="permutationSeed">seed for the host order, the same seed gives the same order</param>
+/// <param name="chunkSize">positions per chunk, 0 to size them for the workers, a resume passes the checkpoint's</param>
+TaskScheduler::TaskScheduler(size_t hostCount, size_t portCount, int workerCount, uint64_t permutationSeed, uint64_t chunkSize)
+    : workerQueues(std::max(workerCount, 1)), hostOrder(hostCount, permutationSeed)
+{
+    this->hostCount = hostCount;
+    this->portCount = portCount;
+    this->taskCount = hostCount * portCount;
+
+    // each port's cycle runs a little past the host count, the spare positions are skipped by the cursors
+    uint64_t cycleLength = this->taskCount > 0 ? this->hostOrder.getCycleLength() * portCount : 0;
+    size_t workers = this->workerQueues.size();
+    if (chunkSize == 0)
+    {
+        chunkSize = std::clamp((uint64_t)(cycleLength / (workers * TASK_CHUNKS_PER_WORKER)), (uint64_t)TASK_CHUNK_MIN, (uint64_t)TASK_CHUNK_MAX);
+    }
+    this->chunkSize = chunkSize;
+    this->chunkCount = (cycleLength + chunkSize - 1) / chunkSize;
+
+    // dealt round robin so the workers move through the order together and the likeliest ports all go first
+    for (uint64_t chunk = 0; chunk < this->chunkCount; chunk++)
+    {
+        uint64_t positionBegin = chunk * chunkSize;
+        uint64_t positionEnd = std::min(positionBegin + chunkSize, cycleLength);
+        this->workerQueues[chunk % workers].queuedTasks.push_back({ positionBegin, positionEnd, chunk });
+    }
+}
+
+/// <summary>
+/// Get the next chunk for a worker, its own queue first and then whatever it can steal.
+/// </summary>
+/// <param name="workerId">index of the calling worker</param>
+/// <param name="scanTask">filled with the next chunk</param>
+/// <returns>false once every queue is empty</returns>
+bool TaskScheduler::nextTask(int workerId, ScanTask& scanTask)
+{
+    WorkerQueue& ownQueue = this->workerQueues[workerId];
+    {
+        std::lock_guard<std::mutex> queueGuard(ownQueue.queueLock);
+        if (!ownQueue.queuedTasks.empty())
+        {
+            scanTask = ownQueue.queuedTasks.front();
+            ownQueue.queuedTasks.pop_front();
+            return true;
+        }
+    }
+    return this->stealTask(workerId, scanTask);
+}
+
+/// <summary>
+/// Take a chunk from the back of the busiest other queue, the work its owner would reach last.
+/// Slow or filtered hosts hold their own worker back, so the rest of its queue drains elsewhere.
+/// </summary>
+bool TaskScheduler::stealTask(int workerId, ScanTask& scanTask)
+{
+    while (true)
+    {
+        int victimId = -1;
+        size_t victimSize = 0;
+        for (size_t i = 1; i < this->workerQueues.size(); i++)
+        {
+            int candidateId = (int)((workerId + i) % this->workerQueues.size());
+            WorkerQueue& candidateQueue = this->workerQueues[candidateId];
+            std::lock_guard<std::mutex> queueGuard(candidateQueue.queueLock);
+            if (candidateQueue.queuedTasks.size() > victimSize)
+            {
+                victimSize = candidateQueue.queuedTasks.size();
+                victimId = candidateId;
+            }
+        }
+        if (victimId < 0)
+        {
+            return false;
+        }
+        WorkerQueue& victimQueue = this->workerQueues[victimId];
+        std::lock_guard<std::mutex> queueGuard(victimQueue.queueLock);
+        // the victim may have drained while we looked, just pick again
+        if (!victimQueue.queuedTasks.empty())
+        {
+            scanTask = victimQueue.queuedTasks.back();
+            victimQueue.queuedTasks.pop_back();
+            return true;
+        }
+    }
+}
+
+/// <summary>
+/// Cursor yielding the task indexes a chunk covers, in scan order.
+/// </summary>
+TaskCursor TaskScheduler::getCursor(const ScanTask& scanTask) const
+{
+    return TaskCursor(this->hostOrder, this->portCount, scanTask);
+}
+
+size_t TaskScheduler::getHostIndex(size_t taskIndex)
+{
+    return taskIndex / this->portCount;
+}
+
+size_t TaskScheduler::getPortIndex(size_t taskIndex)
+{
+    return taskIndex % this->portCount;
+}
+
+size_t TaskScheduler::getTaskCount()
+{
+    return this->taskCount;
+}
+
+int TaskScheduler::getWorkerCount()
+{
+    return (int)this->workerQueues.size();
+}
+
+uint64_t TaskScheduler::getChunkSize() const
+{
+    return this->chunkSize;
+}
+
+uint64_t TaskScheduler::getChunkCount() const
+{
+    return this->chunkCount;
+}
+
+/// <summary>
+/// Chunk holding a host's task on a port, given where the host sits in the permutation.
+/// </summary>
+/// <param name="hostPosition">the host's cycle position, from findHostPositions</param>
+uint64_t TaskScheduler::getChunkIndex(uint64_t hostPosition, size_t portIndex) const
+{
+    return (portIndex * this->hostOrder.getCycleLength() + hostPosition) / this->chunkSize;
+}
+
+/// <summary>
+/// Tasks in that many whole chunks on average. The spare cycle positions are spread evenly through
+/// the order, so this is close enough to count restored work towards progress without walking it.
+/// </summary>
+uint64_t TaskScheduler::estimateTasks(uint64_t chunkCount) const
+{
+    if (this->taskCount == 0)
+    {
+        return 0;
+    }
+    double chunkTasks = (double)this->chunkSize * this->hostCount / this->hostOrder.getCycleLength();
+    return std::min((uint64_t)(chunkCount * chunkTasks), (uint64_t)this->taskCount);
+}
+
+/// <summary>
+/// Where each of the given hosts sits in the permutation, one walk of the host cycle.
+/// Used to tell the ports an interrupted sweep reached from the ones it didn't.
+/// </summary>
+std::unordered_map<uint64_t, uint64_t> TaskScheduler::findHostPositions(const std::vector<uint64_t>& hostIndexes) const
+{
+    return this->hostOrder.findPositions(hostIndexes);
+}
+
+/// <summary>
+/// Start a chunk part way through a port's run of hosts, chunks can span the end of one port and the start of the next.
+/// </summary>
+TaskCursor::TaskCursor(const CyclicPermutation& hostOrder, size_t portCount, const ScanTask& scanTask)
+    : hostOrder(hostOrder), portCount(portCount)
+{
+    uint64_t cycleLength = hostOrder.getCycleLength();
+    uint64_t cycleOffset = scanTask.positionBegin % cycleLength;
+    uint64_t runLength = std::min(scanTask.positionEnd - scanTask.positionBegin, cycleLength - cycleOffset);
+    this->portIndex = scanTask.positionBegin / cycleLength;
+    this->hostCursor = hostOrder.getCursor(cycleOffset, cycleOffset + runLength);
+    this->positionsLeft = scanTask.positionEnd - scanTask.positionBegin - runLength;
+}
+
+/// <summary>
+/// Step to the next task in the chunk, moving on to the next port once this one's hosts run out.
+/// </summary>
+/// <param name="taskIndex">set to the task to probe</param>
+/// <returns>false once the chunk is done</returns>
+bool TaskCursor::next(uint64_t& taskIndex)
+{
+    uint64_t hostIndex = 0;
+    while (!this->hostCursor.next(hostIndex))
+    {
+        if (this->positionsLeft == 0)
+        {
+            return false;
+        }
+        uint64_t runLength = std::min(this->positionsLeft, this->hostOrder.getCycleLength());
+        this->portIndex++;
+        this->hostCursor = this->hostOrder.getCursor(0, runLength);
+        this->positionsLeft -= runLength;
+    }
+    taskIndex = hostIndex * this->portCount + this->portIndex;
+    return true;
+}
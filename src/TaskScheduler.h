@@ -0,0 +1,97 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// TaskScheduler:
+// Splits the (host, port) space into chunks and balances them across workers with work stealing. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include "CyclicPermutation.h"
+
+// bounds on tasks per chunk, small enough to balance well but large enough that queue locks stay cold
+constexpr size_t TASK_CHUNK_MIN = 16;
+constexpr size_t TASK_CHUNK_MAX = 1024;
+// chunks each worker should start with, more chunks means finer balancing
+constexpr size_t TASK_CHUNKS_PER_WORKER = 64;
+
+// half open range of positions in the task order, each position maps to a task index
+// and task t probes host (t / portCount) on port (t % portCount)
+struct ScanTask
+{
+	uint64_t positionBegin = 0;
+	uint64_t positionEnd = 0;
+	// which chunk of the task order this is, finished work is tracked a chunk at a time
+	uint64_t chunkIndex = 0;
+};
+
+// walks a chunk's positions a port at a time, ports in the order given and hosts in permutation order
+class TaskCursor
+{
+public:
+	TaskCursor(const CyclicPermutation& hostOrder, size_t portCount, const ScanTask& scanTask);
+public:
+	bool next(uint64_t& taskIndex);
+private:
+	const CyclicPermutation& hostOrder;
+	CyclicPermutation::Cursor hostCursor;
+	size_t portCount;
+	uint64_t portIndex;
+	// positions in the chunk past the current port's run of hosts
+	uint64_t positionsLeft;
+};
+
+class TaskScheduler
+{
+public:
+	TaskScheduler(size_t hostCount, size_t portCount, int workerCount, uint64_t permutationSeed, uint64_t chunkSize = 0);
+public:
+	bool nextTask(int workerId, ScanTask& scanTask);
+	TaskCursor getCursor(const ScanTask& scanTask) const;
+	size_t getHostIndex(size_t taskIndex);
+	size_t getPortIndex(size_t taskIndex);
+	size_t getTaskCount();
+	int getWorkerCount();
+	uint64_t getChunkSize() const;
+	uint64_t getChunkCount() const;
+	uint64_t getChunkIndex(uint64_t hostPosition, size_t portIndex) const;
+	uint64_t estimateTasks(uint64_t chunkCount) const;
+	std::unordered_map<uint64_t, uint64_t> findHostPositions(const std::vector<uint64_t>& hostIndexes) const;
+private:
+	bool stealTask(int workerId, ScanTask& scanTask);
+private:
+	struct alignas(64) WorkerQueue
+	{
+		std::mutex queueLock;
+		std::deque<ScanTask> queuedTasks;
+	};
+	std::vector<WorkerQueue> workerQueues;
+	size_t hostCount;
+	size_t portCount;
+	size_t taskCount;
+	uint64_t chunkSize;
+	uint64_t chunkCount;
+	// every port is probed across all hosts before the next one starts, the hosts in a seeded
+	// random order so no host or subnet sees a burst
+	CyclicPermutation hostOrder;
+};
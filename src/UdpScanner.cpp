@@ -0,0 +1,592 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// UdpScanner:
+// UDP port scanning over one socket, payloads go out in batches and a receiver thread sorts answers from port unreachables.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "UdpScanner.h"
+#include "SignatureDatabase.h"
+#include <stdexcept>
+#include <queue>
+#include <deque>
+#include <algorithm>
+#include <string.h>
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <sys/uio.h>
+#endif
+
+#ifndef _WIN32
+constexpr SOCKET INVALID_SOCKET = -1;
+#endif
+#ifdef __linux__
+// room for the extended error and the offender's address that ride along with each port unreachable
+constexpr size_t UDP_CONTROL_SIZE = 128;
+#endif
+constexpr uint8_t ICMP_DEST_UNREACH = 3;
+constexpr uint8_t ICMP_PORT_UNREACH = 3;
+
+class NetException : public std::runtime_error {
+public:
+    NetException(const std::string& message)
+        : std::runtime_error(message) {}
+};
+
+static void closeUdpSocket(SOCKET udpSocket)
+{
+#ifdef _WIN32
+    closesocket(udpSocket);
+#else
+    close(udpSocket);
+#endif
+}
+
+static uint32_t steadyMicros32()
+{
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+UdpScanner::UdpScanner(int maxTries)
+{
+    this->maxTries = std::clamp(maxTries, 1, 255);
+    this->udpSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (this->udpSocket == INVALID_SOCKET)
+    {
+        throw NetException("Failed to open a UDP socket\n");
+    }
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(this->udpSocket, FIONBIO, &nonBlocking);
+#else
+    fcntl(this->udpSocket, F_SETFL, fcntl(this->udpSocket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+#ifdef __linux__
+    // port unreachables for our datagrams are queued on the socket with the address they were sent to,
+    // the only way to tell a closed port from a silent one without raw sockets
+    int recvErrors = 1;
+    setsockopt(this->udpSocket, IPPROTO_IP, IP_RECVERR, &recvErrors, sizeof(recvErrors));
+#endif
+    // big buffers ride out send bursts and answer bursts from large scans
+    int bufferSize = 4 * 1024 * 1024;
+    setsockopt(this->udpSocket, SOL_SOCKET, SO_RCVBUF, (const char*)&bufferSize, sizeof(bufferSize));
+    setsockopt(this->udpSocket, SOL_SOCKET, SO_SNDBUF, (const char*)&bufferSize, sizeof(bufferSize));
+    // bound up front so the receiver has a port to listen on before the first send
+    sockaddr_in localAddr{};
+    localAddr.sin_family = AF_INET;
+    localAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(this->udpSocket, (sockaddr*)&localAddr, sizeof(localAddr)) != 0)
+    {
+        closeUdpSocket(this->udpSocket);
+        throw NetException("Failed to bind a UDP socket\n");
+    }
+}
+
+UdpScanner::~UdpScanner()
+{
+    this->receiverEnabled = false;
+    if (this->receiverThread.joinable())
+    {
+        this->receiverThread.join();
+    }
+    closeUdpSocket(this->udpSocket);
+}
+
+// plain datagram sockets need no rights, only a network stack
+bool UdpScanner::isSupported()
+{
+    static const bool udpSupported = []() {
+        SOCKET testSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (testSocket == INVALID_SOCKET)
+        {
+            return false;
+        }
+        closeUdpSocket(testSocket);
+        return true;
+    }();
+    return udpSupported;
+}
+
+/// <summary>
+/// Send one datagram per task, each to its own host and port from the one socket.
+/// Linux hands the whole batch to the kernel in one sendmmsg, elsewhere it is a sendto each.
+/// A datagram the kernel refuses is left to time out and retry like a lost one.
+/// </summary>
+void UdpScanner::sendBatch(const std::vector<uint64_t>& batchTasks)
+{
+    size_t portCount = this->targetPorts->size();
+#ifdef __linux__
+    sockaddr_in batchAddrs[UDP_SEND_BATCH]{};
+    iovec batchData[UDP_SEND_BATCH]{};
+    mmsghdr batchMessages[UDP_SEND_BATCH]{};
+    int batchSize = (int)std::min(batchTasks.size(), (size_t)UDP_SEND_BATCH);
+    for (int batchIndex = 0; batchIndex < batchSize; batchIndex++)
+    {
+        size_t hostIndex = batchTasks[batchIndex] / portCount;
+        size_t portIndex = batchTasks[batchIndex] % portCount;
+        batchAddrs[batchIndex].sin_family = AF_INET;
+        batchAddrs[batchIndex].sin_addr.s_addr = htonl(this->targetSpace->getAddress(hostIndex));
+        batchAddrs[batchIndex].sin_port = htons((uint16_t)(*this->targetPorts)[portIndex]);
+        batchData[batchIndex].iov_base = (void*)this->portPayloads[portIndex].data();
+        batchData[batchIndex].iov_len = this->portPayloads[portIndex].size();
+        batchMessages[batchIndex].msg_hdr.msg_name = &batchAddrs[batchIndex];
+        batchMessages[batchIndex].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        batchMessages[batchIndex].msg_hdr.msg_iov = &batchData[batchIndex];
+        batchMessages[batchIndex].msg_hdr.msg_iovlen = 1;
+    }
+    int batchSent = 0;
+    while (batchSent < batchSize)
+    {
+        int sentCount = sendmmsg(this->udpSocket, batchMessages + batchSent, batchSize - batchSent, 0);
+        if (sentCount > 0)
+        {
+            batchSent += sentCount;
+        }
+        // a port unreachable can surface as an error on whichever call comes next, it is already queued for the receiver
+        else if (sentCount < 0 && errno == ECONNREFUSED)
+        {
+            continue;
+        }
+        // the rest of the batch failed or the buffer is full, skip the datagram that stopped it
+        else
+        {
+            batchSent++;
+        }
+    }
+#else
+    for (uint64_t taskIndex : batchTasks)
+    {
+        size_t hostIndex = taskIndex / portCount;
+        size_t portIndex = taskIndex % portCount;
+        sockaddr_in targetAddr{};
+        targetAddr.sin_family = AF_INET;
+        targetAddr.sin_addr.s_addr = htonl(this->targetSpace->getAddress(hostIndex));
+        targetAddr.sin_port = htons((uint16_t)(*this->targetPorts)[portIndex]);
+        sendto(this->udpSocket, this->portPayloads[portIndex].data(), (int)this->portPayloads[portIndex].size(), 0,
+            (sockaddr*)&targetAddr, sizeof(targetAddr));
+    }
+#endif
+}
+
+/// <summary>
+/// Match an answer or a port unreachable to the port it is for and record it the first time that port answers.
+/// Any try's answer counts, a slow service answering its first datagram after a retry is still open.
+/// </summary>
+/// <param name="sourceAddr">host order address the answer came from, or the unreachable was about</param>
+/// <param name="sourcePort">host order port, likewise</param>
+/// <param name="isOpen">true for an answer, false for a port unreachable</param>
+void UdpScanner::handleAnswer(uint32_t sourceAddr, uint16_t sourcePort, bool isOpen)
+{
+    size_t hostIndex;
+    int32_t portIndex = this->portIndexes[sourcePort];
+    if (portIndex < 0 || !this->targetSpace->findIndex(sourceAddr, hostIndex))
+    {
+        return;
+    }
+    uint64_t taskIndex = (uint64_t)hostIndex * this->targetPorts->size() + portIndex;
+    int64_t roundTrip = -1;
+    {
+        std::lock_guard<std::mutex> probeGuard(this->probeLock);
+        if (!this->answeredTasks.insert(taskIndex).second)
+        {
+            return;
+        }
+        this->udpAnswers.push_back({ taskIndex, isOpen });
+        auto probeEntry = this->probeEntries.find(taskIndex);
+        // no entry means the sender already gave up on this port and counted it as finished
+        if (probeEntry == this->probeEntries.end())
+        {
+            this->lateAnswers++;
+        }
+        else
+        {
+            if (probeEntry->second.probeState == Waiting)
+            {
+                // an answer that needed a retry means an earlier datagram was lost somewhere
+                if (probeEntry->second.probeAttempts > 1)
+                {
+                    this->scanPacer->onDrop();
+                }
+                else
+                {
+                    this->scanPacer->onResponse();
+                    // only a first try's answer is a clean sample, a retry's could be answering either send
+                    roundTrip = (int64_t)(uint32_t)(steadyMicros32() - probeEntry->second.sendTime);
+                }
+            }
+            this->probeEntries.erase(probeEntry);
+            this->answersPending++;
+        }
+    }
+    if (roundTrip >= 0)
+    {
+        this->rttEstimator->addSample(hostIndex, roundTrip);
+    }
+    this->onAnswer(taskIndex, isOpen);
+}
+
+/// <summary>
+/// Receiver loop, drains answers and queued port unreachables whenever the socket is ready until the sweep ends.
+/// Linux takes both in batches with recvmmsg, elsewhere answers come one recvfrom at a time and
+/// closed ports can't be told from filtered ones.
+/// </summary>
+void UdpScanner::receiveReplies()
+{
+#ifdef __linux__
+    sockaddr_in recvAddrs[UDP_RECV_BATCH];
+    uint8_t recvBuffers[UDP_RECV_BATCH][UDP_RECV_SIZE];
+    alignas(cmsghdr) uint8_t controlBuffers[UDP_RECV_BATCH][UDP_CONTROL_SIZE];
+    iovec recvData[UDP_RECV_BATCH];
+    mmsghdr recvMessages[UDP_RECV_BATCH];
+    // names and lengths are written back by every call, so they are set afresh before each one
+    auto resetMessages = [&](bool errorQueue) {
+        memset(recvMessages, 0, sizeof(recvMessages));
+        for (int recvIndex = 0; recvIndex < UDP_RECV_BATCH; recvIndex++)
+        {
+            recvData[recvIndex] = { recvBuffers[recvIndex], UDP_RECV_SIZE };
+            recvMessages[recvIndex].msg_hdr.msg_name = &recvAddrs[recvIndex];
+            recvMessages[recvIndex].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            recvMessages[recvIndex].msg_hdr.msg_iov = &recvData[recvIndex];
+            recvMessages[recvIndex].msg_hdr.msg_iovlen = 1;
+            if (errorQueue)
+            {
+                recvMessages[recvIndex].msg_hdr.msg_control = controlBuffers[recvIndex];
+                recvMessages[recvIndex].msg_hdr.msg_controllen = UDP_CONTROL_SIZE;
+            }
+        }
+    };
+#else
+    uint8_t recvBuffer[UDP_RECV_SIZE];
+#endif
+#ifdef _WIN32
+    WSAPOLLFD recvPoll{ this->udpSocket, POLLRDNORM, 0 };
+#else
+    pollfd recvPoll{ this->udpSocket, POLLIN, 0 };
+#endif
+    while (this->receiverEnabled)
+    {
+#ifdef _WIN32
+        int readyCount = WSAPoll(&recvPoll, 1, UDP_POLL_INTERVAL);
+#else
+        int readyCount = ::poll(&recvPoll, 1, UDP_POLL_INTERVAL);
+#endif
+        if (readyCount <= 0)
+        {
+            continue;
+        }
+#ifdef __linux__
+        // answers, truncated or empty ones included, each mark their port open
+        while (true)
+        {
+            resetMessages(false);
+            int recvCount = recvmmsg(this->udpSocket, recvMessages, UDP_RECV_BATCH, MSG_DONTWAIT, nullptr);
+            if (recvCount < 0 && errno == ECONNREFUSED)
+            {
+                continue;
+            }
+            if (recvCount <= 0)
+            {
+                break;
+            }
+            for (int recvIndex = 0; recvIndex < recvCount; recvIndex++)
+            {
+                this->handleAnswer(ntohl(recvAddrs[recvIndex].sin_addr.s_addr), ntohs(recvAddrs[recvIndex].sin_port), true);
+            }
+        }
+        // the error queue hands back the address each datagram was sent to alongside the ICMP error it drew
+        while (true)
+        {
+            resetMessages(true);
+            int recvCount = recvmmsg(this->udpSocket, recvMessages, UDP_RECV_BATCH, MSG_ERRQUEUE | MSG_DONTWAIT, nullptr);
+            if (recvCount <= 0)
+            {
+                break;
+            }
+            for (int recvIndex = 0; recvIndex < recvCount; recvIndex++)
+            {
+                msghdr& errorMessage = recvMessages[recvIndex].msg_hdr;
+                for (cmsghdr* controlMessage = CMSG_FIRSTHDR(&errorMessage); controlMessage != nullptr;
+                    controlMessage = CMSG_NXTHDR(&errorMessage, controlMessage))
+                {
+                    if (controlMessage->cmsg_level != IPPROTO_IP || controlMessage->cmsg_type != IP_RECVERR)
+                    {
+                        continue;
+                    }
+                    sock_extended_err extendedError;
+                    memcpy(&extendedError, CMSG_DATA(controlMessage), sizeof(extendedError));
+                    // other unreachables mean something in the way dropped it, the same as hearing nothing
+                    if (extendedError.ee_origin == SO_EE_ORIGIN_ICMP && extendedError.ee_type == ICMP_DEST_UNREACH
+                        && extendedError.ee_code == ICMP_PORT_UNREACH)
+                    {
+                        this->handleAnswer(ntohl(recvAddrs[recvIndex].sin_addr.s_addr), ntohs(recvAddrs[recvIndex].sin_port), false);
+                    }
+                }
+            }
+        }
+#else
+        while (true)
+        {
+            sockaddr_in sourceAddr{};
+            socklen_t sourceLen = sizeof(sourceAddr);
+            int recvLength = (int)recvfrom(this->udpSocket, (char*)recvBuffer, sizeof(recvBuffer), 0,
+                (sockaddr*)&sourceAddr, &sourceLen);
+            // windows reports a port unreachable as a reset with no way to tie it to a port, it is read past
+            if (recvLength < 0)
+            {
+                break;
+            }
+            this->handleAnswer(ntohl(sourceAddr.sin_addr.s_addr), ntohs(sourceAddr.sin_port), true);
+        }
+#endif
+    }
+}
+
+/// <summary>
+/// Probe every (host, port) pair over UDP, retrying silent ports up to maxTries with a timeout that doubles each try,
+/// and block until all have finished. Each port gets its protocol's payload from the signature database, or an empty datagram.
+/// Every host is sent a port before the next port starts, hosts in permutation order, so no host sees a burst.
+/// </summary>
+/// <param name="targetSpace">the targets, 0.0.0.0 is skipped as unreachable</param>
+/// <param name="targetPorts">ports in the order they are to be probed, task t is host t / portCount on port t % portCount</param>
+/// <param name="hostOrder">permutation over the targets giving the order hosts are sent each port in</param>
+/// <param name="scanPacer">shared pacer, one window slot is held per datagram waiting on an answer</param>
+/// <param name="rttEstimator">gives each host's first timeout and learns from the answers</param>
+/// <param name="keepRunning">polled between batches, returning false ends the sweep early</param>
+/// <param name="onProgress">given the number of ports that finished since the last call</param>
+/// <param name="onAnswer">called from the receiver thread as each port first answers</param>
+/// <returns>the ports that answered and how far the sweep got, everything else sent went silent</returns>
+UdpSweepResult UdpScanner::sweep(const TargetSpace& targetSpace, const std::vector<int>& targetPorts,
+    const CyclicPermutation& hostOrder, Pacer& scanPacer, RttEstimator& rttEstimator,
+    std::function<bool()> keepRunning, std::function<void(int portsFinished)> onProgress, UdpAnswerHandler onAnswer)
+{
+    this->targetSpace = &targetSpace;
+    this->targetPorts = &targetPorts;
+    this->scanPacer = &scanPacer;
+    this->rttEstimator = &rttEstimator;
+    this->onAnswer = std::move(onAnswer);
+    size_t portCount = targetPorts.size();
+    this->portPayloads.clear();
+    this->portIndexes.assign(UINT16_MAX + 1, -1);
+    for (size_t portIndex = 0; portIndex < portCount; portIndex++)
+    {
+        const ServiceProbe* udpProbe = getSignatureDatabase().findUdpProbe((uint16_t)targetPorts[portIndex]);
+        this->portPayloads.push_back(udpProbe != nullptr ? std::string_view(udpProbe->probeData) : std::string_view());
+        this->portIndexes[(uint16_t)targetPorts[portIndex]] = (int32_t)portIndex;
+    }
+    this->probeEntries.clear();
+    this->answeredTasks.clear();
+    this->udpAnswers.clear();
+    this->lateAnswers = 0;
+    this->answersPending = 0;
+    uint64_t exhaustedCount = 0;
+
+    this->receiverEnabled = true;
+    this->receiverThread = std::thread(&UdpScanner::receiveReplies, this);
+
+    // timeouts differ per host and per try, so the soonest deadline is kept on top
+    std::priority_queue<TimeoutEntry, std::vector<TimeoutEntry>, std::greater<TimeoutEntry>> timeoutQueue;
+    std::deque<uint64_t> retryQueue;
+    std::vector<uint64_t> batchTasks;
+    std::vector<uint8_t> batchAttempts;
+    batchTasks.reserve(UDP_SEND_BATCH);
+    batchAttempts.reserve(UDP_SEND_BATCH);
+    size_t nextPort = 0;
+    uint64_t nextHost = 0;
+    CyclicPermutation::Cursor hostCursor = hostOrder.getCursor(0, hostOrder.getCycleLength());
+    bool tasksLeft = portCount > 0 && hostCursor.next(nextHost);
+    // steps to the next host, and on to the next port once every host has had this one
+    auto advanceTask = [&]() {
+        if (hostCursor.next(nextHost))
+        {
+            return;
+        }
+        hostCursor = hostOrder.getCursor(0, hostOrder.getCycleLength());
+        tasksLeft = ++nextPort < portCount && hostCursor.next(nextHost);
+    };
+    int skippedPorts = 0;
+
+    while (keepRunning())
+    {
+        int portsFinished = skippedPorts + this->answersPending.exchange(0);
+        skippedPorts = 0;
+
+        // hand back timed out datagrams and queue their retries
+        auto timeNow = std::chrono::steady_clock::now();
+        while (!timeoutQueue.empty() && timeoutQueue.top().deadline <= timeNow)
+        {
+            uint64_t taskIndex = timeoutQueue.top().taskIndex;
+            timeoutQueue.pop();
+            std::lock_guard<std::mutex> probeGuard(this->probeLock);
+            auto probeEntry = this->probeEntries.find(taskIndex);
+            // gone when an answer claimed it, in which case it was counted as it came in
+            if (probeEntry == this->probeEntries.end() || probeEntry->second.probeState != Waiting)
+            {
+                continue;
+            }
+            // most silent ports are open or filtered rather than dropped, so silence opens the window rather than cutting it
+            scanPacer.onSilence();
+            if (probeEntry->second.probeAttempts < this->maxTries)
+            {
+                probeEntry->second.probeState = Idle;
+                retryQueue.push_back(taskIndex);
+            }
+            else
+            {
+                this->probeEntries.erase(probeEntry);
+                exhaustedCount++;
+                portsFinished++;
+            }
+        }
+
+        batchTasks.clear();
+        batchAttempts.clear();
+        while (batchTasks.size() < UDP_SEND_BATCH)
+        {
+            bool isRetry = !retryQueue.empty();
+            if (!isRetry && !tasksLeft)
+            {
+                break;
+            }
+            uint64_t taskIndex = isRetry ? retryQueue.front() : nextHost * portCount + nextPort;
+            if (!isRetry && targetSpace.getAddress(nextHost) == 0)
+            {
+                advanceTask();
+                skippedPorts++;
+                continue;
+            }
+            if (!scanPacer.tryAcquire())
+            {
+                break;
+            }
+            if (isRetry)
+            {
+                retryQueue.pop_front();
+            }
+            else
+            {
+                advanceTask();
+            }
+            // waiting has to be visible before the answer can possibly arrive,
+            // and a late answer may have claimed a port sitting in the retry queue
+            {
+                std::lock_guard<std::mutex> probeGuard(this->probeLock);
+                if (!isRetry && this->answeredTasks.contains(taskIndex))
+                {
+                    // a stray datagram got in before this port was ever sent, it was taken as a late answer
+                    this->lateAnswers--;
+                    skippedPorts++;
+                    scanPacer.release();
+                    continue;
+                }
+                auto probeEntry = isRetry ? this->probeEntries.find(taskIndex) : this->probeEntries.try_emplace(taskIndex).first;
+                if (probeEntry == this->probeEntries.end())
+                {
+                    scanPacer.release();
+                    continue;
+                }
+                probeEntry->second.probeState = Waiting;
+                probeEntry->second.probeAttempts++;
+                probeEntry->second.sendTime = steadyMicros32();
+                batchAttempts.push_back(probeEntry->second.probeAttempts);
+            }
+            batchTasks.push_back(taskIndex);
+        }
+        if (!batchTasks.empty())
+        {
+            this->sendBatch(batchTasks);
+            auto sentAt = std::chrono::steady_clock::now();
+            for (size_t batchIndex = 0; batchIndex < batchTasks.size(); batchIndex++)
+            {
+                uint64_t taskIndex = batchTasks[batchIndex];
+                // the host's measured timeout for a first try, doubled for every try since
+                int sendTimeout = rttEstimator.getTimeout(taskIndex / portCount);
+                for (int sendAttempt = 1; sendAttempt < batchAttempts[batchIndex] && sendTimeout < UDP_MAX_TIMEOUT; sendAttempt++)
+                {
+                    sendTimeout *= 2;
+                }
+                sendTimeout = std::min(sendTimeout, UDP_MAX_TIMEOUT);
+                timeoutQueue.push({ taskIndex, sentAt + std::chrono::milliseconds(sendTimeout) });
+            }
+        }
+
+        if (portsFinished > 0)
+        {
+            onProgress(portsFinished);
+        }
+        if (timeoutQueue.empty() && retryQueue.empty() && !tasksLeft)
+        {
+            break;
+        }
+
+        // sleep until the next deadline or pacer token, whichever is first
+        int waitTime = scanPacer.getWaitTime();
+        if (!timeoutQueue.empty())
+        {
+            auto untilDeadline = std::chrono::duration_cast<std::chrono::milliseconds>(
+                timeoutQueue.top().deadline - std::chrono::steady_clock::now());
+            waitTime = std::clamp((int)untilDeadline.count() + 1, 0, waitTime);
+        }
+        if (waitTime > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min(waitTime, UDP_POLL_INTERVAL)));
+        }
+    }
+
+    this->receiverEnabled = false;
+    this->receiverThread.join();
+    int lateAnswers = this->answersPending.exchange(0);
+    if (lateAnswers > 0)
+    {
+        onProgress(lateAnswers);
+    }
+
+    UdpSweepResult sweepResult;
+    sweepResult.udpAnswers = std::move(this->udpAnswers);
+    // ports still in flight when the sweep was stopped are left unsent, nothing was learned from them
+    for (const auto& [taskIndex, probeEntry] : this->probeEntries)
+    {
+        sweepResult.unfinishedTasks.insert(taskIndex);
+    }
+    sweepResult.allSent = !tasksLeft;
+    sweepResult.nextPort = nextPort;
+    sweepResult.nextHost = nextHost;
+    sweepResult.silentCount = exhaustedCount - this->lateAnswers;
+    this->udpAnswers.clear();
+    this->probeEntries.clear();
+    this->answeredTasks.clear();
+    this->targetSpace = nullptr;
+    this->targetPorts = nullptr;
+    this->scanPacer = nullptr;
+    this->rttEstimator = nullptr;
+    this->onAnswer = nullptr;
+    return sweepResult;
+}
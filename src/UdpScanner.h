@@ -0,0 +1,136 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// UdpScanner:
+// UDP port scanning over one socket, payloads go out in batches and a receiver thread sorts answers from port unreachables. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include "Pacer.h"
+#include "RttEstimator.h"
+#include "CyclicPermutation.h"
+#include "TargetSpace.h"
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#ifdef _WIN32
+#include <WinSock2.h>
+#pragma comment(lib, "ws2_32")
+#else
+typedef int SOCKET;
+#endif
+
+// datagrams handed to the kernel per sendmmsg call, and the most taken back per recvmmsg
+constexpr int UDP_SEND_BATCH = 64;
+constexpr int UDP_RECV_BATCH = 64;
+// sends per port before its silence is reported as open|filtered
+constexpr int UDP_MAX_TRIES = 3;
+// each retry waits twice as long as the last, up to this many ms
+constexpr int UDP_MAX_TIMEOUT = 4000;
+// bytes kept of each answer, only that one came matters
+constexpr int UDP_RECV_SIZE = 512;
+// upper bound in ms for a single wait in either loop
+constexpr int UDP_POLL_INTERVAL = 50;
+
+// a port that answered, isOpen is false for a port unreachable
+struct UdpAnswer
+{
+	uint64_t taskIndex = 0;
+	bool isOpen = false;
+};
+
+// what a sweep found, ports that neither answered nor were left unfinished and were sent before
+// the frontier went silent through every try
+struct UdpSweepResult
+{
+	std::vector<UdpAnswer> udpAnswers{};
+	// in flight or waiting on a retry when the sweep was stopped, nothing was learned from them
+	std::unordered_set<uint64_t> unfinishedTasks{};
+	// the first port and host left unsent when the sweep was stopped, unused once every task went out
+	bool allSent = false;
+	size_t nextPort = 0;
+	uint64_t nextHost = 0;
+	uint64_t silentCount = 0;
+};
+
+// called from the receiver thread as each port first answers, isOpen is false for a port unreachable
+using UdpAnswerHandler = std::function<void(uint64_t taskIndex, bool isOpen)>;
+
+class UdpScanner
+{
+public:
+	UdpScanner(int maxTries);
+	~UdpScanner();
+	UdpScanner(const UdpScanner&) = delete;
+	UdpScanner& operator=(const UdpScanner&) = delete;
+public:
+	static bool isSupported();
+	UdpSweepResult sweep(const TargetSpace& targetSpace, const std::vector<int>& targetPorts,
+		const CyclicPermutation& hostOrder, Pacer& scanPacer, RttEstimator& rttEstimator,
+		std::function<bool()> keepRunning, std::function<void(int portsFinished)> onProgress, UdpAnswerHandler onAnswer);
+private:
+	// Idle ports are queued for a retry, ports leave the table once they answer or run out of tries
+	enum ProbeState : uint8_t { Idle, Waiting };
+	struct ProbeEntry
+	{
+		ProbeState probeState = Waiting;
+		uint8_t probeAttempts = 0;
+		// low 32 bits of the steady clock in microseconds at the latest send, the difference survives the wrap
+		uint32_t sendTime = 0;
+	};
+	struct TimeoutEntry
+	{
+		uint64_t taskIndex;
+		std::chrono::steady_clock::time_point deadline;
+		bool operator>(const TimeoutEntry& timeoutEntry) const { return this->deadline > timeoutEntry.deadline; }
+	};
+	void sendBatch(const std::vector<uint64_t>& batchTasks);
+	void receiveReplies();
+	void handleAnswer(uint32_t sourceAddr, uint16_t sourcePort, bool isOpen);
+private:
+	SOCKET udpSocket{};
+	int maxTries;
+	// only valid for the length of a sweep
+	const TargetSpace* targetSpace = nullptr;
+	const std::vector<int>* targetPorts = nullptr;
+	Pacer* scanPacer = nullptr;
+	RttEstimator* rttEstimator = nullptr;
+	UdpAnswerHandler onAnswer{};
+	// payload for each entry in targetPorts, empty for ports without one
+	std::vector<std::string_view> portPayloads;
+	// answers carry a port, this turns it back into an index into targetPorts
+	std::vector<int32_t> portIndexes;
+	// only ports with a datagram in flight or a retry queued have an entry, so memory follows the send window
+	std::mutex probeLock;
+	std::unordered_map<uint64_t, ProbeEntry> probeEntries;
+	std::unordered_set<uint64_t> answeredTasks;
+	std::vector<UdpAnswer> udpAnswers;
+	// answers to ports the sender had already given up on and counted as finished
+	uint64_t lateAnswers = 0;
+	std::atomic<int> answersPending{ 0 };
+	std::thread receiverThread;
+	std::atomic<bool> receiverEnabled{ false };
+};
@@ -0,0 +1,742 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// UringEngine:
+// io_uring submission/completion prober for TCP connects and ICMP echoes (Linux only).
+// Talks to the kernel through the raw syscalls so no liburing is needed.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "UringEngine.h"
+#include <stdexcept>
+#include <format>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <atomic>
+#endif
+
+class NetException : public std::runtime_error {
+public:
+    NetException(const std::string& message)
+        : std::runtime_error(message) {}
+};
+
+#ifdef __linux__
+
+// echo sequence numbers are slot indexes so an engine can't hold more than this
+constexpr int URING_MAX_SLOTS = 65535;
+// most SQEs a single probe needs, socket + connect + linked timeout
+constexpr unsigned URING_PROBE_SQES = 3;
+
+// user_data layout: kind (8 bits) | slot generation (24 bits) | slot or recv index (32 bits)
+constexpr uint64_t KIND_CONNECT = 1;
+constexpr uint64_t KIND_TIMEOUT = 2;
+constexpr uint64_t KIND_CLOSE = 3;
+constexpr uint64_t KIND_SOCKET = 4;
+constexpr uint64_t KIND_SEND = 5;
+constexpr uint64_t KIND_RECV = 6;
+
+static uint64_t packUserData(uint64_t kind, uint32_t generation, uint32_t index)
+{
+    return (kind << 56) | ((uint64_t)(generation & 0xFFFFFF) << 32) | index;
+}
+
+static int uringSetup(unsigned entries, io_uring_params* params)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uringEnter(int ringHandle, unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize)
+{
+    return (int)syscall(__NR_io_uring_enter, ringHandle, toSubmit, minComplete, flags, arg, argSize);
+}
+
+static int uringRegister(int ringHandle, unsigned opcode, void* arg, unsigned argCount)
+{
+    return (int)syscall(__NR_io_uring_register, ringHandle, opcode, arg, argCount);
+}
+
+struct UringSupport
+{
+    bool isAvailable = false;
+    bool hasSocketOp = false;
+};
+
+/// <summary>
+/// Check once whether the running kernel has every op the engine needs.
+/// io_uring can be missing entirely, disabled by sysctl or blocked by seccomp.
+/// </summary>
+static UringSupport getSupport()
+{
+    static UringSupport uringSupport = []() {
+        UringSupport support;
+        io_uring_params params{};
+        int probeRing = uringSetup(8, &params);
+        if (probeRing < 0)
+        {
+            return support;
+        }
+        if ((params.features & IORING_FEAT_EXT_ARG) && (params.features & IORING_FEAT_NODROP))
+        {
+            std::vector<uint8_t> probeBuffer(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+            io_uring_probe* opProbe = (io_uring_probe*)probeBuffer.data();
+            if (uringRegister(probeRing, IORING_REGISTER_PROBE, opProbe, 256) == 0)
+            {
+                auto hasOp = [opProbe](int opcode) {
+                    return opcode <= opProbe->last_op && (opProbe->ops[opcode].flags & IO_URING_OP_SUPPORTED);
+                };
+                support.isAvailable = hasOp(IORING_OP_CONNECT) && hasOp(IORING_OP_LINK_TIMEOUT) &&
+                    hasOp(IORING_OP_SENDMSG) && hasOp(IORING_OP_RECVMSG);
+                support.hasSocketOp = hasOp(IORING_OP_SOCKET) && hasOp(IORING_OP_CLOSE);
+            }
+        }
+        close(probeRing);
+        return support;
+    }();
+    return uringSupport;
+}
+
+/// <summary>
+/// Standard internet checksum over an ICMP packet.
+/// </summary>
+static uint16_t ICMPChecksum(const uint8_t* packet, size_t packetLen)
+{
+    uint32_t checkSum = 0;
+    for (size_t i = 0; i + 1 < packetLen; i += 2)
+    {
+        checkSum += (uint32_t)((packet[i] << 8) | packet[i + 1]);
+    }
+    if (packetLen % 2)
+    {
+        checkSum += (uint32_t)(packet[packetLen - 1] << 8);
+    }
+    while (checkSum >> 16)
+    {
+        checkSum = (checkSum & 0xFFFF) + (checkSum >> 16);
+    }
+    return (uint16_t)~checkSum;
+}
+
+bool UringEngine::isSupported()
+{
+    return getSupport().isAvailable;
+}
+
+UringEngine::UringEngine(int maxOutstanding, int probeTimeout)
+{
+    UringSupport support = getSupport();
+    if (!support.isAvailable)
+    {
+        throw NetException("io_uring is not supported by this kernel\n");
+    }
+    maxOutstanding = std::clamp(maxOutstanding, 1, URING_MAX_SLOTS);
+    this->probeTimeout = probeTimeout;
+
+    // size the completion ring so every probe can have all of its CQEs outstanding at once
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    params.cq_entries = (unsigned)maxOutstanding * (URING_PROBE_SQES + 1) + URING_RECV_DEPTH;
+    this->ringHandle = uringSetup((unsigned)maxOutstanding * URING_PROBE_SQES + URING_RECV_DEPTH, &params);
+    if (this->ringHandle < 0)
+    {
+        throw NetException(std::format("Failed to create io_uring with error: {}\n", errno));
+    }
+
+    this->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    this->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap)
+    {
+        this->sqRingSize = std::max(this->sqRingSize, this->cqRingSize);
+        this->cqRingSize = this->sqRingSize;
+    }
+    this->sqRing = mmap(nullptr, this->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        this->ringHandle, IORING_OFF_SQ_RING);
+    this->cqRing = singleMap ? this->sqRing : mmap(nullptr, this->cqRingSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, this->ringHandle, IORING_OFF_CQ_RING);
+    this->sqEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqeMap = mmap(nullptr, this->sqEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        this->ringHandle, IORING_OFF_SQES);
+    if (this->sqRing == MAP_FAILED || this->cqRing == MAP_FAILED || sqeMap == MAP_FAILED)
+    {
+        int mapError = errno;
+        close(this->ringHandle);
+        throw NetException(std::format("Failed to map io_uring with error: {}\n", mapError));
+    }
+    this->sqEntries = (io_uring_sqe*)sqeMap;
+
+    uint8_t* sqBase = (uint8_t*)this->sqRing;
+    uint8_t* cqBase = (uint8_t*)this->cqRing;
+    this->sqHead = (unsigned*)(sqBase + params.sq_off.head);
+    this->sqTail = (unsigned*)(sqBase + params.sq_off.tail);
+    this->sqArray = (unsigned*)(sqBase + params.sq_off.array);
+    this->sqMask = *(unsigned*)(sqBase + params.sq_off.ring_mask);
+    this->sqCount = params.sq_entries;
+    this->cqHead = (unsigned*)(cqBase + params.cq_off.head);
+    this->cqTail = (unsigned*)(cqBase + params.cq_off.tail);
+    this->cqEntries = (io_uring_cqe*)(cqBase + params.cq_off.cqes);
+    this->cqMask = *(unsigned*)(cqBase + params.cq_off.ring_mask);
+    this->sqLocalTail = *this->sqTail;
+
+    this->uringSlots.resize(maxOutstanding);
+    this->freeSlots.reserve(maxOutstanding);
+    for (size_t i = maxOutstanding; i > 0; i--)
+    {
+        this->freeSlots.push_back((uint32_t)(i - 1));
+    }
+
+    // direct descriptors let the kernel create and close probe sockets itself, slot i owns file i
+    raiseDescriptorLimit();
+    if (support.hasSocketOp)
+    {
+        std::vector<int> sparseFiles(maxOutstanding, -1);
+        this->directSockets = uringRegister(this->ringHandle, IORING_REGISTER_FILES,
+            sparseFiles.data(), (unsigned)sparseFiles.size()) == 0;
+    }
+}
+
+UringEngine::~UringEngine()
+{
+    for (UringSlot& uringSlot : this->uringSlots)
+    {
+        if (uringSlot.probeSocket >= 0)
+        {
+            close(uringSlot.probeSocket);
+        }
+    }
+    if (this->echoSocket >= 0)
+    {
+        close(this->echoSocket);
+    }
+    munmap(this->sqEntries, this->sqEntriesSize);
+    if (this->cqRing != this->sqRing)
+    {
+        munmap(this->cqRing, this->cqRingSize);
+    }
+    munmap(this->sqRing, this->sqRingSize);
+    // tearing down the ring cancels anything still in flight
+    close(this->ringHandle);
+}
+
+/// <summary>
+/// Grab the next free SQE, flushing to the kernel first if fewer than requiredSpace are left.
+/// Linked chains must reserve their full length on the first call, links can't span a flush.
+/// </summary>
+io_uring_sqe* UringEngine::getSqe(unsigned requiredSpace)
+{
+    unsigned sqHeadNow = std::atomic_ref<unsigned>(*this->sqHead).load(std::memory_order_acquire);
+    if (this->sqCount - (this->sqLocalTail - sqHeadNow) < requiredSpace)
+    {
+        this->flushSubmissions(0, 0);
+    }
+    unsigned sqIndex = this->sqLocalTail & this->sqMask;
+    io_uring_sqe* sqe = &this->sqEntries[sqIndex];
+    memset(sqe, 0, sizeof(*sqe));
+    this->sqArray[sqIndex] = sqIndex;
+    this->sqLocalTail++;
+    this->toSubmit++;
+    return sqe;
+}
+
+/// <summary>
+/// Publish queued SQEs and optionally wait for completions, all in a single syscall.
+/// </summary>
+/// <param name="minComplete">completions to wait for, 0 to return straight away</param>
+/// <param name="waitTime">max time to wait in ms</param>
+void UringEngine::flushSubmissions(unsigned minComplete, int waitTime)
+{
+    std::atomic_ref<unsigned>(*this->sqTail).store(this->sqLocalTail, std::memory_order_release);
+
+    __kernel_timespec waitSpec{};
+    waitSpec.tv_sec = waitTime / 1000;
+    waitSpec.tv_nsec = (long long)(waitTime % 1000) * 1000000;
+    io_uring_getevents_arg waitArg{};
+    waitArg.ts = minComplete > 0 ? (uint64_t)&waitSpec : 0;
+
+    unsigned enterFlags = IORING_ENTER_EXT_ARG | (minComplete > 0 ? IORING_ENTER_GETEVENTS : 0);
+    int enterResult = uringEnter(this->ringHandle, this->toSubmit, minComplete, enterFlags, &waitArg, sizeof(waitArg));
+    if (enterResult >= 0)
+    {
+        this->toSubmit -= std::min((unsigned)enterResult, this->toSubmit);
+        return;
+    }
+    if (errno != EINTR && errno != ETIME && errno != EAGAIN && errno != EBUSY)
+    {
+        throw NetException(std::format("io_uring_enter failed with error: {}\n", errno));
+    }
+}
+
+void UringEngine::releaseSlot(uint32_t slotIndex)
+{
+    UringSlot& uringSlot = this->uringSlots[slotIndex];
+    uringSlot.slotState = SlotState::Free;
+    uringSlot.probeSocket = -1;
+    this->freeSlots.push_back(slotIndex);
+    this->outstanding--;
+}
+
+/// <summary>
+/// Queue a connect and its deadline as one linked chain, nothing reaches the kernel until the next poll.
+/// With direct descriptors the socket is created by the chain as well, so a probe costs no syscalls of its own.
+/// </summary>
+/// <returns>false if there was no descriptor to spare and nothing was queued</returns>
+bool UringEngine::submit(const sockaddr* targetAddr, int addrLen, uint64_t probeTag, int probeTimeout)
+{
+    if (probeTimeout <= 0)
+    {
+        probeTimeout = this->probeTimeout;
+    }
+    if (this->freeSlots.empty())
+    {
+        throw NetException("io_uring engine is full\n");
+    }
+    uint32_t slotIndex = this->freeSlots.back();
+    UringSlot& uringSlot = this->uringSlots[slotIndex];
+    int probeSocket = -1;
+
+    if (!this->directSockets)
+    {
+        probeSocket = socket(targetAddr->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+        if (probeSocket < 0)
+        {
+            int socketError = errno;
+            if (isDescriptorShortage(socketError))
+            {
+                return false;
+            }
+            throw NetException(std::format("Failed to create socket with error: {}\n", socketError));
+        }
+        struct linger l;
+        l.l_onoff = 1;
+        l.l_linger = 0;
+        setsockopt(probeSocket, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+    }
+
+    this->freeSlots.pop_back();
+    uringSlot.generation++;
+    uringSlot.probeTag = probeTag;
+    uringSlot.slotState = SlotState::Connecting;
+    uringSlot.probeSocket = probeSocket;
+    uringSlot.socketError = 0;
+    uringSlot.sentAt = std::chrono::steady_clock::now();
+    uringSlot.linkTimeout[0] = probeTimeout / 1000;
+    uringSlot.linkTimeout[1] = (int64_t)(probeTimeout % 1000) * 1000000;
+    uringSlot.addrLen = (int)std::min((size_t)addrLen, sizeof(uringSlot.targetAddr));
+    memcpy(&uringSlot.targetAddr, targetAddr, uringSlot.addrLen);
+    this->queueConnect(slotIndex);
+    this->outstanding++;
+    return true;
+}
+
+/// <summary>
+/// Queue the socket, connect and linked timeout for a slot that already holds its target.
+/// </summary>
+void UringEngine::queueConnect(uint32_t slotIndex)
+{
+    UringSlot& uringSlot = this->uringSlots[slotIndex];
+    io_uring_sqe* sqe;
+    if (this->directSockets)
+    {
+        sqe = this->getSqe(URING_PROBE_SQES);
+        sqe->opcode = IORING_OP_SOCKET;
+        sqe->fd = uringSlot.targetAddr.ss_family;
+        sqe->off = SOCK_STREAM;
+        sqe->len = IPPROTO_TCP;
+        sqe->file_index = slotIndex + 1;
+        sqe->flags = IOSQE_IO_LINK | IOSQE_CQE_SKIP_SUCCESS;
+        sqe->user_data = packUserData(KIND_SOCKET, uringSlot.generation, slotIndex);
+
+        sqe = this->getSqe(1);
+        sqe->fd = (int)slotIndex;
+        sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_LINK;
+    }
+    else
+    {
+        sqe = this->getSqe(URING_PROBE_SQES - 1);
+        sqe->fd = uringSlot.probeSocket;
+        sqe->flags = IOSQE_IO_LINK;
+    }
+    sqe->opcode = IORING_OP_CONNECT;
+    sqe->addr = (uint64_t)&uringSlot.targetAddr;
+    sqe->off = (uint64_t)uringSlot.addrLen;
+    sqe->user_data = packUserData(KIND_CONNECT, uringSlot.generation, slotIndex);
+
+    // cancels the connect if it outlives the probe timeout
+    sqe = this->getSqe(1);
+    sqe->opcode = IORING_OP_LINK_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t)uringSlot.linkTimeout;
+    sqe->len = 1;
+    sqe->user_data = packUserData(KIND_TIMEOUT, uringSlot.generation, slotIndex);
+}
+
+/// <summary>
+/// Open the shared ICMP socket and keep a ring of receives posted against it.
+/// Unprivileged ping sockets are tried first, raw sockets need CAP_NET_RAW.
+/// </summary>
+void UringEngine::openEchoSocket()
+{
+    this->echoSocket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_ICMP);
+    if (this->echoSocket < 0)
+    {
+        this->echoSocket = socket(AF_INET, SOCK_RAW | SOCK_CLOEXEC, IPPROTO_ICMP);
+        this->echoRaw = true;
+    }
+    if (this->echoSocket < 0)
+    {
+        throw NetException(std::format("Failed to open ICMP socket with error: {}\n", errno));
+    }
+    this->echoIdentifier = (uint16_t)(getpid() & 0xFFFF);
+    this->recvSlots.resize(URING_RECV_DEPTH);
+    for (uint32_t i = 0; i < URING_RECV_DEPTH; i++)
+    {
+        this->postRecv(i);
+    }
+}
+
+void UringEngine::postRecv(uint32_t recvIndex)
+{
+    RecvSlot& recvSlot = this->recvSlots[recvIndex];
+    recvSlot.recvVector.iov_base = recvSlot.recvBuffer;
+    recvSlot.recvVector.iov_len = sizeof(recvSlot.recvBuffer);
+    recvSlot.recvHeader = {};
+    recvSlot.recvHeader.msg_name = &recvSlot.sourceAddr;
+    recvSlot.recvHeader.msg_namelen = sizeof(recvSlot.sourceAddr);
+    recvSlot.recvHeader.msg_iov = &recvSlot.recvVector;
+    recvSlot.recvHeader.msg_iovlen = 1;
+
+    io_uring_sqe* sqe = this->getSqe(1);
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = this->echoSocket;
+    sqe->addr = (uint64_t)&recvSlot.recvHeader;
+    sqe->len = 1;
+    sqe->user_data = packUserData(KIND_RECV, 0, recvIndex);
+}
+
+/// <summary>
+/// Queue an ICMP echo request. The sequence number is the slot index and the payload carries
+/// the slot generation, so replies are matched straight back to their probe.
+/// </summary>
+void UringEngine::submitEcho(const sockaddr_in* targetAddr, uint64_t probeTag)
+{
+    if (this->echoSocket < 0)
+    {
+        this->openEchoSocket();
+    }
+    if (this->freeSlots.empty())
+    {
+        throw NetException("io_uring engine is full\n");
+    }
+    uint32_t slotIndex = this->freeSlots.back();
+    this->freeSlots.pop_back();
+    UringSlot& uringSlot = this->uringSlots[slotIndex];
+    uringSlot.generation++;
+    uringSlot.probeTag = probeTag;
+    uringSlot.slotState = SlotState::Echo;
+    uringSlot.sendPending = true;
+    uringSlot.resultDelivered = false;
+    uringSlot.sentAt = std::chrono::steady_clock::now();
+    uringSlot.deadline = uringSlot.sentAt + std::chrono::milliseconds(this->probeTimeout);
+    memcpy(&uringSlot.targetAddr, targetAddr, sizeof(sockaddr_in));
+
+    uint8_t* echoPacket = uringSlot.echoPacket;
+    memset(echoPacket, 0, sizeof(uringSlot.echoPacket));
+    echoPacket[0] = 8; // echo request
+    echoPacket[4] = (uint8_t)(this->echoIdentifier >> 8);
+    echoPacket[5] = (uint8_t)(this->echoIdentifier & 0xFF);
+    echoPacket[6] = (uint8_t)(slotIndex >> 8);
+    echoPacket[7] = (uint8_t)(slotIndex & 0xFF);
+    memcpy(echoPacket + 8, &uringSlot.generation, sizeof(uringSlot.generation));
+    uint16_t checkSum = ICMPChecksum(echoPacket, sizeof(uringSlot.echoPacket));
+    echoPacket[2] = (uint8_t)(checkSum >> 8);
+    echoPacket[3] = (uint8_t)(checkSum & 0xFF);
+
+    uringSlot.sendVector.iov_base = echoPacket;
+    uringSlot.sendVector.iov_len = sizeof(uringSlot.echoPacket);
+    uringSlot.sendHeader = {};
+    uringSlot.sendHeader.msg_name = &uringSlot.targetAddr;
+    uringSlot.sendHeader.msg_namelen = sizeof(sockaddr_in);
+    uringSlot.sendHeader.msg_iov = &uringSlot.sendVector;
+    uringSlot.sendHeader.msg_iovlen = 1;
+
+    io_uring_sqe* sqe = this->getSqe(1);
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = this->echoSocket;
+    sqe->addr = (uint64_t)&uringSlot.sendHeader;
+    sqe->len = 1;
+    sqe->user_data = packUserData(KIND_SEND, uringSlot.generation, slotIndex);
+
+    this->echoTimeouts.push_back({ slotIndex, uringSlot.generation });
+    this->outstanding++;
+}
+
+/// <summary>
+/// Match an echo reply to its slot, anything that isn't ours is dropped.
+/// </summary>
+void UringEngine::handleEchoReply(RecvSlot& recvSlot, int replyLength, std::vector<ProbeResult>& completed)
+{
+    const uint8_t* replyPacket = recvSlot.recvBuffer;
+    if (this->echoRaw)
+    {
+        // raw sockets hand back the IP header as well
+        int headerLength = (replyPacket[0] & 0x0F) * 4;
+        if (replyLength < headerLength)
+        {
+            return;
+        }
+        replyPacket += headerLength;
+        replyLength -= headerLength;
+    }
+    if (replyLength < 8 + (int)sizeof(uint32_t) || replyPacket[0] != 0 /* echo reply */)
+    {
+        return;
+    }
+    uint16_t identifier = (uint16_t)((replyPacket[4] << 8) | replyPacket[5]);
+    uint32_t slotIndex = (uint32_t)((replyPacket[6] << 8) | replyPacket[7]);
+    uint32_t generation;
+    memcpy(&generation, replyPacket + 8, sizeof(generation));
+
+    // ping sockets rewrite the identifier themselves and only see their own replies
+    if ((this->echoRaw && identifier != this->echoIdentifier) || slotIndex >= this->uringSlots.size())
+    {
+        return;
+    }
+    UringSlot& uringSlot = this->uringSlots[slotIndex];
+    const sockaddr_in* targetAddr = (const sockaddr_in*)&uringSlot.targetAddr;
+    if (uringSlot.slotState != SlotState::Echo || uringSlot.resultDelivered || uringSlot.generation != generation ||
+        targetAddr->sin_addr.s_addr != recvSlot.sourceAddr.sin_addr.s_addr)
+    {
+        return;
+    }
+    completed.push_back({ uringSlot.probeTag, true, 0, false, std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - uringSlot.sentAt).count() });
+    uringSlot.resultDelivered = true;
+    if (!uringSlot.sendPending)
+    {
+        this->releaseSlot(slotIndex);
+    }
+}
+
+void UringEngine::handleCompletion(uint64_t userData, int completionResult, std::vector<ProbeResult>& completed)
+{
+    uint64_t kind = userData >> 56;
+    uint32_t generation = (uint32_t)((userData >> 32) & 0xFFFFFF);
+    uint32_t index = (uint32_t)(userData & 0xFFFFFFFF);
+
+    if (kind == KIND_RECV)
+    {
+        if (completionResult > 0)
+        {
+            this->handleEchoReply(this->recvSlots[index], completionResult, completed);
+        }
+        // keep the receive posted unless the socket itself has gone away
+        if (completionResult != -ECANCELED && completionResult != -EBADF)
+        {
+            this->postRecv(index);
+        }
+        return;
+    }
+    // linked timeouts report -ETIME or -ECANCELED, the connect CQE already carries the outcome
+    if (kind == KIND_TIMEOUT || index >= this->uringSlots.size())
+    {
+        return;
+    }
+    UringSlot& uringSlot = this->uringSlots[index];
+    if ((uringSlot.generation & 0xFFFFFF) != generation)
+    {
+        return;
+    }
+
+    if (kind == KIND_SOCKET)
+    {
+        // only failures post here, the connect behind it is cancelled next
+        uringSlot.socketError = -completionResult;
+    }
+    else if (kind == KIND_CONNECT)
+    {
+        int errorCode = -completionResult;
+        // the socket op found no descriptor to spare, so nothing went out and the chain goes again
+        // on the next flush, by when other probes have had the chance to close theirs
+        if (errorCode == ECANCELED && isDescriptorShortage(uringSlot.socketError))
+        {
+            uringSlot.socketError = 0;
+            uringSlot.sentAt = std::chrono::steady_clock::now();
+            this->queueConnect(index);
+            return;
+        }
+        if (errorCode == ECANCELED)
+        {
+            errorCode = uringSlot.socketError != 0 ? uringSlot.socketError : ETIMEDOUT;
+        }
+        bool timedOut = errorCode == ETIMEDOUT;
+        int64_t roundTrip = timedOut ? -1 : std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - uringSlot.sentAt).count();
+        completed.push_back({ uringSlot.probeTag, completionResult == 0, errorCode, timedOut, roundTrip });
+        if (this->directSockets)
+        {
+            uringSlot.slotState = SlotState::Closing;
+            io_uring_sqe* sqe = this->getSqe(1);
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->file_index = index + 1;
+            sqe->user_data = packUserData(KIND_CLOSE, uringSlot.generation, index);
+        }
+        else
+        {
+            close(uringSlot.probeSocket);
+            this->releaseSlot(index);
+        }
+    }
+    else if (kind == KIND_CLOSE)
+    {
+        this->releaseSlot(index);
+    }
+    else if (kind == KIND_SEND)
+    {
+        uringSlot.sendPending = false;
+        if (completionResult < 0 && !uringSlot.resultDelivered)
+        {
+            completed.push_back({ uringSlot.probeTag, false, -completionResult });
+            uringSlot.resultDelivered = true;
+        }
+        if (uringSlot.resultDelivered)
+        {
+            this->releaseSlot(index);
+        }
+    }
+}
+
+void UringEngine::expireEchoes(std::vector<ProbeResult>& completed)
+{
+    auto timeNow = std::chrono::steady_clock::now();
+    while (!this->echoTimeouts.empty())
+    {
+        auto [slotIndex, generation] = this->echoTimeouts.front();
+        UringSlot& uringSlot = this->uringSlots[slotIndex];
+        if (uringSlot.slotState != SlotState::Echo || uringSlot.generation != generation || uringSlot.resultDelivered)
+        {
+            this->echoTimeouts.pop_front();
+            continue;
+        }
+        if (uringSlot.deadline > timeNow)
+        {
+            return;
+        }
+        this->echoTimeouts.pop_front();
+        completed.push_back({ uringSlot.probeTag, false, ETIMEDOUT, true });
+        uringSlot.resultDelivered = true;
+        if (!uringSlot.sendPending)
+        {
+            this->releaseSlot(slotIndex);
+        }
+    }
+}
+
+/// <summary>
+/// Submit everything queued since the last call and reap completions in one io_uring_enter.
+/// </summary>
+/// <param name="waitTime">max time to block in ms, 0 to only collect what is ready</param>
+/// <param name="completed">results are appended here</param>
+/// <returns>number of results appended</returns>
+size_t UringEngine::poll(int waitTime, std::vector<ProbeResult>& completed)
+{
+    size_t startCount = completed.size();
+    if (this->outstanding == 0 && this->toSubmit == 0)
+    {
+        return 0;
+    }
+    this->expireEchoes(completed);
+    if (!this->echoTimeouts.empty())
+    {
+        auto untilDeadline = std::chrono::duration_cast<std::chrono::milliseconds>(
+            this->uringSlots[this->echoTimeouts.front().first].deadline - std::chrono::steady_clock::now());
+        waitTime = std::clamp(waitTime, 0, std::max((int)untilDeadline.count() + 1, 0));
+    }
+    unsigned cqReady = std::atomic_ref<unsigned>(*this->cqTail).load(std::memory_order_acquire) - *this->cqHead;
+    if (completed.size() > startCount || cqReady > 0)
+    {
+        waitTime = 0;
+    }
+    this->flushSubmissions(waitTime > 0 ? 1 : 0, waitTime);
+
+    unsigned cqHeadNow = *this->cqHead;
+    unsigned cqTailNow = std::atomic_ref<unsigned>(*this->cqTail).load(std::memory_order_acquire);
+    for (; cqHeadNow != cqTailNow; cqHeadNow++)
+    {
+        io_uring_cqe& cqe = this->cqEntries[cqHeadNow & this->cqMask];
+        this->handleCompletion(cqe.user_data, cqe.res, completed);
+    }
+    std::atomic_ref<unsigned>(*this->cqHead).store(cqHeadNow, std::memory_order_release);
+
+    this->expireEchoes(completed);
+    return completed.size() - startCount;
+}
+
+size_t UringEngine::getOutstanding()
+{
+    return this->outstanding;
+}
+
+bool UringEngine::isFull()
+{
+    return this->freeSlots.empty();
+}
+
+#else
+
+UringEngine::UringEngine(int /*maxOutstanding*/, int /*probeTimeout*/)
+{
+    throw NetException("io_uring is only available on Linux\n");
+}
+
+UringEngine::~UringEngine() {}
+
+bool UringEngine::isSupported()
+{
+    return false;
+}
+
+bool UringEngine::submit(const sockaddr* /*targetAddr*/, int /*addrLen*/, uint64_t /*probeTag*/, int /*probeTimeout*/) { return false; }
+
+void UringEngine::submitEcho(const sockaddr_in* /*targetAddr*/, uint64_t /*probeTag*/) {}
+
+size_t UringEngine::poll(int /*waitTime*/, std::vector<ProbeResult>& /*completed*/)
+{
+    return 0;
+}
+
+size_t UringEngine::getOutstanding()
+{
+    return 0;
+}
+
+bool UringEngine::isFull()
+{
+    return true;
+}
+
+#endif
@@ -0,0 +1,126 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// UringEngine:
+// io_uring submission/completion prober for TCP connects and ICMP echoes (Linux only). (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include "ProbeEngine.h"
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <cstdint>
+#ifdef __linux__
+#include <sys/uio.h>
+#endif
+
+// bytes of payload carried by each echo request
+constexpr int URING_ECHO_PAYLOAD = 32;
+// receives kept posted against the ICMP socket
+constexpr int URING_RECV_DEPTH = 64;
+
+class UringEngine : public ProbeEngine
+{
+public:
+	UringEngine(int maxOutstanding, int probeTimeout);
+	~UringEngine();
+	UringEngine(const UringEngine&) = delete;
+	UringEngine& operator=(const UringEngine&) = delete;
+public:
+	static bool isSupported();
+	bool submit(const sockaddr* targetAddr, int addrLen, uint64_t probeTag, int probeTimeout) override;
+	void submitEcho(const sockaddr_in* targetAddr, uint64_t probeTag);
+	size_t poll(int waitTime, std::vector<ProbeResult>& completed) override;
+	size_t getOutstanding() override;
+	bool isFull() override;
+#ifdef __linux__
+private:
+	enum class SlotState { Free, Connecting, Closing, Echo };
+	struct UringSlot
+	{
+		uint64_t probeTag = 0;
+		uint32_t generation = 0;
+		SlotState slotState = SlotState::Free;
+		int probeSocket = -1;
+		int socketError = 0;
+		bool sendPending = false;
+		bool resultDelivered = false;
+		sockaddr_storage targetAddr{};
+		int addrLen = 0;
+		std::chrono::steady_clock::time_point sentAt{};
+		std::chrono::steady_clock::time_point deadline{};
+		// __kernel_timespec for the linked timeout, read by the kernel when the chain is submitted
+		int64_t linkTimeout[2]{};
+		// echo request, kept alive until the send completes
+		msghdr sendHeader{};
+		iovec sendVector{};
+		uint8_t echoPacket[8 + URING_ECHO_PAYLOAD]{};
+	};
+	struct RecvSlot
+	{
+		msghdr recvHeader{};
+		iovec recvVector{};
+		sockaddr_in sourceAddr{};
+		uint8_t recvBuffer[1024]{};
+	};
+	struct io_uring_sqe* getSqe(unsigned requiredSpace);
+	void flushSubmissions(unsigned minComplete, int waitTime);
+	void queueConnect(uint32_t slotIndex);
+	void handleCompletion(uint64_t userData, int completionResult, std::vector<ProbeResult>& completed);
+	void handleEchoReply(RecvSlot& recvSlot, int replyLength, std::vector<ProbeResult>& completed);
+	void postRecv(uint32_t recvIndex);
+	void openEchoSocket();
+	void releaseSlot(uint32_t slotIndex);
+	void expireEchoes(std::vector<ProbeResult>& completed);
+private:
+	int ringHandle = -1;
+	bool directSockets = false;
+	// shared mmap regions and the pointers into them
+	void* sqRing = nullptr;
+	void* cqRing = nullptr;
+	size_t sqRingSize = 0;
+	size_t cqRingSize = 0;
+	struct io_uring_sqe* sqEntries = nullptr;
+	size_t sqEntriesSize = 0;
+	unsigned* sqHead = nullptr;
+	unsigned* sqTail = nullptr;
+	unsigned* sqArray = nullptr;
+	unsigned sqMask = 0;
+	unsigned sqCount = 0;
+	unsigned* cqHead = nullptr;
+	unsigned* cqTail = nullptr;
+	struct io_uring_cqe* cqEntries = nullptr;
+	unsigned cqMask = 0;
+	// local copy of the tail, published to the kernel on flush
+	unsigned sqLocalTail = 0;
+	unsigned toSubmit = 0;
+
+	std::vector<UringSlot> uringSlots;
+	std::vector<uint32_t> freeSlots;
+	std::vector<RecvSlot> recvSlots;
+	// echo deadlines are tracked here as a reply has no request op to link a timeout to
+	std::deque<std::pair<uint32_t, uint32_t>> echoTimeouts;
+	int probeTimeout;
+	int echoSocket = -1;
+	bool echoRaw = false;
+	uint16_t echoIdentifier = 0;
+	size_t outstanding = 0;
+#endif
+};
@@ -25,9 +25,12 @@
 #include "Validators.h"
 #include "CLIHandler.h"
 #include "utils.h"
+#include "ResultFormatter.h"
 #include <string>
 #include <stdexcept>
 #include <format>
+#include <cctype>
+#include <cstdint>
 
 
 constexpr int PORT_LIMIT = 65355;
@@ -35,6 +38,8 @@ constexpr int HOST_LEN_MAX = 253;
 constexpr int MAX_THREADS = 1024;
 constexpr int MAX_DELAY = 50000;
 constexpr int MIN_DELAY = 30;
+constexpr int MAX_RATE = 10000000;
+constexpr int MAX_STATS_INTERVAL = 86400;
 
 class ArgException : public std::invalid_argument {
 public:
@@ -143,3 +148,158 @@ struct validationResult validateDelay(CLIArg::ArgValue delayValue)
 	return { true, "" };
 }
 
+/// <summary>
+/// Check if a probe rate is a positive int within range
+/// </summary>
+/// <param name="rateValue">requested rate in probes per second</param>
+/// <returns>true if rate within range and is an int</returns>
+struct validationResult validateRate(CLIArg::ArgValue rateValue)
+{
+	std::string rateString = std::get<std::string>(rateValue);
+	try
+	{
+		int requestedRate = std::stoi(rateString);
+		if (requestedRate > MAX_RATE || requestedRate <= 0)
+		{
+			return { false, std::format("Requested rate '{}' is out of range\n", requestedRate) };
+		}
+	}
+	catch (const std::exception&)
+	{
+		return { false, std::format("Requested rate '{}' is not valid\n", rateString) };
+	}
+	return { true, "" };
+}
+
+/// <summary>
+/// Check if a progress interval is a positive number of seconds within range
+/// </summary>
+/// <param name="intervalValue">requested seconds between progress lines</param>
+/// <returns>true if interval within range and is an int</returns>
+struct validationResult validateInterval(CLIArg::ArgValue intervalValue)
+{
+	std::string intervalString = std::get<std::string>(intervalValue);
+	try
+	{
+		int requestedInterval = std::stoi(intervalString);
+		if (requestedInterval > MAX_STATS_INTERVAL || requestedInterval <= 0)
+		{
+			return { false, std::format("Requested interval '{}' is out of range\n", requestedInterval) };
+		}
+	}
+	catch (const std::exception&)
+	{
+		return { false, std::format("Requested interval '{}' is not valid\n", intervalString) };
+	}
+	return { true, "" };
+}
+
+/// <summary>
+/// Validate a seed for the probe order, 0 is left to mean pick one at random.
+/// </summary>
+/// <param name="seedValue">requested seed</param>
+/// <returns>true if seed is a positive 64 bit int</returns>
+struct validationResult validateSeed(CLIArg::ArgValue seedValue)
+{
+	std::string seedString = std::get<std::string>(seedValue);
+	try
+	{
+		// stoull would wrap a negative seed round rather than refuse it
+		size_t parsedLength = 0;
+		if (seedString.empty() || !std::isdigit((unsigned char)seedString.front()))
+		{
+			throw std::invalid_argument(seedString);
+		}
+		uint64_t requestedSeed = std::stoull(seedString, &parsedLength);
+		if (parsedLength != seedString.size())
+		{
+			throw std::invalid_argument(seedString);
+		}
+		if (requestedSeed == 0)
+		{
+			return { false, std::format("Requested seed '{}' is out of range\n", requestedSeed) };
+		}
+	}
+	catch (const std::exception&)
+	{
+		return { false, std::format("Requested seed '{}' is not valid\n", seedString) };
+	}
+	return { true, "" };
+}
+
+/// <summary>
+/// Check if a top ports count is a positive int no bigger than the port range
+/// </summary>
+/// <param name="topPortsValue">requested number of most often open ports</param>
+/// <returns>true if count within range and is an int</returns>
+struct validationResult validateTopPorts(CLIArg::ArgValue topPortsValue)
+{
+	std::string topPortsString = std::get<std::string>(topPortsValue);
+	try
+	{
+		int requestedPorts = std::stoi(topPortsString);
+		if (requestedPorts <= 0 || requestedPorts > 65535)
+		{
+			return { false, std::format("Requested top port count '{}' is out of range\n", requestedPorts) };
+		}
+	}
+	catch (const std::exception&)
+	{
+		return { false, std::format("Requested top port count '{}' is not valid\n", topPortsString) };
+	}
+	return { true, "" };
+}
+
+/// <summary>
+/// Check that an output path was actually given, whether it can be written is only known once it is opened
+/// </summary>
+/// <param name="pathValue">requested file path, or - for stdout where a flag allows it</param>
+/// <returns>true if path is not empty</returns>
+struct validationResult validateOutputPath(CLIArg::ArgValue pathValue)
+{
+	std::string outputPath = std::get<std::string>(pathValue);
+	if (outputPath.empty())
+	{
+		return { false, "Output path can not be empty\n" };
+	}
+	return { true, "" };
+}
+
+/// <summary>
+/// Check if an output format is one the formatters know by name
+/// </summary>
+/// <param name="formatValue">requested format name</param>
+/// <returns>true if format is text, json, csv, grepable or xml</returns>
+struct validationResult validateOutputFormat(CLIArg::ArgValue formatValue)
+{
+	std::string formatName = std::get<std::string>(formatValue);
+	OutputFormat outputFormat;
+	if (!parseOutputFormat(formatName, outputFormat))
+	{
+		return { false, std::format("Output format '{}' is not one of text, json, csv, grepable or xml\n", formatName) };
+	}
+	return { true, "" };
+}
+
+/// <summary>
+/// Check if a baseline sample is a percentage from 0 to 100
+/// </summary>
+/// <param name="sampleValue">requested percent of unlisted probes to send</param>
+/// <returns>true if sample within range and is an int</returns>
+struct validationResult validateSample(CLIArg::ArgValue sampleValue)
+{
+	std::string sampleString = std::get<std::string>(sampleValue);
+	try
+	{
+		int samplePercent = std::stoi(sampleString);
+		if (samplePercent < 0 || samplePercent > 100)
+		{
+			return { false, std::format("Requested sample of {}% is out of range\n", samplePercent) };
+		}
+	}
+	catch (const std::exception&)
+	{
+		return { false, std::format("Requested sample '{}' is not valid\n", sampleString) };
+	}
+	return { true, "" };
+}
@@ -17,3 +17,17 @@ validationResult validateTarget(CLIArg::ArgValue hostValue);
 validationResult validateThreads(CLIArg::ArgValue threadsValue);
 
 validationResult validateDelay(CLIArg::ArgValue delayValue);
+
+validationResult validateRate(CLIArg::ArgValue rateValue);
+
+validationResult validateInterval(CLIArg::ArgValue intervalValue);
+
+validationResult validateSeed(CLIArg::ArgValue seedValue);
+
+validationResult validateTopPorts(CLIArg::ArgValue topPortsValue);
+
+validationResult validateOutputPath(CLIArg::ArgValue pathValue);
+
+validationResult validateOutputFormat(CLIArg::ArgValue formatValue);
+
+validationResult validateSample(CLIArg::ArgValue sampleValue);
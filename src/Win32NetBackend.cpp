@@ -0,0 +1,197 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// Win32NetBackend:
+// NetBackend over WinSock, IcmpAPI, SendARP and conio.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include "Win32NetBackend.h"
+#ifdef _WIN32
+#include "utils.h"
+#include <stdexcept>
+#include <format>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <conio.h>
+#include <IcmpAPI.h>
+
+// bytes of random padding carried by each echo
+constexpr int ICMP_DATA_SIZE = 64;
+// ms between keyboard checks while waiting for input
+constexpr int CONSOLE_SLEEP_STEP = 10;
+
+class NetException : public std::runtime_error {
+public:
+    NetException(const std::string& message)
+        : std::runtime_error(message) {}
+};
+
+/// <summary>
+/// Run WSAStartup and open the ICMP handle shared by every blocking echo.
+/// Must be called before any resolution or probing, and balanced by cleanup().
+/// </summary>
+bool Win32NetBackend::startup()
+{
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        return false;
+    }
+    this->wsaStarted = true;
+    this->icmpFile = IcmpCreateFile();
+    this->wakeEvent = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+    return true;
+}
+
+void Win32NetBackend::cleanup()
+{
+    if (this->icmpFile != INVALID_HANDLE_VALUE)
+    {
+        IcmpCloseHandle(this->icmpFile);
+        this->icmpFile = INVALID_HANDLE_VALUE;
+    }
+    if (this->wakeEvent != nullptr)
+    {
+        CloseHandle(this->wakeEvent);
+        this->wakeEvent = nullptr;
+    }
+    if (this->wsaStarted)
+    {
+        WSACleanup();
+        this->wsaStarted = false;
+    }
+}
+
+/// <summary>
+/// Send one echo through IcmpAPI and block until its reply or the timeout.
+/// </summary>
+/// <param name="roundTrip">set to the reply's round trip in microseconds</param>
+EchoStatus Win32NetBackend::echoHost(uint32_t targetAddr, int replyTimeout, int64_t& roundTrip)
+{
+    if (this->icmpFile == INVALID_HANDLE_VALUE)
+    {
+        throw NetException(std::format("Failed to open ICMP handle with error: {}\n", GetLastError()));
+    }
+    // sized for the echo plus an ICMP error's payload
+    std::vector<uint8_t> replyBuffer(sizeof(ICMP_ECHO_REPLY) + ICMP_DATA_SIZE + 8);
+    std::string sendData = randomString(ICMP_DATA_SIZE);
+
+    DWORD replyCount = IcmpSendEcho(
+        this->icmpFile, htonl(targetAddr), (void*)sendData.c_str(), (WORD)sendData.size(), NULL,
+        replyBuffer.data(), (DWORD)replyBuffer.size(), replyTimeout
+    );
+    if (replyCount == 0)
+    {
+        return EchoStatus::TimedOut;
+    }
+    PICMP_ECHO_REPLY echoReply = (PICMP_ECHO_REPLY)replyBuffer.data();
+    if (echoReply->Status == IP_SUCCESS)
+    {
+        roundTrip = (int64_t)echoReply->RoundTripTime * 1000;
+        return EchoStatus::Replied;
+    }
+    if (echoReply->Status != IP_DEST_HOST_UNREACHABLE)
+    {
+        in_addr hostAddr{};
+        hostAddr.s_addr = htonl(targetAddr);
+        char hostString[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &hostAddr, hostString, sizeof(hostString));
+        std::cout << std::format("Got non standard error: {} for host: {}", echoReply->Status, hostString) << std::endl;
+    }
+    return EchoStatus::Unreachable;
+}
+
+/// <summary>
+/// Resolve a host's MAC address with SendARP, formatted as dash separated hex.
+/// </summary>
+/// <returns>the MAC, or an empty string when the host did not answer ARP</returns>
+std::string Win32NetBackend::lookupMac(uint32_t targetAddr)
+{
+    ULONG macAddr[2];
+    ULONG macAddrLen = 6;
+    std::ostringstream macString{};
+
+    DWORD arpRetVal = SendARP(htonl(targetAddr), INADDR_ANY, &macAddr, &macAddrLen);
+    if (arpRetVal == NO_ERROR)
+    {
+        BYTE* macFormated = (BYTE*)&macAddr;
+        for (size_t i = 0; i < (size_t)macAddrLen; i++)
+        {
+            if (i == (macAddrLen - 1)) {
+                macString << std::format("{:02X}", macFormated[i]);
+            }
+            else
+            {
+                macString << std::format("{:02X}-", macFormated[i]);
+            }
+        }
+        return macString.str();
+    }
+    switch (arpRetVal)
+    {
+    case ERROR_BAD_NET_NAME:
+        throw NetException("ARP target could not be resolved");
+    case ERROR_NOT_SUPPORTED:
+        throw NetException("ARP is not supported on this device");
+    default:
+        return "";
+    }
+}
+
+/// <summary>
+/// Wait up to waitTime ms for a key press on the console, or until wakeConsole() is called.
+/// The console handle also signals for mouse and focus events, so keys are checked on a short step instead.
+/// </summary>
+/// <returns>the key, or -1 if nothing was pressed in time or the wait was woken</returns>
+int Win32NetBackend::readKey(int waitTime)
+{
+    auto waitEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(waitTime);
+    while (true)
+    {
+        if (_kbhit())
+        {
+            return _getch();
+        }
+        if (std::chrono::steady_clock::now() >= waitEnd)
+        {
+            return -1;
+        }
+        if (this->wakeEvent == nullptr)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(CONSOLE_SLEEP_STEP));
+        }
+        else if (WaitForSingleObject(this->wakeEvent, CONSOLE_SLEEP_STEP) == WAIT_OBJECT_0)
+        {
+            return -1;
+        }
+    }
+}
+
+void Win32NetBackend::wakeConsole()
+{
+    if (this->wakeEvent != nullptr)
+    {
+        SetEvent(this->wakeEvent);
+    }
+}
+#endif
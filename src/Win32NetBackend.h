@@ -0,0 +1,47 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// Win32NetBackend:
+// NetBackend over WinSock, IcmpAPI, SendARP and conio. (Header File)
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+#pragma once
+#include "NetBackend.h"
+#ifdef _WIN32
+#include <WinSock2.h>
+#include <iphlpapi.h>
+#pragma comment(lib, "iphlpapi")
+
+class Win32NetBackend : public NetBackend
+{
+public:
+	bool startup() override;
+	void cleanup() override;
+	EchoStatus echoHost(uint32_t targetAddr, int replyTimeout, int64_t& roundTrip) override;
+	std::string lookupMac(uint32_t targetAddr) override;
+	int readKey(int waitTime) override;
+	void wakeConsole() override;
+private:
+	// IcmpSendEcho is safe to call from several threads on one handle
+	HANDLE icmpFile = INVALID_HANDLE_VALUE;
+	bool wsaStarted = false;
+	// auto reset event signalled by wakeConsole, checked between keyboard polls
+	HANDLE wakeEvent = nullptr;
+};
+#endif
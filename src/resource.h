@@ -4,7 +4,6 @@
 //
 
 #define TEXTFILE 255
-#define SERVICE_LIST 254
 
 // Next default values for new objects
 // 
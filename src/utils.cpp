@@ -20,14 +20,9 @@
 //You should have received a copy of the GNU General Public License along
 //with this program; if not, see < https://www.gnu.org/licenses/>.
 #include "utils.h"
-#pragma comment (lib, "Mswsock.lib")
-#include <WinSock2.h>
-#pragma comment(lib, "ws2_32")
-#include <ws2tcpip.h>
-#include <iphlpapi.h>
-#include<IcmpAPI.h>
-#pragma comment(lib, "iphlpapi.lib")
+#include "NetBackend.h"
 #include<stdexcept>
+#include <charconv>
 #include <random>
 #include <time.h>
 #include <stdio.h>
@@ -47,18 +42,6 @@ void displayHeader()
 	printf("%s (%s)\n%s\n", TITLE, VERSION, SPLITTER);
 }
 
-bool windowsInit()
-{
-	WSADATA WSAData;
-	if (WSAStartup(MAKEWORD(2, 2), &WSAData) != 0)
-	{
-		return false;
-	}
-	return true;
-}
-
-void windowsCleanup() { WSACleanup(); }
-
 std::string randomString(int size)
 {
 	static auto& chrs = "0123456789"
@@ -84,96 +67,78 @@ public:
 };
 
 /// <summary>
-/// Expand a CIDR expression to a full list of addresses.
+/// Add the hosts of a CIDR expression to the target space as one range, the network and broadcast addresses are left out.
 /// </summary>
 /// <param name="networkNotation"></param>
-/// <returns>vector<string> of IP addresses</returns>
-std::vector<std::string> expandCIDR(std::string networkNotation ) {
-	uint8_t firstByte, secondByte, thirdByte, fourthByte, notation = 0;
-	std::vector<std::string> allHosts;
-
-
-	if (sscanf_s(networkNotation.c_str(), "%hhu.%hhu.%hhu.%hhu/%hhu",
-		&firstByte, &secondByte, &thirdByte, &fourthByte, &notation) < 4) {
+/// <param name="targetSpace">space to add the range to</param>
+void expandCIDR(std::string networkNotation, TargetSpace& targetSpace) {
+	int notation = 0;
+
+	// sscanf_s is MSVC only, so split the address and mask by hand
+	size_t maskStart = networkNotation.find('/');
+	std::string hostAddress = networkNotation.substr(0, maskStart);
+	in_addr networkAddr{};
+	if (inet_pton(AF_INET, hostAddress.c_str(), &networkAddr) != 1) {
 		throw UtilException("Provided with invalid IP");
 	}
+	if (maskStart != std::string::npos) {
+		const char* maskEnd = networkNotation.data() + networkNotation.size();
+		auto [parseEnd, parseError] = std::from_chars(networkNotation.data() + maskStart + 1, maskEnd, notation);
+		if (parseError != std::errc() || parseEnd != maskEnd) {
+			throw UtilException("Provided with invalid IP");
+		}
+	}
 	if (notation > 32) {
 		throw UtilException("CIDR mask out of range");
 	}
-	if (notation == 32 || notation == NULL) {
-		// skip maths and just return address
-		char stringAddr[128];
-		snprintf(stringAddr, 128, "%d.%d.%d.%d", firstByte, secondByte, thirdByte, fourthByte);
-
-		allHosts.push_back(std::string(stringAddr));
-		return allHosts;
+	uint32_t ip = ntohl(networkAddr.s_addr);
+	if (notation == 32 || notation == 0) {
+		// skip maths and just use the address
+		targetSpace.addAddress(ip);
+		return;
 	}
 
 	// Calc the first IP and last IP
-	uint32_t ip = (firstByte << 24UL) |
-		(secondByte << 16UL) |
-		(thirdByte << 8UL) |
-		(fourthByte);
 	uint32_t mask = (0xFFFFFFFFUL << (32 - notation)) & 0xFFFFFFFFUL;
 	uint32_t firstIp = ip & mask;
 	uint32_t lastIp = firstIp | ~mask;
-
-	for (size_t i = firstIp + 1; i < lastIp; i++)
+	if (lastIp - firstIp >= 2)
 	{
-		char finalString[256];
-		int addressFlipped = htonl(i);
-		inet_ntop(
-			AF_INET, &addressFlipped, finalString, 256
-		);
-		allHosts.push_back(finalString);
+		targetSpace.addRange(firstIp + 1, lastIp - 1);
 	}
-	return allHosts;
 }
 
 /// <summary>
 /// Perform DNS resolution against a provided hostname
 /// </summary>
 /// <param name="hostname">hostname to resolve</param>
-/// <returns>IP address of host as string</returns>
-std::string resolveHostname(std::string& hostname)
+/// <returns>host order IPv4 address of the host, 0 if it didn't resolve</returns>
+uint32_t resolveHostname(const std::string& hostname)
 {
-	struct addrinfo hints = {};
-	struct addrinfo* result = nullptr;
-
-	hints.ai_family = AF_INET;
-	hints.ai_socktype = SOCK_STREAM;
-
-	int res = getaddrinfo(hostname.c_str(), nullptr, &hints, &result);
-
-	for (struct addrinfo* rp = result; rp != nullptr; rp = rp->ai_next)
+	sockaddr_storage hostAddr{};
+	int hostAddrLen = 0;
+	if (!getNetBackend().resolveHost(hostname, AF_INET, hostAddr, hostAddrLen))
 	{
-		char addressBuffer[INET6_ADDRSTRLEN];
-		if (rp->ai_family == AF_INET)
-		{
-			struct sockaddr_in* addr = (struct sockaddr_in*)rp->ai_addr;
-			return inet_ntop(AF_INET, &addr->sin_addr, addressBuffer, sizeof(addressBuffer));
-		}
+		return 0;
 	}
-
-	return std::string{};
+	return ntohl(((sockaddr_in*)&hostAddr)->sin_addr.s_addr);
 }
 
 /// <summary>
-/// Expand a network from a given host string, has multiple outcomes:
-/// 1. If host is CIDR notated return all possible adresses
-/// 2. If host is an IP return the IP
+/// Expand a network from a given host string into the target space, has multiple outcomes:
+/// 1. If host is CIDR notated add the whole range
+/// 2. If host is an IP add the IP
 /// 3. if host is a hostname perform DNS resolution.
 /// </summary>
 /// <param name="hostString"></param>
-/// <returns>vector<string> of final addresses)</returns>
-std::vector<std::string> expandNetwork(std::string hostString)
+/// <param name="targetSpace">space the hosts are added to, nothing is added for a name that won't resolve</param>
+void expandNetwork(std::string hostString, TargetSpace& targetSpace)
 {
-	std::vector<std::string> allHosts{};
 	struct in_addr addr; 
 	if (inet_pton(AF_INET,hostString.c_str(),&addr) == 1)
 	{
 		// should be a basic ip with no CIDR
-		allHosts.push_back(hostString);
+		targetSpace.addAddress(ntohl(addr.s_addr));
 	}
 	else
 	{
@@ -181,17 +146,16 @@ std::vector<std::string> expandNetwork(std::string hostString)
 		std::smatch hostMatch;
 		if (std::regex_match(hostString, hostMatch, CIDRRegex))
 		{
-			allHosts = expandCIDR(hostString);
+			expandCIDR(hostString, targetSpace);
 		}
 		else
 		{
 			// asume that this is a hostname
-			std::string hostResult = resolveHostname(hostString);
-			if (hostResult.size() > 0)
+			uint32_t hostResult = resolveHostname(hostString);
+			if (hostResult != 0)
 			{
-				allHosts.push_back(hostResult);
+				targetSpace.addAddress(hostResult);
 			}
 		}
 	}
-	return allHosts;
 }
\ No newline at end of file
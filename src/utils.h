@@ -27,6 +27,8 @@
 #include <string>
 #include <time.h>
 #include <regex>
+#include <cstdint>
+#include "TargetSpace.h"
 
 
 // Hardcoded values for intro text and others.
@@ -34,16 +36,12 @@ constexpr auto TITLE = "NetMap";
 constexpr auto VERSION = "v0.1";
 constexpr auto SPLITTER = "------------------------";
 constexpr auto VERBOSE_INTRO = "Started in verbose mode";
-constexpr auto SHORT_HELP = "Usage: map [-h help] [-t target] [-p ports] [-n net-threads] [-d delay] [-f fast-mode]  [-v verbose]";
+constexpr auto SHORT_HELP = "Usage: map [-h help] [-t target] [-p ports] [-n net-threads] [-d delay] [-f fast-mode] [-i io-uring] [-s syn] [-m max-rate] [--min-rate] [--stats-every] [--seed] [--top-ports] [-j json-lines] [-o output-format] [--output-file] [-c checkpoint] [-r resume] [-b baseline] [--sample] [-g grab-banners] [-u udp] [-v verbose]";
 constexpr auto REPO_LINK = "https://github.com/jroo1053/NetMap";
-constexpr auto LONG_HELP = "TCP network scanner.\nOptions: -t (Required) hosts to target, may use CIDR notation or hostname\
-\n-p ports to target\n-n number of threads to use\n-d delay between each host in ms\n-f skip ping scan\n-v toggle verbose output\
+constexpr auto LONG_HELP = "TCP and UDP network scanner.\nOptions: -t (Required) hosts to target, may use CIDR notation or hostname\
+\n-p ports to target\n-n number of threads to use\n-d delay between each host in ms, converted to an equivalent global rate\n-f skip ping scan\n-i use the io_uring probe engine (Linux only)\n-s half-open SYN scan over a raw socket (Linux, needs root)\n-m most probes per second across all threads\n--min-rate fewest probes per second, overrides congestion control\n--stats-every print progress every N seconds, s prints it on demand\n--seed fix the random order hosts are probed in\n--top-ports scan the N ports most often found open instead of -p\n-j stream hosts and open ports to a file as JSON lines while scanning, - for stdout\n-o format for the results, text json csv grepable or xml\n--output-file write the results to a file instead of stdout\n-c save progress to a checkpoint file as the scan runs\n-r resume from a checkpoint, with the same targets and ports\n-b rescan against earlier csv results and list what changed\n--sample percent of the probes the baseline says nothing about to still send\n-g read banners from open ports to identify the service and version\n-u scan the ports over UDP instead of TCP\n-v toggle verbose output\
 \n-h print this message";
 
-bool windowsInit();
-
-void windowsCleanup();
-
 void displayHelp(bool longOutput);
 
 void displayHeader();
@@ -51,6 +49,6 @@ void displayHeader();
 
 std::string randomString(int size);
 
-std::string resolveHostname(std::string& hostname);
+uint32_t resolveHostname(const std::string& hostname);
 
-std::vector<std::string> expandNetwork(std::string networkNotation);
\ No newline at end of file
+void expandNetwork(std::string networkNotation, TargetSpace& targetSpace);
\ No newline at end of file
@@ -0,0 +1,179 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// ServiceTableGen:
+// Build time tool that turns res/known-services into the compiled in services table.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <charconv>
+#include <cstdint>
+#include <iomanip>
+
+// port numbers per protocol, every one gets a slot in the index
+constexpr size_t SERVICE_PORT_COUNT = 65536;
+// blob bytes per line of the generated array
+constexpr size_t BLOB_LINE_BYTES = 32;
+
+struct ServiceLine
+{
+    uint32_t nameOffset = 0;
+    uint32_t nameLength = 0;
+    uint32_t commentOffset = 0;
+    uint32_t commentLength = 0;
+    double openFrequency = 0;
+};
+
+// strings are stored once however many ports share them, tcp and udp mostly repeat each other
+static uint32_t addToBlob(std::string& serviceBlob, std::unordered_map<std::string, uint32_t>& blobOffsets, const std::string& blobString)
+{
+    auto [blobEntry, isNew] = blobOffsets.try_emplace(blobString, (uint32_t)serviceBlob.size());
+    if (isNew)
+    {
+        serviceBlob += blobString;
+    }
+    return blobEntry->second;
+}
+
+static std::string trimString(const std::string& rawString)
+{
+    size_t trimStart = rawString.find_first_not_of(" \t\r");
+    if (trimStart == std::string::npos)
+    {
+        return "";
+    }
+    return rawString.substr(trimStart, rawString.find_last_not_of(" \t\r") - trimStart + 1);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: ServiceTableGen <known-services> <output>" << std::endl;
+        return 1;
+    }
+    std::ifstream serviceFile(argv[1]);
+    if (!serviceFile.is_open())
+    {
+        std::cerr << "Failed to open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::string serviceBlob;
+    std::unordered_map<std::string, uint32_t> blobOffsets;
+    // record 0 is the empty one every unlisted port points at
+    std::vector<ServiceLine> serviceLines(1);
+    std::vector<std::vector<uint16_t>> serviceIndex(2, std::vector<uint16_t>(SERVICE_PORT_COUNT, 0));
+    std::string fileLine;
+
+    while (std::getline(serviceFile, fileLine))
+    {
+        if (fileLine.empty() || fileLine[0] == '#')
+        {
+            continue;
+        }
+        // name port/protocol frequency, then an optional comment after a #
+        size_t commentStart = fileLine.find('#');
+        std::istringstream lineStream(fileLine.substr(0, commentStart));
+        std::string serviceName;
+        std::string portEntry;
+        std::string openFrequency;
+        if (!(lineStream >> serviceName >> portEntry >> openFrequency))
+        {
+            continue;
+        }
+        int portNumber = 0;
+        auto [protocolStart, parseError] = std::from_chars(portEntry.data(), portEntry.data() + portEntry.size(), portNumber);
+        if (parseError != std::errc() || *protocolStart != '/' || portNumber < 0 || portNumber >= (int)SERVICE_PORT_COUNT)
+        {
+            continue;
+        }
+        double frequencyValue = 0;
+        auto [frequencyEnd, frequencyError] = std::from_chars(openFrequency.data(), openFrequency.data() + openFrequency.size(), frequencyValue);
+        if (frequencyError != std::errc() || frequencyEnd != openFrequency.data() + openFrequency.size())
+        {
+            continue;
+        }
+        std::string serviceProtocol(protocolStart + 1);
+        int protocolIndex = serviceProtocol == "tcp" ? 0 : serviceProtocol == "udp" ? 1 : -1;
+        if (protocolIndex < 0)
+        {
+            continue;
+        }
+
+        ServiceLine serviceLine;
+        std::string serviceComment = commentStart == std::string::npos ? "" : trimString(fileLine.substr(commentStart + 1));
+        serviceLine.nameOffset = addToBlob(serviceBlob, blobOffsets, serviceName);
+        serviceLine.nameLength = (uint32_t)serviceName.size();
+        serviceLine.commentOffset = addToBlob(serviceBlob, blobOffsets, serviceComment);
+        serviceLine.commentLength = (uint32_t)serviceComment.size();
+        serviceLine.openFrequency = frequencyValue;
+        if (serviceLines.size() > UINT16_MAX || serviceLine.nameLength > UINT16_MAX || serviceLine.commentLength > UINT16_MAX)
+        {
+            std::cerr << "Services list too large for the 16 bit table fields" << std::endl;
+            return 1;
+        }
+        serviceIndex[protocolIndex][portNumber] = (uint16_t)serviceLines.size();
+        serviceLines.push_back(serviceLine);
+    }
+
+    std::ostringstream tableSource;
+    tableSource << "// Generated from res/known-services by ServiceTableGen at build time, do not edit.\n";
+    tableSource << "// Included once by ServiceTable.cpp.\n\n";
+    tableSource << "constexpr unsigned char SERVICE_BLOB[] = {";
+    for (size_t blobIndex = 0; blobIndex < serviceBlob.size(); blobIndex++)
+    {
+        tableSource << (blobIndex % BLOB_LINE_BYTES == 0 ? "\n    " : " ") << (int)(unsigned char)serviceBlob[blobIndex] << ",";
+    }
+    // never empty, so the array is valid even for an empty list
+    tableSource << "\n    0\n};\n\n";
+
+    // the list gives frequencies to six places
+    tableSource << std::fixed << std::setprecision(6);
+    tableSource << "constexpr ServiceRecord SERVICE_RECORDS[] = {\n";
+    for (ServiceLine& serviceLine : serviceLines)
+    {
+        tableSource << "    { " << serviceLine.nameOffset << ", " << serviceLine.nameLength << ", "
+            << serviceLine.commentOffset << ", " << serviceLine.commentLength << ", "
+            << serviceLine.openFrequency << "f },\n";
+    }
+    tableSource << "};\n\n";
+
+    tableSource << "constexpr uint16_t SERVICE_INDEX[2][" << SERVICE_PORT_COUNT << "] = {\n";
+    for (std::vector<uint16_t>& protocolIndex : serviceIndex)
+    {
+        tableSource << "    {";
+        for (size_t portNumber = 0; portNumber < SERVICE_PORT_COUNT; portNumber++)
+        {
+            tableSource << (portNumber % BLOB_LINE_BYTES == 0 ? "\n        " : " ") << protocolIndex[portNumber] << ",";
+        }
+        tableSource << "\n    },\n";
+    }
+    tableSource << "};\n";
+
+    std::ofstream tableFile(argv[2], std::ios::binary);
+    tableFile << tableSource.str();
+    return tableFile.good() ? 0 : 1;
+}
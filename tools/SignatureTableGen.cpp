@@ -0,0 +1,106 @@
+//
+// NetMap - C++ Network Scanner
+// ---------------------------
+// SignatureTableGen:
+// Build time tool that checks res/service-signatures and embeds it in the scanner.
+// ---------------------------
+//
+//GPLV2.0 License
+//
+//Copyright(c)[2024][Joseph  Frary]
+//
+//This program is free software; you can redistribute it and /or modify
+//it under the terms of the GNU General Public License as published by
+//the Free Software Foundation; either version 2 of the License, or
+//(at your option) any later version.
+//
+//This program is distributed in the hope that it will be useful,
+//but WITHOUT ANY WARRANTY; without even the implied warranty of
+//MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.See the
+//GNU General Public License for more details.
+//
+//You should have received a copy of the GNU General Public License along
+//with this program; if not, see < https://www.gnu.org/licenses/>.
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// bytes per line of the generated array
+constexpr size_t BLOB_LINE_BYTES = 32;
+
+// the fields of a line, runs of tabs count as one
+static std::vector<std::string> splitFields(const std::string& fileLine)
+{
+    std::vector<std::string> lineFields;
+    std::istringstream lineStream(fileLine);
+    std::string lineField;
+    while (std::getline(lineStream, lineField, '\t'))
+    {
+        if (!lineField.empty())
+        {
+            lineFields.push_back(lineField);
+        }
+    }
+    return lineFields;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: SignatureTableGen <service-signatures> <output>" << std::endl;
+        return 1;
+    }
+    std::ifstream signatureFile(argv[1], std::ios::binary);
+    if (!signatureFile.is_open())
+    {
+        std::cerr << "Failed to open " << argv[1] << std::endl;
+        return 1;
+    }
+    std::ostringstream signatureStream;
+    signatureStream << signatureFile.rdbuf();
+    std::string signatureText = signatureStream.str();
+
+    // only the shape of each line is checked here, patterns are compiled and checked in full when the scanner starts
+    std::istringstream lineStream(signatureText);
+    std::string fileLine;
+    size_t lineNumber = 0;
+    while (std::getline(lineStream, fileLine))
+    {
+        lineNumber++;
+        if (!fileLine.empty() && fileLine.back() == '\r')
+        {
+            fileLine.pop_back();
+        }
+        if (fileLine.empty() || fileLine[0] == '#')
+        {
+            continue;
+        }
+        std::vector<std::string> lineFields = splitFields(fileLine);
+        bool validLine = ((lineFields[0] == "probe" || lineFields[0] == "udpprobe") && lineFields.size() == 4)
+            || ((lineFields[0] == "match" || lineFields[0] == "matchi") && lineFields.size() >= 3 && lineFields.size() <= 4);
+        if (!validLine)
+        {
+            std::cerr << argv[1] << ":" << lineNumber << ": expected probe or udpprobe name payload ports, or match service pattern [product]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::ostringstream tableSource;
+    tableSource << "// Generated from res/service-signatures by SignatureTableGen at build time, do not edit.\n";
+    tableSource << "// Included once by SignatureDatabase.cpp.\n\n";
+    tableSource << "constexpr char SIGNATURE_TEXT[] = {";
+    for (size_t textIndex = 0; textIndex < signatureText.size(); textIndex++)
+    {
+        tableSource << (textIndex % BLOB_LINE_BYTES == 0 ? "\n    " : " ") << (int)(signed char)signatureText[textIndex] << ",";
+    }
+    // terminated, so the array is valid even for an empty file
+    tableSource << "\n    0\n};\n";
+
+    std::ofstream tableFile(argv[2], std::ios::binary);
+    tableFile << tableSource.str();
+    return tableFile.good() ? 0 : 1;
+}